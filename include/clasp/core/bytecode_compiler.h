@@ -487,6 +487,10 @@ public:
   void emit_mv_call() const;
   void emit_special_bind(Symbol_sp sym) const;
   void emit_unbind(size_t count) const;
+  void emit_return() const;
+
+private:
+  bool last_op_p(uint8_t opcode, size_t size) const;
 };
 
 FORWARD(Annotation);
@@ -544,7 +548,11 @@ class Label_O : public Annotation_O {
   LISP_CLASS(comp, CompPkg, Label_O, "Label", Annotation_O);
 
 public:
-  Label_O() : Annotation_O() {}
+  // True if some fixup refers to this label, e.g. it's a jump target.
+  bool _jump_target_p;
+
+public:
+  Label_O() : Annotation_O(), _jump_target_p(false) {}
   CL_LISPIFY_NAME(Label/make)
   CL_DEF_CLASS_METHOD
   static Label_sp make() { return gctools::GC<Label_O>::allocate<gctools::RuntimeStage>(); }
@@ -599,7 +607,7 @@ public:
 
 public:
   LabelFixup_O() : Fixup_O() {}
-  LabelFixup_O(Label_sp label, size_t initial_size) : Fixup_O(initial_size), _label(label) {}
+  LabelFixup_O(Label_sp label, size_t initial_size) : Fixup_O(initial_size), _label(label) { label->_jump_target_p = true; }
 
 public:
   CL_DEFMETHOD Label_sp label() { return this->_label; }
@@ -984,6 +992,11 @@ public:
   size_t _extra;
   // The index of this cfunction in the containing module's cfunction vector.
   size_t _index;
+  // Where the last instruction emitted by Context::assembleN starts, and
+  // how many annotations had been emitted at that point. Used to fuse that
+  // instruction with the next one into a superinstruction.
+  size_t _last_op_position;
+  size_t _last_op_annotations;
   // The runtime function, used during link.
   BytecodeSimpleFun_sp _info;
   // Stuff for the function description.
@@ -1000,6 +1013,8 @@ public:
         _annotations(ComplexVector_T_O::make(0, nil<T_O>(), clasp_make_fixnum(0))),
         _debug_info(ComplexVector_T_O::make(0, nil<T_O>(), clasp_make_fixnum(0))),
         _closed(ComplexVector_T_O::make(0, nil<T_O>(), clasp_make_fixnum(0))), _entry_point(Label_O::make()),
+        // nothing to fuse with yet
+        _last_op_position(~(size_t)0), _last_op_annotations(0),
         // not sure this has to be initialized, but just in case
         _info(unbound<BytecodeSimpleFun_O>()), _name(name), _doc(doc), _lambda_list(lambda_list),
         _source_pos_info(source_pos_info) {}
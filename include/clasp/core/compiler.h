@@ -49,6 +49,14 @@ void initialize_compiler_primitives(LispPtr lisp);
 
 void core__jit_register_symbol(const std::string& name, size_t size, void* address);
 
+struct JITLogSymbol {
+  std::string _Name;
+  size_t _Size;
+  void* _Address;
+};
+/*! Write the perf map lines for all of SYMBOLS with one write. */
+void jit_register_symbols(const std::vector<JITLogSymbol>& symbols);
+
 }; // namespace core
 
 namespace core {
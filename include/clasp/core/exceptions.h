@@ -203,8 +203,9 @@ struct SaveLispAndDie {
   bool   _Exit;  // Set to true unless debugging
   ForwardingEnum _ForwardingKind;
   bool           _TestMemory;
-  SaveLispAndDie(const std::string& filename, bool executable, const std::string& libDir, bool ep=true, ForwardingEnum fk=noStomp, bool tm=true)
-      : _FileName(filename), _Executable(executable), _LibDir(libDir), _Exit(ep), _ForwardingKind(fk), _TestMemory(tm) {};
+  bool           _Compress;
+  SaveLispAndDie(const std::string& filename, bool executable, const std::string& libDir, bool ep=true, ForwardingEnum fk=noStomp, bool tm=true, bool compress=false)
+      : _FileName(filename), _Executable(executable), _LibDir(libDir), _Exit(ep), _ForwardingKind(fk), _TestMemory(tm), _Compress(compress) {};
 };
 
 /*! To exit the program throw this exception
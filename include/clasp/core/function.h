@@ -359,11 +359,10 @@ public:
   // Size of this function in bytes - used for debugging
   unsigned int _BytecodeSize;
   BytecodeTrampolineFunction _Trampoline;
-  // How many times this function has been called.
-  // Tracked to get data about what functions should be optimized.
-  // uint16 is "small" so this will roll over eventually, but we
-  // will probably compile it before that point.
-  std::atomic<uint16_t> _CallCount = 0;
+  // How many times this function has been called, plus how many
+  // backward jumps (loop iterations) it has taken. Tracked to decide
+  // when to hand the function to the autocompiler; see bytecode_call.
+  std::atomic<uint32_t> _CallCount = 0;
 
 public:
   // Accessors
@@ -387,11 +386,27 @@ public:
   // Used for bytecode debug info; see function.cc
   T_sp start() const;
   T_sp end() const;
+  // The top bit of _CallCount says the function has been handed to the
+  // autocompiler; the rest is the count, which keeps going while the
+  // function waits in the queue so the autocompiler can pick the hottest.
+  // It saturates at CallCountLimit, far enough below the queued bit that
+  // racing increments cannot carry into it.
+  static constexpr uint32_t AutocompileQueued = 0x80000000;
+  static constexpr uint32_t CallCountLimit = 0x40000000;
   CL_LISPIFY_NAME(BytecodeSimpleFun/call-count)
-  CL_DEFMETHOD Fixnum callCount() const { return this->_CallCount.load(std::memory_order_relaxed); }
-  inline void countCall() {
+  CL_DEFMETHOD Fixnum callCount() const { return this->_CallCount.load(std::memory_order_relaxed) & ~AutocompileQueued; }
+  // Both return the new count, including the queued bit.
+  inline uint32_t countCall() {
+    uint32_t count = this->_CallCount.load(std::memory_order_relaxed);
+    if ((count & ~AutocompileQueued) >= CallCountLimit)
+      return count;
     // We use this instead of ++ to get a weak memory ordering.
-    this->_CallCount.fetch_add(1, std::memory_order_relaxed);
+    return this->_CallCount.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+  inline uint32_t countBackEdge() { return this->countCall(); }
+  // Set the queued bit. Return true if this call was the one to set it.
+  inline bool markAutocompileQueued() {
+    return !(this->_CallCount.fetch_or(AutocompileQueued, std::memory_order_relaxed) & AutocompileQueued);
   }
   // Used in loadltv.cc since functions may be named after they are made.
   void set_trampoline(Pointer_sp trampoline);
@@ -504,10 +519,14 @@ class FunctionCell_O : public Function_O {
   LISP_CLASS(core, CorePkg, FunctionCell_O, "FunctionCell", Function_O);
 
 public:
-  FunctionCell_O(SimpleFun_sp ep, Function_sp function) : Base(ep), _Function(function) {}
+  FunctionCell_O(SimpleFun_sp ep, Function_sp function) : Base(ep), _Function(function), _CallCache(nil<T_O>()) {}
 
 public:
   std::atomic<Function_sp> _Function;
+  // Inline cache for calls from bytecode: the bytecode simple fun the
+  // function was last seen to run, if it takes a fixed number of
+  // arguments, or NIL. See vm_apply in bytecode.cc.
+  std::atomic<T_sp> _CallCache;
 
 public:
   static FunctionCell_sp make(T_sp name, Function_sp initial);
@@ -518,7 +537,10 @@ public:
     // but in practice it's probably irrelevant what we do?
     return this->_Function.load(std::memory_order_relaxed);
   }
-  void real_function_set(Function_sp fun) { this->_Function.store(fun, std::memory_order_relaxed); }
+  void real_function_set(Function_sp fun) {
+    this->_Function.store(fun, std::memory_order_relaxed);
+    this->_CallCache.store(nil<T_O>(), std::memory_order_relaxed);
+  }
   static SimpleFun_sp cachedUnboundSimpleFun(T_sp name);
   void fmakunbound(T_sp name);
   bool fboundp() const;
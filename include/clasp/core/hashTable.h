@@ -39,6 +39,16 @@ namespace core {
 double maybeFixRehashThreshold(double rt);
 #define DEFAULT_REHASH_THRESHOLD 0.7
 
+// Entries of HashTable_O::_Fragments. Full slots hold a seven bit hash
+// fragment, so the high bit marks the empty and deleted slots.
+#define HT_FRAGMENT_EMPTY 0x80
+#define HT_FRAGMENT_DELETED 0xFE
+
+// Tables with at least this many slots grow incrementally, see _OldTable.
+#define HT_INCREMENTAL_REHASH_MIN_SIZE 65536
+// The least number of _OldTable slots moved by each insertion of a new key.
+#define HT_INCREMENTAL_REHASH_STEP 64
+
 T_sp cl__make_hash_table(T_sp test, Fixnum_sp size, Number_sp rehash_size, Real_sp orehash_threshold,
                          Symbol_sp weakness = nil<T_O>(), T_sp debug = nil<T_O>(), T_sp thread_safe = nil<T_O>(),
                          T_sp hashf = nil<T_O>());
@@ -72,7 +82,12 @@ class HashTable_O : public HashTableBase_O {
 #ifdef DEBUG_REHASH_COUNT
         _HashTableId(next_hash_table_id()), _RehashCount(0), _InitialSize(0),
 #endif
-        _RehashSize(nil<Number_O>()), _RehashThreshold(maybeFixRehashThreshold(0.7)), _HashTableCount(0)
+        _RehashSize(nil<Number_O>()), _RehashThreshold(maybeFixRehashThreshold(0.7)), _Fragments(nil<SimpleVector_byte8_t_O>()),
+        _OldFragments(nil<SimpleVector_byte8_t_O>()), _OldTableIndex(0), _HashTableCount(0)
+#ifdef CLASP_THREADS
+        ,
+        _WriteVersion(0)
+#endif
 #ifdef DEBUG_HASH_TABLE_DEBUG
         ,
         _Debug(false), _History(nil<T_O>())
@@ -96,6 +111,15 @@ public: // instance variables here
   Number_sp _RehashSize;
   double _RehashThreshold;
   gctools::Vec0<KeyValuePair> _Table;
+  /*! One byte per _Table entry when useFragments() - see HT_FRAGMENT_EMPTY.
+      Probes compare sixteen of these at a time and only call keyTest on matches. */
+  SimpleVector_byte8_t_sp _Fragments;
+  /*! While a large table grows incrementally these hold the previous _Table and
+      _Fragments. Entries below _OldTableIndex have been moved into _Table, and every
+      insertion of a new key moves a few more. _HashTableCount counts both tables. */
+  gctools::Vec0<KeyValuePair> _OldTable;
+  SimpleVector_byte8_t_sp _OldFragments;
+  size_t _OldTableIndex;
   size_t _HashTableCount;
 #ifdef DEBUG_HASH_TABLE_DEBUG
   bool _Debug;
@@ -103,6 +127,9 @@ public: // instance variables here
 #endif
 #ifdef CLASP_THREADS
   mutable mp::SharedMutex_sp _Mutex;
+  /*! Odd while a writer holding the write lock is changing _Table, even otherwise.
+      Readers of thread-safe tables probe without the lock and use this to validate. */
+  mutable std::atomic<size_t> _WriteVersion;
 #endif
 public:
   static HashTable_sp create(T_sp test); // set everything up with defaults
@@ -122,6 +149,12 @@ public:
 private:
   void setup(uint sz, Number_sp rehashSize, double rehashThreshold);
   uint resizeEmptyTable_no_lock(size_t sz);
+  size_t nextTableSize_no_lock(bool expandTable) const;
+  void storeNewEntry_no_lock(T_sp key, T_sp value, cl_index index, uint8_t fragment);
+  void startIncrementalRehash_no_lock();
+  void incrementalRehashStep_no_lock(size_t slots);
+  void finishIncrementalRehash_no_lock() { this->incrementalRehashStep_no_lock(this->_OldTable.size()); };
+  void dropOldTable_no_lock();
   uint calculateHashTableCount() const;
 
 public:
@@ -158,9 +191,29 @@ public: // Functions here
 
   /*! I'm not sure I need this and tableRef */
   List_sp bucketsFind_no_lock(T_sp key) const;
+  /*! Tables whose keyTest is expensive keep hash fragments in _Fragments */
+  virtual bool useFragments() const { return false; };
+  /*! The fragment of KEY's hash stored in _Fragments - HG must have hashed KEY */
+  static uint8_t hashFragment(const HashGenerator& hg) { return (uint8_t)((hg.rawhash() >> 48) & 0x7f); };
+  void setFragment_no_lock(size_t index, uint8_t fragment) {
+    if (this->_Fragments.notnilp())
+      (*this->_Fragments)[index] = fragment;
+  };
+  /*! Search the TABLESIZE entries at TABLE for KEY starting at INDEX.
+      TABLE and FRAGMENTS (which may be NULL) may be a snapshot of _Table
+      and _Fragments taken by an optimistic reader. */
+  virtual KeyValuePair* searchContents(KeyValuePair* table, const uint8_t* fragments, size_t tableSize, T_sp key,
+                                       cl_index index, uint8_t fragment) const;
+  KeyValuePair* searchFragments(KeyValuePair* table, const uint8_t* fragments, size_t tableSize, T_sp key, cl_index index,
+                                uint8_t fragment) const;
   /*! I'm not sure I need this and bucketsFind */
-  virtual KeyValuePair* searchTable_no_read_lock(T_sp key, cl_index index);
-  KeyValuePair* tableRef_no_read_lock(T_sp key, cl_index index);
+  KeyValuePair* searchTable_no_read_lock(T_sp key, cl_index index, uint8_t fragment) {
+    return this->searchContents(&this->_Table[0], this->_Fragments.notnilp() ? this->_Fragments->begin() : nullptr,
+                                this->_Table.size(), key, index, fragment);
+  }
+  KeyValuePair* tableRef_no_read_lock(T_sp key, cl_index index, uint8_t fragment);
+  /*! Search the not yet moved entries of an incremental rehash for KEY, which HG has hashed */
+  KeyValuePair* searchOldTable_no_read_lock(T_sp key, const HashGenerator& hg, uint8_t fragment);
   //    List_sp findAssoc_no_lock(gc::Fixnum index, T_sp searchKey) const;
 
   T_sp hash_table_average_search_length();
@@ -172,6 +225,11 @@ public: // Functions here
   KeyValuePair* find(T_sp key);
 
   T_mv gethash(T_sp key, T_sp defaultValue = nil<T_O>()) override;
+#ifdef CLASP_THREADS
+  /*! Look up KEY without taking the read lock. Return false if writers kept
+      getting in the way, in which case the caller must fall back to the lock. */
+  bool gethash_optimistic(T_sp key, T_sp& value, bool& foundp) const;
+#endif
   gc::Fixnum hashIndex(T_sp key) const;
 
   T_sp hash_table_setf_gethash(T_sp key, T_sp value) override;
@@ -49,6 +49,7 @@ public:
 public: // Functions here
   virtual T_sp hashTableTest() const { return comparator; };
 
+  virtual bool useFragments() const { return true; };
   bool keyTest(T_sp entryKey, T_sp searchKey) const;
 
   gc::Fixnum sxhashKey(T_sp key, gc::Fixnum bound, HashGenerator& hg) const;
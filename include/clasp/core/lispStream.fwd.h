@@ -38,6 +38,7 @@ FORWARD(SynonymStream);
 FORWARD(TwoWayStream);
 FORWARD(FileStream);
 FORWARD(PosixFileStream);
+FORWARD(MmapFileStream);
 FORWARD(CFileStream);
 #ifdef ECL_WINSOCK
 FORWARD(WinsockStream);
@@ -173,7 +173,8 @@ typedef enum {
   CLASP_STREAM_LITTLE_ENDIAN = 128,
   CLASP_STREAM_C_STREAM = 256,
   CLASP_STREAM_MIGHT_SEEK = 512,
-  CLASP_STREAM_CLOSE_COMPONENTS = 1024
+  CLASP_STREAM_CLOSE_COMPONENTS = 1024,
+  CLASP_STREAM_MMAP = 2048
 } StreamFlagsEnum;
 
 typedef enum : claspCharacter {
@@ -301,7 +302,7 @@ String_sp cl__write_string(String_sp str, T_sp stream, int istart = 0, T_sp end
 T_sp cl__open(T_sp filename, StreamDirection direction = StreamDirection::input, T_sp element_type = cl::_sym_base_char,
               StreamIfExists if_exists = StreamIfExists::nil, bool iesp = false,
               StreamIfDoesNotExist if_does_not_exist = StreamIfDoesNotExist::nil, bool idnesp = false,
-              T_sp external_format = kw::_sym_default, T_sp cstream = lisp_true());
+              T_sp external_format = kw::_sym_default, T_sp cstream = lisp_true(), T_sp mmap = nil<T_O>());
 T_mv cl__read_line(T_sp sin, T_sp eof_error_p = cl::_sym_T_O, T_sp eof_value = nil<T_O>(), T_sp recursive_p = nil<T_O>());
 
 // Clasp Stream Utility Functions
@@ -908,6 +909,7 @@ public: // Functions here
 
   claspCharacter decode(unsigned char** buffer, unsigned char* buffer_end);
   int encode(unsigned char* buffer, claspCharacter c);
+  bool ascii_compatible_p() const;
   claspCharacter decode_char_from_buffer(unsigned char* buffer, unsigned char** buffer_pos, unsigned char** buffer_end,
                                          bool seekable, cl_index min_needed_bytes);
 
@@ -932,6 +934,7 @@ public: // Functions here
   claspCharacter read_char_no_cursor();
   claspCharacter read_char() override;
   void unread_char(claspCharacter c) override;
+  T_mv read_line() override;
 
   claspCharacter write_char(claspCharacter c) override;
 
@@ -985,6 +988,40 @@ public:
   int file_descriptor(StreamDirection direction) const override;
 };
 
+/* An input file stream that maps the whole file into memory. Reads and
+ * repositioning work directly on the mapping instead of calling read and
+ * lseek. */
+class MmapFileStream_O : public FileStream_O {
+  LISP_CLASS(core, CorePkg, MmapFileStream_O, "mmap-file-stream", FileStream_O);
+
+public:
+  int _file_descriptor;
+  unsigned char* _map_base;
+  size_t _map_size;
+  size_t _map_position;
+
+public:
+  MmapFileStream_O() : _file_descriptor(-1), _map_base(NULL), _map_size(0), _map_position(0){};
+
+  static MmapFileStream_sp make(T_sp fname, int fd, StreamDirection smm, gctools::Fixnum byte_size = 8,
+                                int flags = CLASP_STREAM_DEFAULT_FORMAT, T_sp external_format = nil<T_O>());
+
+  virtual bool has_file_position() const override;
+
+  T_sp close(T_sp abort) override;
+
+  cl_index read_byte8(unsigned char* c, cl_index n) override;
+
+  ListenResult listen() override;
+  void clear_input() override;
+
+  T_sp length() override;
+  T_sp position() override;
+  T_sp set_position(T_sp pos) override;
+
+  int file_descriptor(StreamDirection direction) const override;
+};
+
 class CFileStream_O : public FileStream_O {
   LISP_CLASS(core, CorePkg, CFileStream_O, "c-file-stream", FileStream_O);
 
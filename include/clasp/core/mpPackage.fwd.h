@@ -28,6 +28,9 @@ THE SOFTWARE.
 
 #include <sys/time.h>
 #include <cassert>
+#include <cmath>
+#include <climits>
+#include <chrono>
 #include <atomic>
 #include <thread>
 #include <array>
@@ -37,6 +40,112 @@ THE SOFTWARE.
 PACKAGE_USE("COMMON-LISP");
 NAMESPACE_PACKAGE_ASSOCIATION(mp, MpPkg, "MP")
 
+namespace mp {
+
+// Sleep while *WORD == EXPECTED, for at most TIMEOUT seconds if that is
+// nonnegative. May return early, spuriously or on a signal.
+void futex_wait(std::atomic<uint32_t>* word, uint32_t expected, double timeout);
+void futex_wake(std::atomic<uint32_t>* word, int nwaiters);
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield" ::: "memory");
+#endif
+}
+
+/*! A lock for short critical sections. A waiter spins with exponential
+    backoff for a few microseconds and then parks on a futex, so an
+    uncontended lock costs one atomic and a blocked thread does not burn
+    a core. Not recursive. */
+struct AdaptiveLock {
+  // 1+2+...+512 pauses before parking.
+  static constexpr int SpinRounds = 10;
+  // 0 free, 1 held, 2 held and there may be parked waiters.
+  std::atomic<uint32_t> _State;
+  AdaptiveLock() : _State(0){};
+  bool try_lock() {
+    uint32_t free = 0;
+    return this->_State.compare_exchange_strong(free, 1, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+  void lock() {
+    if (UNLIKELY(!this->try_lock()))
+      this->lock_slow();
+  }
+  void unlock() {
+    if (UNLIKELY(this->_State.exchange(0, std::memory_order_release) == 2))
+      futex_wake(&this->_State, 1);
+  }
+  void lock_slow();
+};
+
+struct AdaptiveLockGuard {
+  AdaptiveLock& _Lock;
+  AdaptiveLockGuard(AdaptiveLock& l) : _Lock(l) { _Lock.lock(); };
+  ~AdaptiveLockGuard() { _Lock.unlock(); }
+};
+
+#ifdef __linux__
+typedef AdaptiveLock MutexLock;
+#else
+/*! Elsewhere futex_wait can only be emulated, so mp::Mutex and
+    mp::ConditionVariable sleep on a pthread mutex and condition variable. */
+struct PthreadLock {
+  pthread_mutex_t _Mutex;
+  PthreadLock() { pthread_mutex_init(&this->_Mutex, NULL); };
+  ~PthreadLock() { pthread_mutex_destroy(&this->_Mutex); };
+  bool try_lock() { return pthread_mutex_trylock(&this->_Mutex) == 0; }
+  void lock() { pthread_mutex_lock(&this->_Mutex); }
+  void unlock() { pthread_mutex_unlock(&this->_Mutex); }
+};
+typedef PthreadLock MutexLock;
+#endif
+
+/*! Lets threads wait for a condition that other threads make true and
+    then announce with notify_all: waiters spin briefly, then park.
+    A waiter registers in _Parked before its last look at the condition
+    and the notifier looks at _Parked after making the condition true,
+    with a fence on each side, so either the waiter sees the condition or
+    the notifier sees the waiter and bumps _Epoch, which makes the
+    futex_wait return. No wakeup is lost, so parking needs no timeout. */
+struct ParkingSpot {
+  std::atomic<uint32_t> _Epoch;
+  std::atomic<uint32_t> _Parked;
+  ParkingSpot() : _Epoch(0), _Parked(0){};
+  // READY is called until it returns true, so it may also try to take
+  // whatever it is waiting for. Return true if it was not ready at once.
+  template <typename Ready> bool wait_until(Ready ready) {
+    int round = 0;
+    for (; !ready(); ++round) {
+      if (round < AdaptiveLock::SpinRounds) {
+        for (int i = 0; i < (1 << round); ++i)
+          cpu_relax();
+        continue;
+      }
+      this->_Parked.fetch_add(1, std::memory_order_seq_cst);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      uint32_t epoch = this->_Epoch.load(std::memory_order_seq_cst);
+      bool done = ready();
+      if (!done)
+        futex_wait(&this->_Epoch, epoch, -1.0);
+      this->_Parked.fetch_sub(1, std::memory_order_relaxed);
+      if (done)
+        break;
+    }
+    return round != 0;
+  }
+  void notify_all() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (UNLIKELY(this->_Parked.load(std::memory_order_seq_cst))) {
+      this->_Epoch.fetch_add(1, std::memory_order_seq_cst);
+      futex_wake(&this->_Epoch, INT_MAX);
+    }
+  }
+};
+
+}; // namespace mp
+
 namespace sf {
 
 //
@@ -47,6 +156,9 @@ namespace sf {
 // contention free shared mutex (same-lock-type is recursive for X->X, X->S or S->S locks), but (S->X - is UB)
 template <unsigned contention_free_count = 36, bool shared_flag = false> class contention_free_shared_mutex {
   std::atomic<bool> want_x_lock;
+  // Threads that find the lock held spin briefly and then park here
+  // (clasp change; this used to spin without bound).
+  mp::ParkingSpot parking_spot;
   // struct cont_free_flag_t { alignas(std::hardware_destructive_interference_size) std::atomic<int> value; cont_free_flag_t() {
   // value = 0; } }; // C++17
   struct cont_free_flag_t {
@@ -174,7 +286,9 @@ public:
     return cur_index;
   }
 
-  void lock_shared() {
+  // clasp change: lock_shared and lock return true if they had to wait.
+  bool lock_shared() {
+    bool waited = false;
     int const register_index = register_thread();
 
     if (register_index >= 0) {
@@ -186,10 +300,10 @@ public:
       else {
         shared_locks_array[register_index].value.store(recursion_depth + 1, std::memory_order_seq_cst); // if first -> sequential
         while (want_x_lock.load(std::memory_order_seq_cst)) {
+          waited = true;
           shared_locks_array[register_index].value.store(recursion_depth, std::memory_order_seq_cst);
-          for (size_t i = 0; want_x_lock.load(std::memory_order_seq_cst); ++i)
-            if (i % 100000 == 0)
-              std::this_thread::yield();
+          parking_spot.notify_all();
+          parking_spot.wait_until([this] { return !want_x_lock.load(std::memory_order_seq_cst); });
           shared_locks_array[register_index].value.store(recursion_depth + 1, std::memory_order_seq_cst);
         }
       }
@@ -197,14 +311,15 @@ public:
       // (shared_locks_array[register_index] > 2)                                 // recursive shared lock
     } else {
       if (owner_thread_id.load(std::memory_order_acquire) != get_fast_this_thread_id()) {
-        size_t i = 0;
-        for (bool flag = false; !want_x_lock.compare_exchange_weak(flag, true, std::memory_order_seq_cst); flag = false)
-          if (++i % 100000 == 0)
-            std::this_thread::yield();
+        waited = parking_spot.wait_until([this] {
+          bool flag = false;
+          return want_x_lock.compare_exchange_weak(flag, true, std::memory_order_seq_cst);
+        });
         owner_thread_id.store(get_fast_this_thread_id(), std::memory_order_release);
       }
       ++recursive_xlock_count;
     }
+    return waited;
   }
 
   void unlock_shared() {
@@ -214,42 +329,47 @@ public:
       int const recursion_depth = shared_locks_array[register_index].value.load(std::memory_order_acquire);
       assert(recursion_depth > 1);
 
-      shared_locks_array[register_index].value.store(recursion_depth - 1, std::memory_order_release);
+      shared_locks_array[register_index].value.store(recursion_depth - 1, std::memory_order_seq_cst);
+      // A writer may be waiting for the readers to leave.
+      parking_spot.notify_all();
     } else {
       if (--recursive_xlock_count == 0) {
         owner_thread_id.store(decltype(owner_thread_id)(), std::memory_order_release);
-        want_x_lock.store(false, std::memory_order_release);
+        want_x_lock.store(false, std::memory_order_seq_cst);
+        parking_spot.notify_all();
       }
     }
   }
 
-  void lock() {
+  bool lock() {
+    bool waited = false;
     // forbidden upgrade S-lock to X-lock - this is an excellent opportunity to get deadlock
     int const register_index = get_or_set_index();
     if (register_index >= 0)
       assert(shared_locks_array[register_index].value.load(std::memory_order_acquire) == 1);
 
     if (owner_thread_id.load(std::memory_order_acquire) != get_fast_this_thread_id()) {
-      size_t i = 0;
-      for (bool flag = false; !want_x_lock.compare_exchange_weak(flag, true, std::memory_order_seq_cst); flag = false)
-        if (++i % 1000000 == 0)
-          std::this_thread::yield();
+      waited = parking_spot.wait_until([this] {
+        bool flag = false;
+        return want_x_lock.compare_exchange_weak(flag, true, std::memory_order_seq_cst);
+      });
 
       owner_thread_id.store(get_fast_this_thread_id(), std::memory_order_release);
 
       for (auto& i : shared_locks_array)
-        while (i.value.load(std::memory_order_seq_cst) > 1)
-          ;
+        waited |= parking_spot.wait_until([&i] { return i.value.load(std::memory_order_seq_cst) <= 1; });
     }
 
     ++recursive_xlock_count;
+    return waited;
   }
 
   void unlock() {
     assert(recursive_xlock_count > 0);
     if (--recursive_xlock_count == 0) {
       owner_thread_id.store(decltype(owner_thread_id)(), std::memory_order_release);
-      want_x_lock.store(false, std::memory_order_release);
+      want_x_lock.store(false, std::memory_order_seq_cst);
+      parking_spot.notify_all();
     }
   }
 };
@@ -275,23 +395,6 @@ extern int clasp_musleep(double dsec, bool alertable);
 }
 
 namespace mp {
-struct SpinLock {
-public:
-  void lock() {
-    while (lck.test_and_set(std::memory_order_acquire)) {
-    }
-  }
-
-  void unlock() { lck.clear(std::memory_order_release); }
-
-private:
-  std::atomic_flag lck;
-};
-struct SafeSpinLock {
-  SpinLock& _SpinLock;
-  SafeSpinLock(SpinLock& l) : _SpinLock(l) { _SpinLock.lock(); };
-  ~SafeSpinLock() { _SpinLock.unlock(); }
-};
 
 extern "C" void mutex_lock_enter(char* nameword);
 extern "C" void mutex_lock_return(char* nameword);
@@ -331,46 +434,99 @@ void debug_mutex_unlock(Mutex* m);
 #define JITGDBIF_NAMEWORD 0x004942444754494a
 #define MPSMESSG_NAMEWORD 0x005353454d53504d // MPSMESSG
 
+/*! Lock contention profiling, see lockProfiler.cc. While it is enabled,
+    acquisitions of mp::Mutex and mp::SharedMutex are counted and the time
+    spent waiting for them is recorded per lock. */
+extern std::atomic<bool> global_lock_profiling;
+inline bool lock_profiling_p() { return global_lock_profiling.load(std::memory_order_relaxed); }
+uint64_t lock_profile_now();
+void lock_profile_record(const void* lock, uint64_t nameword, uint64_t wait_ns, bool contended, bool acquired);
+
+/*! The mutex behind MP:MAKE-LOCK and the internal locks. It is a
+    MutexLock plus recursion: a recursive mutex remembers the thread
+    holding it and how many more times that thread has taken it. */
 struct Mutex {
   uint64_t _NameWord;
-  pthread_mutex_t _Mutex;
+  MutexLock _Lock;
+  std::atomic<uintptr_t> _Holder; // only maintained for recursive mutexes
+  uint32_t _Depth;
   gctools::Fixnum _Counter;
   bool _Recursive;
-  Mutex(uint64_t nameword, bool recursive = false) : _NameWord(nameword), _Counter(0), _Recursive(recursive) {
-    if (!recursive) {
-      pthread_mutex_init(&this->_Mutex, NULL);
-    } else {
-      pthread_mutexattr_t Attr;
-      pthread_mutexattr_init(&Attr);
-      pthread_mutexattr_settype(&Attr, PTHREAD_MUTEX_RECURSIVE);
-      pthread_mutex_init(&this->_Mutex, &Attr);
-      pthread_mutexattr_destroy(&Attr);
+  Mutex(uint64_t nameword, bool recursive = false)
+      : _NameWord(nameword), _Holder(0), _Depth(0), _Counter(0), _Recursive(recursive){};
+  Mutex() : Mutex(DEFAULT__NAMEWORD){};
+  // A copy is a fresh unlocked mutex with the same name and kind.
+  Mutex(const Mutex& other) : Mutex(other._NameWord, other._Recursive){};
+  static uintptr_t self() { return (uintptr_t)pthread_self(); }
+  bool reenter() {
+    if (this->_Recursive && this->_Holder.load(std::memory_order_relaxed) == self()) {
+      ++this->_Depth;
+      return true;
     }
-  };
-  Mutex() : _NameWord(DEFAULT__NAMEWORD), _Counter(0), _Recursive(false) { pthread_mutex_init(&this->_Mutex, NULL); };
+    return false;
+  }
+  void acquired() {
+    if (this->_Recursive)
+      this->_Holder.store(self(), std::memory_order_relaxed);
+  }
   bool lock(bool waitp = true) {
 #ifdef DEBUG_THREADS
     debug_mutex_lock(this);
 #endif
-    if (waitp) {
+    if (UNLIKELY(lock_profiling_p()))
+      return this->profiled_lock(waitp);
+    if (!this->reenter()) {
+      if (waitp) {
 #ifdef DEBUG_DTRACE_LOCK_PROBE
-      DtraceLockProbe _guard((char*)&this->_NameWord);
+        DtraceLockProbe _guard((char*)&this->_NameWord);
 #endif
-      bool result = (pthread_mutex_lock(&this->_Mutex) == 0);
-      ++this->_Counter;
-      return result;
+        this->_Lock.lock();
+      } else if (!this->_Lock.try_lock())
+        return false;
+      this->acquired();
     }
-    return pthread_mutex_trylock(&this->_Mutex) == 0;
+    if (waitp)
+      ++this->_Counter;
+    return true;
   };
+  bool profiled_lock(bool waitp);
   void unlock() {
 #ifdef DEBUG_THREADS
     debug_mutex_unlock(this);
 #endif
     --this->_Counter;
-    pthread_mutex_unlock(&this->_Mutex);
+    if (this->_Depth) {
+      --this->_Depth;
+      return;
+    }
+    this->release();
   };
+  // Give the lock up for a condition variable wait, however many times
+  // this thread has taken it, and take it back afterwards. release returns
+  // the recursion depth, which reacquire restores.
+  uint32_t release() {
+    uint32_t depth = this->disown();
+    this->_Lock.unlock();
+    return depth;
+  }
+  void reacquire(uint32_t depth) {
+    this->_Lock.lock();
+    this->own(depth);
+  }
+  // The bookkeeping half of release and reacquire, for waits that give
+  // up _Lock themselves.
+  uint32_t disown() {
+    uint32_t depth = this->_Depth;
+    this->_Depth = 0;
+    if (this->_Recursive)
+      this->_Holder.store(0, std::memory_order_relaxed);
+    return depth;
+  }
+  void own(uint32_t depth) {
+    this->acquired();
+    this->_Depth = depth;
+  }
   size_t counter() const { return this->_Counter; }
-  ~Mutex() { pthread_mutex_destroy(&this->_Mutex); };
 };
 
 #if 0
@@ -402,12 +558,31 @@ struct SharedMutex {
 };
 #else
 struct SharedMutex : public sf::contention_free_shared_mutex<> {
-  SharedMutex(){};
+  typedef sf::contention_free_shared_mutex<> Base;
+  SharedMutex() : _r(DEFAULT__NAMEWORD){};
   uint64_t _r;
   SharedMutex(uint64_t nameword) : _r(nameword){};
+  // Waiters spin briefly and then park; the base reports whether an
+  // acquisition had to wait at all, which is what counts as contended.
   // shared access
-  void shared_lock() { this->lock_shared(); }
+  void shared_lock() {
+    if (UNLIKELY(lock_profiling_p())) {
+      uint64_t start = lock_profile_now();
+      bool contended = this->lock_shared();
+      lock_profile_record(this, this->_r, contended ? lock_profile_now() - start : 0, contended, true);
+    } else
+      this->lock_shared();
+  }
   void shared_unlock() { this->unlock_shared(); }
+  // exclusive access
+  void lock() {
+    if (UNLIKELY(lock_profiling_p())) {
+      uint64_t start = lock_profile_now();
+      bool contended = this->Base::lock();
+      lock_profile_record(this, this->_r, contended ? lock_profile_now() - start : 0, contended, true);
+    } else
+      this->Base::lock();
+  }
 };
 #endif
 
@@ -424,21 +599,28 @@ public:
   bool mReadsBlocked;
   uint mMaxReaders;
   uint mReaders;
+  // Blocked readers and writers waiting for readers park here.
+  ParkingSpot mSpot;
 
 public:
   UpgradableSharedMutex(uint64_t nameword, uint maxReaders = 64, uint64_t writenameword = 0)
       : mReadMutex(nameword), mWriteMutex(writenameword ? writenameword : nameword), mReadsBlocked(false), mMaxReaders(maxReaders),
         mReaders(0){};
   void readLock() {
+    uint64_t blocked = 0;
     while (1) {
       mReadMutex._value.lock();
       if ((!mReadsBlocked) && (mReaders < mMaxReaders)) {
         mReaders++;
         mReadMutex._value.unlock();
+        if (UNLIKELY(blocked))
+          lock_profile_record(&mReadMutex._value, mReadMutex._value._NameWord, lock_profile_now() - blocked, true, false);
         return;
       }
       mReadMutex._value.unlock();
-      muSleep(0);
+      if (UNLIKELY(!blocked && lock_profiling_p()))
+        blocked = lock_profile_now();
+      mSpot.wait_until([this] { return this->readable(); });
     }
     assert(0);
   };
@@ -447,6 +629,7 @@ public:
     assert(mReaders);
     mReaders--;
     mReadMutex._value.unlock();
+    mSpot.notify_all();
   };
 
   /* Pass true for upgrade if you want to upgrade a read lock to a write lock.
@@ -475,15 +658,23 @@ public:
     mReadsBlocked = false;
     mReadMutex._value.unlock();
     mWriteMutex._value.unlock();
+    mSpot.notify_all();
   }
 
 public:
+  bool readable() {
+    mReadMutex._value.lock();
+    bool result = (!mReadsBlocked) && (mReaders < mMaxReaders);
+    mReadMutex._value.unlock();
+    return result;
+  }
   void waitReaders(uint numReaders) {
     // block new readers
     mReadMutex._value.lock();
     mReadsBlocked = true;
     mReadMutex._value.unlock();
     // wait for current readers to finish
+    uint64_t blocked = 0;
     while (1) {
       mReadMutex._value.lock();
       if (mReaders == numReaders) {
@@ -491,17 +682,73 @@ public:
         break;
       }
       mReadMutex._value.unlock();
-      muSleep(0);
+      if (UNLIKELY(!blocked && lock_profiling_p()))
+        blocked = lock_profile_now();
+      mSpot.wait_until([this, numReaders] {
+        mReadMutex._value.lock();
+        bool drained = (mReaders == numReaders);
+        mReadMutex._value.unlock();
+        return drained;
+      });
     }
+    if (UNLIKELY(blocked))
+      lock_profile_record(&mWriteMutex._value, mWriteMutex._value._NameWord, lock_profile_now() - blocked, true, false);
     assert(mReaders == numReaders);
   }
 };
 
+#ifdef __linux__
+/*! A condition variable on a futex: waiters sleep until the sequence
+    number they saw before releasing the mutex has changed. */
+struct ConditionVariable {
+  std::atomic<uint32_t> _Sequence;
+  ConditionVariable() : _Sequence(0){};
+  bool wait(Mutex& m) {
+    uint32_t seq = this->_Sequence.load(std::memory_order_relaxed);
+    uint32_t depth = m.release();
+    while (this->_Sequence.load(std::memory_order_acquire) == seq)
+      futex_wait(&this->_Sequence, seq, -1.0);
+    m.reacquire(depth);
+    return true;
+  }
+  // Return false if TIMEOUT seconds passed without a signal.
+  bool timed_wait(Mutex& m, double timeout) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(timeout);
+    uint32_t seq = this->_Sequence.load(std::memory_order_relaxed);
+    uint32_t depth = m.release();
+    bool signalled;
+    while (!(signalled = (this->_Sequence.load(std::memory_order_acquire) != seq))) {
+      double remaining = std::chrono::duration<double>(deadline - std::chrono::steady_clock::now()).count();
+      if (remaining <= 0.0)
+        break;
+      futex_wait(&this->_Sequence, seq, remaining);
+    }
+    m.reacquire(depth);
+    return signalled;
+  }
+  bool signal() {
+    this->_Sequence.fetch_add(1, std::memory_order_release);
+    futex_wake(&this->_Sequence, 1);
+    return true;
+  }
+  bool broadcast() {
+    this->_Sequence.fetch_add(1, std::memory_order_release);
+    futex_wake(&this->_Sequence, INT_MAX);
+    return true;
+  }
+};
+#else
 struct ConditionVariable {
   pthread_cond_t _ConditionVariable;
   ConditionVariable() { pthread_cond_init(&this->_ConditionVariable, NULL); };
   ~ConditionVariable() { pthread_cond_destroy(&this->_ConditionVariable); };
-  bool wait(Mutex& m) { return pthread_cond_wait(&this->_ConditionVariable, &m._Mutex) == 0; }
+  bool wait(Mutex& m) {
+    uint32_t depth = m.disown();
+    int rt = pthread_cond_wait(&this->_ConditionVariable, &m._Lock._Mutex);
+    m.own(depth);
+    return rt == 0;
+  }
+  // Return false if TIMEOUT seconds passed without a signal.
   bool timed_wait(Mutex& m, double timeout) {
     struct timespec timeToWait;
     struct timeval now;
@@ -509,20 +756,21 @@ struct ConditionVariable {
     double dtimeout_sec = floor(timeout);
     size_t timeout_sec = dtimeout_sec;
     size_t timeout_nsec = static_cast<size_t>((timeout - dtimeout_sec) * 1000000000.0);
-    timeToWait.tv_sec = now.tv_sec;
-    timeToWait.tv_nsec = (now.tv_usec * 1000UL);
-    timeToWait.tv_sec += timeout_sec;
-    timeToWait.tv_nsec += timeout_nsec;
-    if (timeToWait.tv_nsec > 1000000000) {
+    timeToWait.tv_sec = now.tv_sec + timeout_sec;
+    timeToWait.tv_nsec = (now.tv_usec * 1000UL) + timeout_nsec;
+    if (timeToWait.tv_nsec >= 1000000000) {
       timeToWait.tv_sec++;
       timeToWait.tv_nsec -= 1000000000;
     }
-    int rt = pthread_cond_timedwait(&this->_ConditionVariable, &m._Mutex, &timeToWait);
+    uint32_t depth = m.disown();
+    int rt = pthread_cond_timedwait(&this->_ConditionVariable, &m._Lock._Mutex, &timeToWait);
+    m.own(depth);
     return rt == 0;
   }
   bool signal() { return pthread_cond_signal(&this->_ConditionVariable) == 0; }
   bool broadcast() { return pthread_cond_broadcast(&this->_ConditionVariable) == 0; }
 };
+#endif
 
 #ifdef CLASP_THREADS
 template <typename T> struct RAIIReadLock {
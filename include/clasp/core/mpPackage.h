@@ -35,6 +35,9 @@ FORWARD(Mutex);
 FORWARD(SharedMutex);
 FORWARD(RecursiveMutex);
 FORWARD(ConditionVariable);
+FORWARD(ConcurrentQueue);
+FORWARD(Fiber);
+FORWARD(FiberScheduler);
 }; // namespace mp
 
 namespace mp {
@@ -58,15 +61,15 @@ template <typename T> struct RAIILock {
 #endif
 
 namespace mp {
-inline core::T_sp atomic_get_and_set_to_Nil(mp::SpinLock& spinlock, core::T_sp& slot) noexcept {
-  mp::SafeSpinLock l(spinlock);
+inline core::T_sp atomic_get_and_set_to_Nil(mp::AdaptiveLock& lock, core::T_sp& slot) noexcept {
+  mp::AdaptiveLockGuard l(lock);
   core::T_sp old = slot;
   slot = nil<core::T_O>();
   return old;
 }
-inline void atomic_push(mp::SpinLock& spinlock, core::T_sp& slot, core::T_sp object) {
+inline void atomic_push(mp::AdaptiveLock& lock, core::T_sp& slot, core::T_sp object) {
   core::Cons_sp cons = core::Cons_O::create(object, nil<core::T_O>());
-  mp::SafeSpinLock l(spinlock);
+  mp::AdaptiveLockGuard l(lock);
   core::T_sp car = slot;
   cons->rplacd(car);
   slot = cons;
@@ -101,14 +104,16 @@ class Process_O : public core::CxxObject_O {
 
 public:
   CL_LISPIFY_NAME("make_process");
-  CL_LAMBDA(name function &optional arguments special_bindings (stack-size 0));
+  CL_LAMBDA(name function &optional arguments special_bindings (stack-size 0) (vm-stack-size 0));
   CL_DOCSTRING("Make and return a new process object. The new process is inactive; it can be started with PROCESS-START.\n\nNAME "
                "is the name of the process for display purposes. FUNCTION is the function that the process should execute. "
                "ARGUMENTS is a list of arguments that will be passed to the function when the process is enabled; the default is "
                "NIL. SPECIAL-BINDINGS is an alist of (symbol . form): the forms will be evaluated in a null lexical environment, "
-               "and their values bound to the symbols (as if by PROGV) when the process is started.")
+               "and their values bound to the symbols (as if by PROGV) when the process is started. STACK-SIZE and VM-STACK-SIZE "
+               "are the sizes in bytes of the native stack and of the address range reserved for the bytecode VM stack; zero "
+               "means the default.")
   CL_DEF_CLASS_METHOD static Process_sp make_process(core::T_sp name, core::T_sp function, core::T_sp arguments,
-                                                     core::T_sp special_bindings, size_t stack_size) {
+                                                     core::T_sp special_bindings, size_t stack_size, size_t vm_stack_size) {
     core::List_sp passed_bindings = core::cl__reverse(special_bindings);
     core::List_sp all_bindings = core::lisp_copy_default_special_bindings();
     for (auto cur : passed_bindings) {
@@ -116,7 +121,7 @@ public:
     }
     if (stack_size == 0)
       stack_size = DEFAULT_THREAD_STACK_SIZE;
-    auto p = gctools::GC<Process_O>::allocate(name, function, arguments, all_bindings, stack_size);
+    auto p = gctools::GC<Process_O>::allocate(name, function, arguments, all_bindings, stack_size, vm_stack_size);
     return p;
   };
 
@@ -136,6 +141,7 @@ public:
   dont_expose<ConditionVariable> _SuspensionCV;
   //    dont_expose<ConditionVariable> _ExitBarrier;
   size_t _StackSize;
+  size_t _VMStackSize;
   dont_expose<pthread_t> _TheThread;
   // Need to match fields in the two GC's
 #if defined(USE_BOEHM) || defined(USE_MMTK)
@@ -147,11 +153,11 @@ public:
 #endif
 public:
   Process_O(core::T_sp name, core::T_sp function, core::List_sp arguments, core::List_sp initialSpecialBindings = nil<core::T_O>(),
-            size_t stack_size = 8 * 1024 * 1024)
+            size_t stack_size = 8 * 1024 * 1024, size_t vm_stack_size = 0)
       : _UniqueID(global_process_UniqueID++), _Parent(nil<core::T_O>()), _Name(name), _Function(function), _Arguments(arguments),
         _InitialSpecialBindings(initialSpecialBindings), _ReturnValuesList(nil<core::T_O>()), _Aborted(false),
         _AbortCondition(nil<core::T_O>()), _ThreadInfo(NULL), _Phase(Nascent), _SuspensionMutex(SUSPBARR_NAMEWORD),
-        _StackSize(stack_size) {
+        _StackSize(stack_size), _VMStackSize(vm_stack_size) {
     if (!function) {
       printf("%s:%d Trying to create a process and the function is NULL\n", __FILE__, __LINE__);
     }
@@ -325,5 +331,168 @@ public:
   CL_DEFMETHOD core::T_sp condition_variable_name() { return _Name; }
   string __repr__() const override;
 };
+}; // namespace mp
+
+template <> struct gctools::GCInfo<mp::ConcurrentQueue_O> {
+  static bool constexpr NeedsInitialization = false;
+  static bool constexpr NeedsFinalization = true;
+  static GCInfo_policy constexpr Policy = normal;
+};
+
+namespace mp {
+
+// A lock-free multi-producer/multi-consumer FIFO queue.
+// Unbounded queues are a Michael-Scott linked list of conses: _Head is a
+// dummy cons whose cdr is the first entry, and _Tail is at or just behind
+// the last cons. Since the GC owns the conses there is no ABA or
+// reclamation problem.
+// Bounded queues are Vyukov's array ring: each slot has a sequence number
+// saying whether it is ready to be written or read in the current lap,
+// so producers and consumers only contend on their own position counter.
+// Consumers that want to block sleep on _Epoch, which producers bump
+// after every push; see ConcurrentQueue_O::pop_wait.
+FORWARD(ConcurrentQueue);
+class ConcurrentQueue_O : public core::CxxObject_O {
+  LISP_CLASS(mp, MpPkg, ConcurrentQueue_O, "ConcurrentQueue", core::CxxObject_O);
+
+public:
+  CL_LISPIFY_NAME("make-concurrent-queue");
+  CL_LAMBDA(&key name capacity);
+  CL_DOCSTRING("Make and return a new lock-free queue that any number of threads may push to and pop from. If CAPACITY is "
+               "NIL the queue is unbounded; otherwise it is a ring of at least CAPACITY entries, rounded up to a power of two, "
+               "and pushes fail when it is full.")
+  CL_DEF_CLASS_METHOD static ConcurrentQueue_sp make_concurrent_queue(core::T_sp name, core::T_sp capacity);
+
+public:
+  core::T_sp _Name;
+  // Unbounded representation.
+  std::atomic<core::T_sp> _Head;
+  std::atomic<core::T_sp> _Tail;
+  // Bounded representation. _Slots is NIL for unbounded queues.
+  core::T_sp _Slots;
+  size_t _Mask;
+  std::atomic<size_t>* _Sequence;
+  std::atomic<size_t> _EnqueuePos;
+  std::atomic<size_t> _DequeuePos;
+  // For blocking pops.
+  std::atomic<uint32_t> _Epoch;
+  std::atomic<uint32_t> _Sleepers;
+
+public:
+  ConcurrentQueue_O(core::T_sp name, size_t capacity);
+  ~ConcurrentQueue_O();
+  bool boundedp() const { return this->_Slots.notnilp(); }
+  // Return false iff the queue is bounded and full.
+  bool push(core::T_sp item);
+  // Return false iff the queue was empty.
+  bool try_pop(core::T_sp& item);
+  // Wait up to TIMEOUT seconds (forever if negative) for an item.
+  bool pop_wait(core::T_sp& item, double timeout);
+  size_t count() const;
+  string __repr__() const override;
+  virtual void fixupInternalsForSnapshotSaveLoad(snapshotSaveLoad::Fixup* fixup);
+};
+
 void mp__interrupt_process(Process_sp process, core::T_sp func);
 }; // namespace mp
+
+namespace mp {
+
+// The native side of a fiber: its C stack, VM stack, saved registers and
+// the per-thread state that must follow it between switches. Allocated
+// outside the GC heap; see fiber.cc.
+struct FiberContext;
+
+// A stackful coroutine. Fibers are scheduled M:N onto the carrier
+// processes of a FiberScheduler. A fiber stays on the carrier it first
+// runs on, so C++ code may keep pointers to thread-local state across a
+// switch.
+FORWARD(Fiber);
+class Fiber_O : public core::CxxObject_O {
+  LISP_CLASS(mp, MpPkg, Fiber_O, "Fiber", core::CxxObject_O);
+
+public:
+  enum State : uint32_t { Runnable, Running, Parked, Finished };
+  // Why a parked fiber was woken.
+  enum Wake : uint32_t { WakeNone, WakeUnpark, WakeReady, WakeTimeout };
+
+public:
+  core::T_sp _Name;
+  core::T_sp _Function;
+  core::List_sp _SpecialBindings;
+  FiberScheduler_sp _Scheduler;
+  // What the function returned, as a list, once the fiber has finished.
+  core::T_sp _Result;
+  // Fibers waiting in FIBER-JOIN; protected by _JoinLock.
+  core::List_sp _Joiners;
+  size_t _Carrier;
+  FiberContext* _Context;
+  std::atomic<uint32_t> _State;
+  // The token of the wait we are parked in, or zero. Whoever exchanges it
+  // for zero gets to make the fiber runnable again.
+  std::atomic<uint64_t> _WaitToken;
+  std::atomic<uint32_t> _WakeReason;
+  std::atomic<bool> _Permit;
+  std::atomic<bool> _JoinLock;
+  // Becomes 1 when the fiber finishes; processes joining it sleep on it.
+  std::atomic<uint32_t> _Done;
+
+public:
+  Fiber_O(core::T_sp name, core::T_sp function, core::List_sp special_bindings, FiberScheduler_sp scheduler, size_t carrier)
+      : _Name(name), _Function(function), _SpecialBindings(special_bindings), _Scheduler(scheduler), _Result(nil<core::T_O>()),
+        _Joiners(nil<core::T_O>()), _Carrier(carrier), _Context(NULL), _State(Runnable), _WaitToken(0), _WakeReason(WakeNone),
+        _Permit(false), _JoinLock(false), _Done(0){};
+  void lock_joiners();
+  void unlock_joiners() { this->_JoinLock.store(false, std::memory_order_release); }
+  // Make the fiber runnable if it is still parked in the wait TOKEN.
+  bool wake(uint64_t token, Wake reason);
+  // Start a wait and return its token.
+  uint64_t begin_wait();
+  // Switch to the carrier until woken from the current wait.
+  Wake park_current();
+  void run();
+  void finish();
+  string __repr__() const override;
+  virtual void fixupInternalsForSnapshotSaveLoad(snapshotSaveLoad::Fixup* fixup);
+};
+
+// Carriers are ordinary processes running MP::%FIBER-CARRIER-LOOP, each
+// popping fibers from its own run queue. Timers and descriptor waits are
+// served by one more process running MP::%FIBER-REACTOR-LOOP.
+FORWARD(FiberScheduler);
+class FiberScheduler_O : public core::CxxObject_O {
+  LISP_CLASS(mp, MpPkg, FiberScheduler_O, "FiberScheduler", core::CxxObject_O);
+
+public:
+  core::T_sp _Name;
+  core::SimpleVector_sp _RunQueues;
+  core::List_sp _Processes;
+  size_t _StackBytes;
+  // Fibers per carrier that have not finished yet.
+  std::atomic<int64_t>* _Live;
+  std::atomic<size_t> _NextCarrier;
+  std::atomic<bool> _Shutdown;
+  // The reactor's wakeup pipe, and its epoll descriptor on Linux.
+  int _WakePipe[2];
+  int _PollFd;
+  // Timers and descriptor waits, keyed by wait token; see fiber.cc.
+  void* _Waits;
+
+public:
+  FiberScheduler_O(core::T_sp name, size_t carriers, size_t stack_bytes);
+  ~FiberScheduler_O();
+  size_t carriers() const { return this->_RunQueues->length(); }
+  ConcurrentQueue_sp run_queue(size_t carrier) const;
+  void make_runnable(Fiber_sp fiber);
+  void wake_reactor();
+  string __repr__() const override;
+  virtual void fixupInternalsForSnapshotSaveLoad(snapshotSaveLoad::Fixup* fixup);
+};
+
+}; // namespace mp
+
+template <> struct gctools::GCInfo<mp::FiberScheduler_O> {
+  static bool constexpr NeedsInitialization = false;
+  static bool constexpr NeedsFinalization = true;
+  static GCInfo_policy constexpr Policy = normal;
+};
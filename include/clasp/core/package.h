@@ -38,8 +38,20 @@ THE SOFTWARE.
 
 namespace core {
 
+#ifdef CLASP_THREADS
+/*! Holds the package write lock and marks the package as being written so that
+    optimistic readers (see Package_O::findSymbol_optimistic) retry. */
+template <typename PackageType> struct PackageWriteLock {
+  const PackageType* _Package;
+  PackageWriteLock(const PackageType* pkg) : _Package(pkg) { _Package->begin_write(); }
+  ~PackageWriteLock() { _Package->end_write(); }
+};
 #define WITH_PACKAGE_READ_LOCK(pkg) WITH_READ_LOCK(pkg->_Lock)
-#define WITH_PACKAGE_READ_WRITE_LOCK(pkg) WITH_READ_WRITE_LOCK(pkg->_Lock)
+#define WITH_PACKAGE_READ_WRITE_LOCK(pkg) PackageWriteLock<Package_O> pkg_lock__(pkg)
+#else
+#define WITH_PACKAGE_READ_LOCK(pkg)
+#define WITH_PACKAGE_READ_WRITE_LOCK(pkg)
+#endif
 
 SMART(Package);
 class Package_O : public General_O {
@@ -67,6 +79,9 @@ public: // instance variables
   T_sp _Documentation;
 #ifdef CLASP_THREADS
   mutable mp::SharedMutex _Lock;
+  /*! Odd while a writer holds _Lock, even otherwise. Lets find-symbol and intern
+      look symbols up without taking _Lock. */
+  mutable std::atomic<size_t> _WriteVersion;
 #endif
   bool systemLockedP = false;
   bool userLockedP = false;
@@ -133,6 +148,20 @@ public:
 
   Symbol_mv findSymbol_SimpleString_no_lock(SimpleString_sp nameKey) const;
   Symbol_mv findSymbol_SimpleString(SimpleString_sp nameKey) const;
+#ifdef CLASP_THREADS
+  /*! Look up NAMEKEY without taking _Lock. Return false if writers kept getting
+      in the way, in which case the caller must fall back to the lock. */
+  bool findSymbol_optimistic(SimpleString_sp nameKey, Symbol_sp& sym, Symbol_sp& status) const;
+  void begin_write() const {
+    this->_Lock.lock();
+    this->_WriteVersion.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+  void end_write() const {
+    this->_WriteVersion.fetch_add(1, std::memory_order_release);
+    this->_Lock.unlock();
+  }
+#endif
 
   /*! Return the (values symbol [:inherited,:external,:internal])
    */
@@ -211,12 +240,13 @@ public:
   // Not default constructable
   Package_O()
       : _ActsLikeKeywordPackage(false), _Nicknames(nil<T_O>()), _LocalNicknames(nil<T_O>()), _Documentation(nil<T_O>()),
-        _Lock(PACKAGE__NAMEWORD){};
+        _Lock(PACKAGE__NAMEWORD), _WriteVersion(0){};
 
   virtual void fixupInternalsForSnapshotSaveLoad(snapshotSaveLoad::Fixup* fixup) {
     if (snapshotSaveLoad::operation(fixup) == snapshotSaveLoad::LoadOp) {
       //      printf("%s:%d:%s About to initialize an mp::SharedMutex for a Package_O object\n", __FILE__, __LINE__, __FUNCTION__ );
       new (&this->_Lock) mp::SharedMutex(PACKAGE__NAMEWORD);
+      this->_WriteVersion.store(0);
     }
   }
 
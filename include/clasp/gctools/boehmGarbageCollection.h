@@ -27,6 +27,9 @@ THE SOFTWARE.
 */
 /* -^- */
 
+#include <atomic>
+#include <chrono>
+
 /*! Return the most derived pointer of the object pointed to by the smart_ptr */
 #define GC_BASE_ADDRESS_FROM_SMART_PTR(_smartptr_) (dynamic_cast<void*>(_smartptr_.px_ref()))
 #define GC_BASE_ADDRESS_FROM_PTR(_ptr_) (const_cast<void*>(dynamic_cast<const void*>(_ptr_)))
@@ -97,6 +100,20 @@ void boehm_clear_finalizer_list(gctools::Tagged object);
 
 void clasp_warn_proc(char* msg, GC_word arg);
 
+/*! Stop-the-world times of the collector, recorded by its collection event
+    callback. Only the thread that stops the world writes them, and it holds the
+    allocation lock while it does; they are atomic so that Lisp can read them at
+    any time. */
+struct BoehmPauseStatistics {
+  std::atomic<size_t> _Pauses{0};
+  std::atomic<uint64_t> _TotalPauseNs{0};
+  std::atomic<uint64_t> _MaxPauseNs{0};
+  std::atomic<uint64_t> _RealTimeNs{0}; // Like _TotalPauseNs but never reset
+  std::chrono::steady_clock::time_point _PauseStart;
+};
+
+extern BoehmPauseStatistics global_boehm_pause_statistics;
+
 void startupBoehm(gctools::ClaspInfo* claspInfo);
 int runBoehm(gctools::ClaspInfo* claspInfo);
 void shutdownBoehm();
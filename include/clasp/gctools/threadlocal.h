@@ -105,14 +105,28 @@ extern int global_debug_virtual_machine;
 #endif
 
 struct VirtualMachine {
-  // Stack size is kind of arbitrary, and really we should make it
-  // grow and etc.
-  static constexpr size_t MaxStackWords = 65536;
+  // The stack is a reserved range of address space of which only the low
+  // part is committed. push_frame commits more as frames get deeper; the
+  // uncommitted remainder is PROT_NONE and acts as the guard region.
+  static constexpr size_t DefaultStackBytes = 128 * 1024 * 1024;
+  static constexpr size_t InitialCommitWords = 8192;
+  // Room a frame may use above its registers (pushed arguments, values,
+  // stack allocated objects) before hitting the guard region.
+  static constexpr size_t SlackWords = 4096;
+  // Reserved for the handlers of a stack overflow.
+  static constexpr size_t EmergencyWords = 16384;
   bool _Running;
+  // False for the stacks of fibers, which the fiber code scans itself
+  // rather than registering each one with the GC.
+  bool _registerRoots = true;
+  // False if the stack lives in memory someone else mapped; see startup_in.
+  bool _ownsStack = true;
   core::T_O** _stackBottom;
-  size_t _stackBytes;
-  core::T_O** _stackTop;
-  core::T_O** _stackGuard;
+  size_t _stackBytes;         // committed
+  size_t _stackReservedBytes; // reserved
+  core::T_O** _stackTop;      // last committed word
+  core::T_O** _stackGuard;    // frames reaching past this commit more
+  core::T_O** _stackLimit;    // frames reaching past this overflow
   core::T_O** _stackPointer;
   // only used by debugger
   // has to be initialized because bytecode_call reads it
@@ -132,7 +146,18 @@ struct VirtualMachine {
   void enable_guards();
   void disable_guards();
 
-  void startup();
+  void startup(size_t reserveBytes = 0);
+  void startup_in(void* region, size_t bytes);
+  void initialize(void* region, size_t bytes);
+  void commit(size_t bytes);
+  // Exchange stacks and registers with OTHER.
+  void swap(VirtualMachine& other);
+  [[noreturn]] void overflow();
+  __attribute__((noinline)) void grow(core::T_O** needed);
+  inline bool guard_address_p(void* address) const {
+    return (uintptr_t)(this->_stackTop + 1) <= (uintptr_t)address &&
+           (uintptr_t)address < (uintptr_t)this->_stackBottom + this->_stackReservedBytes;
+  }
   inline void shutdown() { this->_Running = false; }
   inline void push(core::T_O**& stackPointer, core::T_O* value) {
     stackPointer++;
@@ -141,6 +166,14 @@ struct VirtualMachine {
     *stackPointer = value;
   }
 
+  // Make room to push N more words. Only frames are checked against the
+  // guard as a matter of course, so pushes that can take more than
+  // SlackWords (multiple values, say) must call this first.
+  inline void reserve(core::T_O** stackPointer, size_t n) {
+    core::T_O** needed = stackPointer + n;
+    unlikely_if(needed >= this->_stackGuard) this->grow(needed);
+  }
+
   inline core::T_O* pop(core::T_O**& stackPointer) {
     core::T_O* value = *stackPointer;
     stackPointer--;
@@ -224,6 +257,7 @@ struct VirtualMachine {
     }
 #endif
     core::T_O** ret = framePointer + nlocals;
+    unlikely_if(ret >= this->_stackGuard) this->grow(ret);
     VM_STACK_POINTER_CHECK(*this);
     VM_ASSERT_ALIGNED(*this, ret);
     return ret;
@@ -323,7 +357,7 @@ struct ThreadLocalState {
   size_t _xorshf_y;
   size_t _xorshf_z;
   CleanupFunctionNode* _CleanupFunctions;
-  mp::SpinLock _SparePendingInterruptRecordsSpinLock;
+  mp::AdaptiveLock _SparePendingInterruptRecordsLock;
   uint64_t _BytesAllocated;
   uint64_t _Tid;
   uintptr_t _BacktraceBasePointer;
@@ -370,7 +404,7 @@ public:
   void popObjectFile();
   inline DynamicBindingStack& bindings() { return this->_Bindings; };
 
-  void startUpVM();
+  void startUpVM(size_t vmStackBytes = 0);
 
   ~ThreadLocalState();
 };
@@ -436,6 +436,11 @@ bool verifyIRModuleObjectFileStartupSymbol(const std::string& name);
 
 ObjectFile_sp lookupObjectFile(const std::string& name);
 
+/*! Linux perf jitdump output, see jitDump.cc */
+extern std::atomic<bool> global_jitdump;
+void jitdump_object_file(ObjectFile_sp code, llvm::object::ObjectFile& of);
+void jitdump_start(const std::string& directory);
+
 bool lookupObjectFileFromEntryPoint(uintptr_t entry_point, ObjectFile_sp& objectFile);
 
 void validateEntryPoint(core::T_sp code, uintptr_t entry_point);
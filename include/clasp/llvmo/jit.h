@@ -124,6 +124,8 @@ class ClaspJIT_O : public core::General_O {
 public:
   bool do_lookup(JITDylib_sp dylib, const std::string& Name, void*& pointer);
   core::Pointer_sp lookup(JITDylib_sp dylib, const std::string& Name);
+  /*! Look up all of NAMES in DYLIB with one query and return their addresses in POINTERS, in order. */
+  void lookup_all(JITDylib_sp dylib, const std::vector<std::string>& names, std::vector<void*>& pointers);
   core::T_sp lookup_all_dylibs(const std::string& Name);
   JITDylib_sp getMainJITDylib();
   JITDylib_sp createAndRegisterJITDylib(const std::string& name);
@@ -135,6 +137,8 @@ public:
         llvm_sys__jitFinalizeReplFunction needs to build a closure over it
    */
   void* runStartupCode(JITDylib_sp dylib, const std::string& startupName, core::T_sp initialDataOrUnbound);
+  /*! Run the startup function at PTR, as already looked up by runStartupCode. */
+  void* runStartupFunction(void* ptr, core::T_sp initialDataOrUnbound);
   ClaspJIT_O(bool loading, JITDylib_O* mainJITDylib);
   ~ClaspJIT_O();
 
@@ -181,6 +185,5 @@ extern std::atomic<size_t> global_JITDylibCounter;
 void ClaspReturnObjectBuffer(std::unique_ptr<llvm::MemoryBuffer> buffer);
 
 uint64_t getModuleSectionIndexForText(llvm::object::ObjectFile& objf);
-void llvm_sys__create_lljit_thread_pool();
 
 }; // namespace llvmo
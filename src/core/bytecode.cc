@@ -181,6 +181,193 @@ void vm_record_playback(void* value, const char* name) {
 #define VM_RECORD_PLAYBACK(value, name)
 #endif
 
+// Set to 1 to have bytecode_vm count how often each opcode is directly
+// followed by each other opcode. This is what the superinstructions
+// (check-and-bind-required-args, call-return, ...) were chosen from;
+// the counts are read with core:bytecode-opcode-pair-histogram.
+#define VM_OPCODE_PAIR_HISTOGRAM 0
+
+#if VM_OPCODE_PAIR_HISTOGRAM == 1
+static std::atomic<size_t> global_opcode_pairs[256][256];
+
+CL_LAMBDA(&optional reset);
+CL_DOCSTRING(R"(Return a list of (count first-opcode second-opcode) for each pair of opcodes bytecode_vm has executed one
+after the other, most frequent first. If RESET is true, clear the counts afterwards.)");
+DOCGROUP(clasp);
+CL_DEFUN List_sp core__bytecode_opcode_pair_histogram(T_sp reset) {
+  std::vector<std::tuple<size_t, size_t, size_t>> pairs;
+  for (size_t first = 0; first < 256; ++first)
+    for (size_t second = 0; second < 256; ++second) {
+      size_t count = reset.notnilp() ? global_opcode_pairs[first][second].exchange(0, std::memory_order_relaxed)
+                                     : global_opcode_pairs[first][second].load(std::memory_order_relaxed);
+      if (count)
+        pairs.emplace_back(count, first, second);
+    }
+  std::sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) { return std::get<0>(a) > std::get<0>(b); });
+  ql::list result;
+  for (auto& [count, first, second] : pairs)
+    result << Cons_O::createList(Integer_O::create(count), make_fixnum(first), make_fixnum(second));
+  return result.cons();
+}
+#endif
+
+// Bytecode functions are handed to the autocompiler (*autocompile-hook*)
+// once their hotness - calls plus loop iterations - reaches this
+// threshold. Zero means never.
+#define BYTECODE_COMPILE_THRESHOLD 65535
+static std::atomic<uint32_t> global_bytecode_compile_threshold(BYTECODE_COMPILE_THRESHOLD);
+
+CL_DOCSTRING(R"(Return how many calls plus loop iterations a bytecode function needs before it is handed to the autocompiler.)");
+DOCGROUP(clasp);
+CL_DEFUN size_t core__bytecode_autocompile_threshold() {
+  return global_bytecode_compile_threshold.load(std::memory_order_relaxed);
+}
+
+CL_LISPIFY_NAME("core:bytecode-autocompile-threshold");
+CL_DOCSTRING(R"(Set how many calls plus loop iterations a bytecode function needs before it is handed to the autocompiler. Zero
+disables hotness-driven autocompilation.)");
+DOCGROUP(clasp);
+CL_DEFUN_SETF size_t core__set_bytecode_autocompile_threshold(size_t threshold) {
+  if (threshold > BytecodeSimpleFun_O::CallCountLimit)
+    SIMPLE_ERROR("Autocompile threshold {} is too large", threshold);
+  global_bytecode_compile_threshold.store(threshold, std::memory_order_relaxed);
+  return threshold;
+}
+
+// True if a function with HOTNESS (as returned by countCall) should be
+// queued. A function stays hot until it has been queued, so lowering the
+// threshold also catches functions that are already past it.
+static inline bool bytecode_hot_p(uint32_t hotness) {
+  uint32_t threshold = global_bytecode_compile_threshold.load(std::memory_order_relaxed);
+  return threshold != 0 && hotness >= threshold && !(hotness & BytecodeSimpleFun_O::AutocompileQueued);
+}
+
+// Hand FUN to the autocompiler, unless another thread already has.
+// The VM registers must be in sync, since the hook may run bytecode.
+__attribute__((noinline)) static void bytecode_autocompile(BytecodeSimpleFun_sp fun) {
+  if (comp::_sym_STARautocompile_hookSTAR->boundP() && comp::_sym_STARautocompile_hookSTAR->symbolValue().notnilp() &&
+      fun->markAutocompileQueued()) {
+    T_sp nat = eval::funcall(comp::_sym_STARautocompile_hookSTAR->symbolValue(), fun, nil<T_O>());
+    fun->setSimpleFun(gc::As_assert<SimpleFun_sp>(nat));
+    // Since in practice the hook doesn't replace the simple fun
+    // immediately, callers just continue as they were.
+  }
+}
+
+// Called with FUN's hotness after counting a call.
+static inline void bytecode_note_hotness(BytecodeSimpleFun_sp fun, uint32_t hotness) {
+  if (UNLIKELY(bytecode_hot_p(hotness)))
+    bytecode_autocompile(fun);
+}
+
+// A backward jump is a loop iteration. Count it, so that a function that
+// is called rarely but loops a lot still gets compiled.
+// The entry point may already have been replaced by a native one while
+// we're still running the bytecode, in which case there's nothing to do.
+// Before calling out, store the registers as vm_call does.
+static inline void bytecode_count_back_edge(VirtualMachine& vm, T_O** sp, unsigned char* pc, Closure_O* closure) {
+  SimpleFun_sp ep = closure->entryPoint();
+  if (gc::IsA<BytecodeSimpleFun_sp>(ep)) {
+    BytecodeSimpleFun_sp fun = gc::As_unsafe<BytecodeSimpleFun_sp>(ep);
+    if (UNLIKELY(bytecode_hot_p(fun->countBackEdge()))) {
+      vm.push(sp, (T_O*)pc);
+      vm._pc = pc;
+      vm._stackPointer = sp;
+      bytecode_autocompile(fun);
+      vm.drop(sp, 1);
+    }
+  }
+}
+
+static inline unsigned char* bytecode_entry_pc(BytecodeSimpleFun_O* fun) {
+  BytecodeModule_sp module = gc::As_assert<BytecodeModule_sp>(fun->_Code);
+  return (unsigned char*)&(module->bytecode()->_Data[0]) + fun->_EntryPcN;
+}
+
+// Calls through a function cell that miss its inline cache end up here.
+// Refill the cache if the function is bytecode that begins with
+// check-and-bind-required-args, then call it the ordinary way.
+__attribute__((noinline)) static gctools::return_type vm_apply_cell_miss(FunctionCell_sp cell, Function_sp fn, size_t nargs,
+                                                                         T_O** args) {
+  SimpleFun_sp ep = fn->entryPoint();
+  if (gc::IsA<BytecodeSimpleFun_sp>(ep) && ep->entryPoint() == ep) {
+    BytecodeSimpleFun_sp fun = gc::As_unsafe<BytecodeSimpleFun_sp>(ep);
+    if (*bytecode_entry_pc(&*fun) == vm_check_and_bind_required_args &&
+        cell->_CallCache.load(std::memory_order_relaxed).raw_() != fun.raw_())
+      cell->_CallCache.store(fun, std::memory_order_relaxed);
+  }
+  return fn->apply_raw(nargs, args);
+}
+
+// Call FUNC from bytecode. SP is the caller's stack pointer, which has
+// been stored in the VM.
+// Named calls go through function cells, which carry a monomorphic
+// inline cache (FunctionCell_O::_CallCache). On a hit we know the callee
+// is bytecode starting with check-and-bind-required-args, so if the
+// argument count matches we put the arguments where its registers will
+// be and enter it just past that instruction. We still go through the
+// trampoline so backtraces see the frame, and bytecode_call still counts
+// the call. The cache is cleared when the cell's function is set, and
+// entry points replaced by the autocompiler fail the hit check.
+static inline gctools::return_type vm_apply(VirtualMachine& vm, T_O** sp, Function_sp func, size_t nargs, T_O** args) {
+  if (gc::IsA<FunctionCell_sp>(func)) {
+    FunctionCell_sp cell = gc::As_unsafe<FunctionCell_sp>(func);
+    Function_sp fn = cell->real_function();
+    T_O* cached = cell->_CallCache.load(std::memory_order_relaxed).raw_();
+    if (fn->entryPoint().raw_() == cached) {
+      BytecodeSimpleFun_O* fun = gctools::untag_general<BytecodeSimpleFun_O*>((BytecodeSimpleFun_O*)cached);
+      unsigned char* pc = bytecode_entry_pc(fun);
+      // The new frame's registers start two words up, after the saved
+      // frame pointer; make sure push_frame won't need to grow the stack.
+      if (fun->entryPoint().raw_() == cached && pc[1] == nargs && sp + 1 + fun->_LocalsFrameSize < vm._stackGuard) {
+        std::copy(args, args + nargs, sp + 2);
+        return (fun->_Trampoline)(pc + 2, fn.raw_(), nargs, args);
+      }
+    }
+    return vm_apply_cell_miss(cell, fn, nargs, args);
+  }
+  return func->apply_raw(nargs, args);
+}
+
+// On compilers that support labels-as-values, bytecode_vm dispatches
+// directly from the end of each instruction to the handler of the next
+// through a table of label addresses, instead of going back through the
+// switch. That gives each handler its own indirect branch, which the
+// branch predictor handles much better than the single shared one.
+// The switch is still used for the first instruction and when any of
+// the per-instruction debugging hooks are enabled.
+// Define CLASP_VM_SWITCH_DISPATCH to always use the switch.
+#if defined(__GNUC__) && !defined(DEBUG_VIRTUAL_MACHINE) && (DEBUG_VM_RECORD_PLAYBACK == 0) && (VM_OPCODE_PAIR_HISTOGRAM == 0) &&    \
+    !defined(CLASP_VM_SWITCH_DISPATCH)
+#define VM_THREADED_DISPATCH 1
+#else
+#define VM_THREADED_DISPATCH 0
+#endif
+
+#if VM_THREADED_DISPATCH
+#define VM_LABEL(op) vm_label_##op
+#define VM_CASE(op)                                                                                                                \
+  case op:                                                                                                                         \
+    VM_LABEL(op):
+#define VM_DEFAULT                                                                                                                 \
+  default:                                                                                                                         \
+    vm_label_unknown
+#define VM_NEXT() goto* vm_dispatch_table[*pc]
+#define VM_OP_UNKNOWN &&vm_label_unknown
+#define VM_OP_UNKNOWN_X8 VM_OP_UNKNOWN, VM_OP_UNKNOWN, VM_OP_UNKNOWN, VM_OP_UNKNOWN, VM_OP_UNKNOWN, VM_OP_UNKNOWN, VM_OP_UNKNOWN, VM_OP_UNKNOWN
+#define VM_OP_UNKNOWN_X64 VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8
+
+// The table below is laid out by hand in opcode order; check the opcodes
+// it relies on so a renumbering in bytecode-machines.lisp fails loudly.
+static_assert(vm_ref == 0 && vm_called_fdefinition == 60 && vm_encell == 63 && vm_pop_return == 66 && vm_long == 255,
+              "The bytecode opcodes changed - update the dispatch table in bytecode_vm");
+static_assert(vm_catch_8 == 44 && vm_progv == 52 && vm_eq == 55, "The bytecode opcodes changed - update the dispatch table in bytecode_vm");
+#else
+#define VM_CASE(op) case op:
+#define VM_DEFAULT default
+#define VM_NEXT() break
+#endif
+
 static unsigned char* long_dispatch(VirtualMachine&, unsigned char*, MultipleValues& multipleValues, T_O**, T_O**, Closure_O*,
                                     core::T_O**, core::T_O**, size_t, core::T_O**, uint8_t);
 
@@ -211,8 +398,50 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
 #endif
   MultipleValues& multipleValues = core::lisp_multipleValues();
   unsigned char* pc = vm._pc;
+#if VM_THREADED_DISPATCH
+  // Indexed by opcode. Opcodes that bytecode_vm does not implement
+  // (catch, throw, progv, eq, ...) go to the unknown opcode error.
+  static void* const vm_dispatch_table[256] = {
+      &&VM_LABEL(vm_ref), &&VM_LABEL(vm_const), &&VM_LABEL(vm_closure), &&VM_LABEL(vm_call), &&VM_LABEL(vm_call_receive_one),
+      &&VM_LABEL(vm_call_receive_fixed), &&VM_LABEL(vm_bind), &&VM_LABEL(vm_set), &&VM_LABEL(vm_make_cell),
+      &&VM_LABEL(vm_cell_ref), &&VM_LABEL(vm_cell_set), &&VM_LABEL(vm_make_closure), &&VM_LABEL(vm_make_uninitialized_closure),
+      &&VM_LABEL(vm_initialize_closure), &&VM_LABEL(vm_return), &&VM_LABEL(vm_bind_required_args),
+      &&VM_LABEL(vm_bind_optional_args), &&VM_LABEL(vm_listify_rest_args), &&VM_LABEL(vm_vaslistify_rest_args),
+      &&VM_LABEL(vm_parse_key_args), &&VM_LABEL(vm_jump_8), &&VM_LABEL(vm_jump_16), &&VM_LABEL(vm_jump_24),
+      &&VM_LABEL(vm_jump_if_8), &&VM_LABEL(vm_jump_if_16), &&VM_LABEL(vm_jump_if_24), &&VM_LABEL(vm_jump_if_supplied_8),
+      &&VM_LABEL(vm_jump_if_supplied_16), &&VM_LABEL(vm_check_arg_count_LE), &&VM_LABEL(vm_check_arg_count_GE),
+      &&VM_LABEL(vm_check_arg_count_EQ), &&VM_LABEL(vm_push_values), &&VM_LABEL(vm_append_values), &&VM_LABEL(vm_pop_values),
+      &&VM_LABEL(vm_mv_call), &&VM_LABEL(vm_mv_call_receive_one), &&VM_LABEL(vm_mv_call_receive_fixed),
+      &&VM_LABEL(vm_save_sp), &&VM_LABEL(vm_restore_sp), &&VM_LABEL(vm_entry), &&VM_LABEL(vm_exit_8), &&VM_LABEL(vm_exit_16),
+      &&VM_LABEL(vm_exit_24), &&VM_LABEL(vm_entry_close),
+      VM_OP_UNKNOWN, // catch-8
+      VM_OP_UNKNOWN, // catch-16
+      VM_OP_UNKNOWN, // throw
+      VM_OP_UNKNOWN, // catch-close
+      &&VM_LABEL(vm_special_bind), &&VM_LABEL(vm_symbol_value), &&VM_LABEL(vm_symbol_value_set), &&VM_LABEL(vm_unbind),
+      VM_OP_UNKNOWN, // progv
+      &&VM_LABEL(vm_fdefinition), &&VM_LABEL(vm_nil),
+      VM_OP_UNKNOWN, // eq
+      &&VM_LABEL(vm_push), &&VM_LABEL(vm_pop), &&VM_LABEL(vm_dup), &&VM_LABEL(vm_fdesignator),
+      &&VM_LABEL(vm_called_fdefinition),
+      VM_OP_UNKNOWN, VM_OP_UNKNOWN, // 61-62
+      &&VM_LABEL(vm_encell), &&VM_LABEL(vm_check_and_bind_required_args), &&VM_LABEL(vm_call_return),
+      &&VM_LABEL(vm_pop_return),
+      // 67-254
+      VM_OP_UNKNOWN_X64, VM_OP_UNKNOWN_X64, VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8,
+      VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN_X8, VM_OP_UNKNOWN, VM_OP_UNKNOWN, VM_OP_UNKNOWN, VM_OP_UNKNOWN,
+      &&VM_LABEL(vm_long)};
+#endif
+#if VM_OPCODE_PAIR_HISTOGRAM == 1
+  int vm_previous_opcode = -1;
+#endif
   while (1) {
     VM_PC_CHECK(vm, pc, bytecode_start, bytecode_end);
+#if VM_OPCODE_PAIR_HISTOGRAM == 1
+    if (vm_previous_opcode >= 0)
+      global_opcode_pairs[vm_previous_opcode][*pc].fetch_add(1, std::memory_order_relaxed);
+    vm_previous_opcode = *pc;
+#endif
 #if DEBUG_VM_RECORD_PLAYBACK == 1
     global_counter++;
     size_t stackHeight = (uintptr_t)(vm)._stackPointer - (uintptr_t)(vm)._stackBottom;
@@ -228,30 +457,30 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
     }
 #endif
     switch (*pc) {
-    case vm_ref: {
+    VM_CASE(vm_ref) {
       uint8_t n = *(++pc);
       DBG_VM1("ref %" PRIu8 "\n", n);
       vm.push(sp, *(vm.reg(fp, n)));
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_const: {
+    VM_CASE(vm_const) {
       uint8_t n = *(++pc);
       DBG_VM1("const %" PRIu8 "\n", n);
       T_O* value = literals[n];
       vm.push(sp, value);
       VM_RECORD_PLAYBACK(value, "const");
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_closure: {
+    VM_CASE(vm_closure) {
       uint8_t n = *(++pc);
       DBG_VM("closure %" PRIu8 "\n", n);
       vm.push(sp, closed[n]);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_call: {
+    VM_CASE(vm_call) {
       uint8_t nargs = *(++pc);
       DBG_VM1("call %" PRIu8 "\n", nargs);
       T_sp tfunc((gctools::Tagged)(*(vm.stackref(sp, nargs))));
@@ -260,13 +489,13 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       vm.push(sp, (T_O*)pc);
       vm._pc = pc;
       vm._stackPointer = sp;
-      T_mv res = func->apply_raw(nargs, args);
+      T_mv res = vm_apply(vm, sp, func, nargs, args);
       multipleValues.setN(res.raw_(), res.number_of_values());
       vm.drop(sp, nargs + 2);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_call_receive_one: {
+    VM_CASE(vm_call_receive_one) {
       uint8_t nargs = *(++pc);
       DBG_VM1("call-receive-one %" PRIu8 "\n", nargs);
       T_sp tfunc((gctools::Tagged)(*(vm.stackref(sp, nargs))));
@@ -284,14 +513,14 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       vm.push(sp, (T_O*)pc);
       vm._pc = pc;
       vm._stackPointer = sp;
-      T_sp res = func->apply_raw(nargs, args);
+      T_sp res = vm_apply(vm, sp, func, nargs, args);
       vm.drop(sp, nargs + 2);
       vm.push(sp, res.raw_());
       VM_RECORD_PLAYBACK(res.raw_(), "vm_call_receive_one");
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_call_receive_fixed: {
+    VM_CASE(vm_call_receive_fixed) {
       uint8_t nargs = *(++pc);
       uint8_t nvals = *(++pc);
       DBG_VM("call-receive-fixed %" PRIu8 " %" PRIu8 "\n", nargs, nvals);
@@ -301,7 +530,7 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       vm.push(sp, (T_O*)pc);
       vm._pc = pc;
       vm._stackPointer = sp;
-      T_mv res = func->apply_raw(nargs, args);
+      T_mv res = vm_apply(vm, sp, func, nargs, args);
       vm.drop(sp, nargs + 2);
       if (nvals != 0) {
         vm.push(sp, res.raw_()); // primary
@@ -310,40 +539,40 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
           vm.push(sp, multipleValues.valueGet(i, svalues).raw_());
       }
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_bind: {
+    VM_CASE(vm_bind) {
       uint8_t nelems = *(++pc);
       uint8_t base = *(++pc);
       DBG_VM1("bind %" PRIu8 " %" PRIu8 "\n", nelems, base);
       vm.copytoreg(fp, vm.stackref(sp, nelems - 1), nelems, base);
       vm.drop(sp, nelems);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_set: {
+    VM_CASE(vm_set) {
       uint8_t n = *(++pc);
       DBG_VM("set %" PRIu8 "\n", n);
       vm.setreg(fp, n, vm.pop(sp));
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_make_cell: {
+    VM_CASE(vm_make_cell) {
       DBG_VM1("make-cell\n");
       T_sp car((gctools::Tagged)(vm.pop(sp)));
       T_sp cdr((gctools::Tagged)nil<T_O>().raw_());
       vm.push(sp, Cons_O::create(car, cdr).raw_());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_cell_ref: {
+    VM_CASE(vm_cell_ref) {
       DBG_VM1("cell-ref\n");
       T_sp cons((gctools::Tagged)vm.pop(sp));
       vm.push(sp, cons.unsafe_cons()->car().raw_());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_cell_set: {
+    VM_CASE(vm_cell_set) {
       DBG_VM("cell-set\n");
       T_sp cons((gctools::Tagged)vm.pop(sp));
       Cons_sp ccons = gc::As_assert<Cons_sp>(cons);
@@ -351,9 +580,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       T_sp tval((gctools::Tagged)val);
       ccons->rplaca(tval);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_make_closure: {
+    VM_CASE(vm_make_closure) {
       uint8_t c = *(++pc);
       DBG_VM("make-closure %" PRIu8 "\n", c);
       T_sp fn_sp((gctools::Tagged)literals[c]);
@@ -366,9 +595,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       vm.drop(sp, nclosed);
       vm.push(sp, closure.raw_());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_make_uninitialized_closure: {
+    VM_CASE(vm_make_uninitialized_closure) {
       uint8_t c = *(++pc);
       DBG_VM("make-uninitialized-closure %" PRIu8 "\n", c);
       T_sp fn_sp((gctools::Tagged)literals[c]);
@@ -378,9 +607,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       Closure_sp closure = Closure_O::make_bytecode_closure(fn, nclosed);
       vm.push(sp, closure.raw_());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_initialize_closure: {
+    VM_CASE(vm_initialize_closure) {
       uint8_t c = *(++pc);
       DBG_VM("initialize-closure %" PRIu8 "\n", c);
       T_sp tclosure((gctools::Tagged)(*(vm.reg(fp, c))));
@@ -393,23 +622,23 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       vm.copyto(sp, nclosed, (T_O**)(closure->_Slots.data()));
       vm.drop(sp, nclosed);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_return: {
+    VM_CASE(vm_return) {
       DBG_VM1("return\n");
       // since the stack pointer is a local variable we don't need to
       // adjust it.
       size_t nvalues = multipleValues.getSize();
       return gctools::return_type(multipleValues.valueGet(0, nvalues).raw_(), nvalues);
     }
-    case vm_bind_required_args: {
+    VM_CASE(vm_bind_required_args) {
       uint8_t nargs = *(++pc);
       DBG_VM("bind-required-args %" PRIu8 "\n", nargs);
       vm.copytoreg(fp, lcc_args, nargs, 0);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_bind_optional_args: {
+    VM_CASE(vm_bind_optional_args) {
       uint8_t nreq = *(++pc);
       uint8_t nopt = *(++pc);
       DBG_VM("bind-optional-args %" PRIu8 " %" PRIu8 "\n", nreq, nopt);
@@ -422,9 +651,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
         vm.fillreg(fp, unbound<T_O>().raw_(), nreq + nopt - lcc_nargs, lcc_nargs);
       }
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_listify_rest_args: {
+    VM_CASE(vm_listify_rest_args) {
       uint8_t start = *(++pc);
       DBG_VM("listify-rest-args %" PRIu8 "\n", start);
       ql::list rest;
@@ -434,9 +663,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       }
       vm.setreg(fp, start, rest.cons().raw_());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_vaslistify_rest_args: {
+    VM_CASE(vm_vaslistify_rest_args) {
       //
       // This pushes two vaslist structures (each two words that look like fixnums)
       // onto the stack.  the theVaslist_backup is used by vaslist_rewind
@@ -446,9 +675,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       auto theVaslist = vm.alloca_vaslist2(sp, lcc_args + start, lcc_nargs - start);
       vm.setreg(fp, start, theVaslist);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_parse_key_args: {
+    VM_CASE(vm_parse_key_args) {
       uint8_t more_start = *(++pc);
       uint8_t key_count_info = *(++pc);
       uint8_t key_literal_start = *(++pc);
@@ -499,58 +728,70 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
         throwUnrecognizedKeywordArgumentError(tclosure, unknown_keys);
       }
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_jump_8: {
+    VM_CASE(vm_jump_8) {
       int8_t rel = *(pc + 1);
       DBG_VM1("jump %" PRId8 "\n", rel);
+      if (rel < 0)
+        bytecode_count_back_edge(vm, sp, pc, closure);
       pc += rel;
-      break;
+      VM_NEXT();
     }
-    case vm_jump_16: {
+    VM_CASE(vm_jump_16) {
       int16_t rel = read_s16(pc + 1);
       DBG_VM("jump %" PRId16 "\n", rel);
+      if (rel < 0)
+        bytecode_count_back_edge(vm, sp, pc, closure);
       pc += rel;
-      break;
+      VM_NEXT();
     }
-    case vm_jump_24: {
+    VM_CASE(vm_jump_24) {
       int32_t rel = read_label(pc, 3);
       DBG_VM("jump %" PRId32 "\n", rel);
+      if (rel < 0)
+        bytecode_count_back_edge(vm, sp, pc, closure);
       pc += rel;
-      break;
+      VM_NEXT();
     }
-    case vm_jump_if_8: {
+    VM_CASE(vm_jump_if_8) {
       int8_t rel = *(pc + 1);
       DBG_VM1("jump-if %" PRId8 "\n", rel);
       T_sp tval((gctools::Tagged)vm.pop(sp));
       VM_RECORD_PLAYBACK(tval.raw_(), "vm_jump_if_8");
-      if (tval.notnilp())
+      if (tval.notnilp()) {
+        if (rel < 0)
+          bytecode_count_back_edge(vm, sp, pc, closure);
         pc += rel;
-      else
+      } else
         pc += 2;
-      break;
+      VM_NEXT();
     }
-    case vm_jump_if_16: {
+    VM_CASE(vm_jump_if_16) {
       int16_t rel = read_s16(pc + 1);
       DBG_VM("jump-if %" PRId16 "\n", rel);
       T_sp tval((gctools::Tagged)vm.pop(sp));
-      if (tval.notnilp())
+      if (tval.notnilp()) {
+        if (rel < 0)
+          bytecode_count_back_edge(vm, sp, pc, closure);
         pc += rel;
-      else
+      } else
         pc += 3;
-      break;
+      VM_NEXT();
     }
-    case vm_jump_if_24: {
+    VM_CASE(vm_jump_if_24) {
       int32_t rel = read_label(pc, 3);
       DBG_VM("jump-if %" PRId32 "\n", rel);
       T_sp tval((gctools::Tagged)vm.pop(sp));
-      if (tval.notnilp())
+      if (tval.notnilp()) {
+        if (rel < 0)
+          bytecode_count_back_edge(vm, sp, pc, closure);
         pc += rel;
-      else
+      } else
         pc += 4;
-      break;
+      VM_NEXT();
     }
-    case vm_jump_if_supplied_8: {
+    VM_CASE(vm_jump_if_supplied_8) {
       uint8_t slot = *(pc + 1);
       int32_t rel = *(pc + 2);
       DBG_VM("jump-if-supplied %" PRIu8 " %" PRId8 "\n", slot, rel);
@@ -559,9 +800,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
         pc += 3;
       else
         pc += rel;
-      break;
+      VM_NEXT();
     }
-    case vm_jump_if_supplied_16: {
+    VM_CASE(vm_jump_if_supplied_16) {
       uint8_t slot = *(pc + 1);
       int16_t rel = read_s16(pc + 2);
       DBG_VM("jump-if-supplied %" PRIu8 " %" PRId16 "\n", slot, rel);
@@ -570,9 +811,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
         pc += 4;
       else
         pc += rel;
-      break;
+      VM_NEXT();
     }
-    case vm_check_arg_count_LE: {
+    VM_CASE(vm_check_arg_count_LE) {
       uint8_t max_nargs = *(++pc);
       DBG_VM("check-arg-count<= %" PRIu8 "\n", max_nargs);
       if (lcc_nargs > max_nargs) {
@@ -580,9 +821,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
         throwTooManyArgumentsError(tclosure, lcc_nargs, max_nargs);
       }
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_check_arg_count_GE: {
+    VM_CASE(vm_check_arg_count_GE) {
       uint8_t min_nargs = *(++pc);
       DBG_VM("check-arg-count>= %" PRIu8 "\n", min_nargs);
       if (lcc_nargs < min_nargs) {
@@ -590,9 +831,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
         throwTooFewArgumentsError(tclosure, lcc_nargs, min_nargs);
       }
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_check_arg_count_EQ: {
+    VM_CASE(vm_check_arg_count_EQ) {
       uint8_t req_nargs = *(++pc);
       DBG_VM1("check-arg-count= %" PRIu8 "\n", req_nargs);
       if (lcc_nargs != req_nargs) {
@@ -600,34 +841,36 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
         wrongNumberOfArguments(tclosure, lcc_nargs, req_nargs);
       }
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_push_values: {
+    VM_CASE(vm_push_values) {
       // TODO: Direct copy?
       DBG_VM("push-values\n");
       size_t nvalues = multipleValues.getSize();
       DBG_VM("  nvalues = %zu\n", nvalues);
+      vm.reserve(sp, nvalues + 1);
       for (size_t i = 0; i < nvalues; ++i)
         vm.push(sp, multipleValues.valueGet(i, nvalues).raw_());
       // We could skip tagging this, but that's error-prone.
       vm.push(sp, make_fixnum(nvalues).raw_());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_append_values: {
+    VM_CASE(vm_append_values) {
       DBG_VM("append-values\n");
       T_sp texisting_values((gctools::Tagged)vm.pop(sp));
       size_t existing_values = texisting_values.unsafe_fixnum();
       DBG_VM("  existing-values = %zu\n", existing_values);
       size_t nvalues = multipleValues.getSize();
       DBG_VM("  nvalues = %zu\n", nvalues);
+      vm.reserve(sp, nvalues + 1);
       for (size_t i = 0; i < nvalues; ++i)
         vm.push(sp, multipleValues.valueGet(i, nvalues).raw_());
       vm.push(sp, make_fixnum(nvalues + existing_values).raw_());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_pop_values: {
+    VM_CASE(vm_pop_values) {
       DBG_VM("pop-values\n");
       T_sp texisting_values((gctools::Tagged)vm.pop(sp));
       size_t existing_values = texisting_values.unsafe_fixnum();
@@ -636,9 +879,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       multipleValues.setSize(existing_values);
       vm.drop(sp, existing_values);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_mv_call: {
+    VM_CASE(vm_mv_call) {
       DBG_VM("mv-call\n");
       T_sp tnargs((gctools::Tagged)vm.pop(sp));
       size_t nargs = tnargs.unsafe_fixnum();
@@ -653,9 +896,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       vm.drop(sp, nargs + 1 + 1); // 1 each for func, pc
       multipleValues.setN(res.raw_(), res.number_of_values());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_mv_call_receive_one: {
+    VM_CASE(vm_mv_call_receive_one) {
       DBG_VM("mv-call-receive-one\n");
       T_sp tnargs((gctools::Tagged)vm.pop(sp));
       size_t nargs = tnargs.unsafe_fixnum();
@@ -671,9 +914,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       multipleValues.set1(res);
       vm.push(sp, res.raw_());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_mv_call_receive_fixed: {
+    VM_CASE(vm_mv_call_receive_fixed) {
       uint8_t nvals = *(++pc);
       DBG_VM("mv-call-receive-fixed %" PRIu8 "\n", nvals);
       T_sp tnargs((gctools::Tagged)vm.pop(sp));
@@ -693,23 +936,23 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
           vm.push(sp, multipleValues.valueGet(i, svalues).raw_());
       }
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_save_sp: {
+    VM_CASE(vm_save_sp) {
       uint8_t n = *(++pc);
       DBG_VM("save sp %" PRIu8 "\n", n);
       vm.savesp(fp, sp, n);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_restore_sp: {
+    VM_CASE(vm_restore_sp) {
       uint8_t n = *(++pc);
       DBG_VM("restore sp %" PRIu8 "\n", n);
       vm.restoresp(fp, sp, n);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_entry: {
+    VM_CASE(vm_entry) {
       uint8_t n = *(++pc);
       DBG_VM("entry %" PRIu8 "\n", n);
       pc++;
@@ -733,9 +976,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
         } else
           throw;
       }
-      break;
+      VM_NEXT();
     }
-    case vm_exit_8: {
+    VM_CASE(vm_exit_8) {
       int8_t rel = *(pc + 1);
       DBG_VM("exit %" PRId8 "\n", rel);
       vm._pc = pc + rel;
@@ -743,7 +986,7 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       TagbodyDynEnv_sp tde = gc::As_assert<TagbodyDynEnv_sp>(ttde);
       sjlj_unwind(tde, 1);
     }
-    case vm_exit_16: {
+    VM_CASE(vm_exit_16) {
       int16_t rel = read_s16(pc + 1);
       DBG_VM("exit %" PRId16 "\n", rel);
       vm._pc = pc + rel;
@@ -751,7 +994,7 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       TagbodyDynEnv_sp tde = gc::As_assert<TagbodyDynEnv_sp>(ttde);
       sjlj_unwind(tde, 1);
     }
-    case vm_exit_24: {
+    VM_CASE(vm_exit_24) {
       int32_t rel = read_label(pc, 3);
       DBG_VM("exit %" PRId32 "\n", rel);
       vm._pc = pc + rel;
@@ -759,7 +1002,7 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       TagbodyDynEnv_sp tde = gc::As_assert<TagbodyDynEnv_sp>(ttde);
       sjlj_unwind(tde, 1);
     }
-    case vm_entry_close: {
+    VM_CASE(vm_entry_close) {
       DBG_VM("entry-close\n");
       // This sham return value just gets us out of the bytecode_vm call in
       // vm_entry, above.
@@ -767,7 +1010,7 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       vm._stackPointer = sp;
       return gctools::return_type(nil<T_O>().raw_(), 0);
     }
-    case vm_special_bind: {
+    VM_CASE(vm_special_bind) {
       uint8_t c = *(++pc);
       DBG_VM("special-bind %" PRIu8 "\n", c);
       T_sp value((gctools::Tagged)(vm.pop(sp)));
@@ -778,18 +1021,18 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
                            [&]() { return bytecode_vm(vm, literals, closed, closure, fp, sp, lcc_nargs, lcc_args); });
       sp = vm._stackPointer;
       pc = vm._pc;
-      break;
+      VM_NEXT();
     }
-    case vm_symbol_value: {
+    VM_CASE(vm_symbol_value) {
       uint8_t c = *(++pc);
       DBG_VM("symbol-value %" PRIu8 "\n", c);
       T_sp cell_sp((gctools::Tagged)literals[c]);
       VariableCell_sp cell = gc::As_assert<VariableCell_sp>(cell_sp);
       vm.push(sp, cell->value().raw_());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_symbol_value_set: {
+    VM_CASE(vm_symbol_value_set) {
       uint8_t c = *(++pc);
       DBG_VM("symbol-value-set %" PRIu8 "\n", c);
       T_sp cell_sp((gctools::Tagged)literals[c]);
@@ -797,9 +1040,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       T_sp value((gctools::Tagged)(vm.pop(sp)));
       cell->set_value(value);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_unbind: {
+    VM_CASE(vm_unbind) {
       DBG_VM("unbind\n");
       vm._pc = pc + 1;
       vm._stackPointer = sp;
@@ -807,7 +1050,7 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       // a bytecode_vm recursively invoked by vm_special_bind above.
       return gctools::return_type(nil<T_O>().raw_(), 0);
     }
-    case vm_fdefinition: {
+    VM_CASE(vm_fdefinition) {
       // We have function cells in the literals vector. While these are
       // themselves callable, we have to resolve the cell because we
       // use vm_fdefinition for lookup of #'foo.
@@ -818,35 +1061,35 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       vm.push(sp, fun.raw_());
       VM_RECORD_PLAYBACK(fun.raw_(), "fdefinition");
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_nil:
+    VM_CASE(vm_nil)
       DBG_VM("nil\n");
       vm.push(sp, nil<T_O>().raw_());
       pc++;
-      break;
-    case vm_push: {
+      VM_NEXT();
+    VM_CASE(vm_push) {
       DBG_VM1("push\n");
       vm.push(sp, multipleValues.valueGet(0, multipleValues.getSize()).raw_());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_pop: {
+    VM_CASE(vm_pop) {
       DBG_VM1("pop\n");
       T_sp obj((gctools::Tagged)vm.pop(sp));
       multipleValues.set1(obj);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_dup: {
+    VM_CASE(vm_dup) {
       DBG_VM1("dup\n");
       T_O* obj = vm.pop(sp);
       vm.push(sp, obj);
       vm.push(sp, obj);
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_fdesignator: {
+    VM_CASE(vm_fdesignator) {
       uint8_t c = *(++pc); // ignored environment parameter
       DBG_VM1("fdesignator %" PRIu8 "\n", c);
       T_sp desig((gctools::Tagged)vm.pop(sp));
@@ -854,9 +1097,9 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       vm.push(sp, fun.raw_());
       VM_RECORD_PLAYBACK(run.raw_(), "fdesignator");
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_called_fdefinition: {
+    VM_CASE(vm_called_fdefinition) {
       // This is like FDEFINITION except that we know the result will
       // just be called. So, we can just use the cell directly
       // without checking fboundedness, and this is just like const.
@@ -868,27 +1111,61 @@ bytecode_vm(VirtualMachine& vm, T_O** literals, T_O** closed, Closure_O* closure
       vm.push(sp, fun);
       VM_RECORD_PLAYBACK(fun, "called-fdefinition");
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_encell: {
+    VM_CASE(vm_encell) {
       // abbreviation for ref N; make-cell; set N
       uint8_t n = *(++pc);
       DBG_VM1("encell %" PRIu8 "\n", n);
       T_sp val((gctools::Tagged)(*(vm.reg(fp, n))));
       vm.setreg(fp, n, Cons_O::create(val, nil<T_O>()).raw_());
       pc++;
-      break;
+      VM_NEXT();
     }
-    case vm_long: {
+    VM_CASE(vm_check_and_bind_required_args) {
+      // check-arg-count-EQ n; bind-required-args n
+      uint8_t nargs = *(++pc);
+      DBG_VM1("check-and-bind-required-args %" PRIu8 "\n", nargs);
+      if (lcc_nargs != nargs) {
+        T_sp tclosure((gctools::Tagged)(gctools::tag_general(closure)));
+        wrongNumberOfArguments(tclosure, lcc_nargs, nargs);
+      }
+      vm.copytoreg(fp, lcc_args, nargs, 0);
+      pc++;
+      VM_NEXT();
+    }
+    VM_CASE(vm_call_return) {
+      // call n; return
+      uint8_t nargs = *(++pc);
+      DBG_VM1("call-return %" PRIu8 "\n", nargs);
+      T_sp tfunc((gctools::Tagged)(*(vm.stackref(sp, nargs))));
+      Function_sp func = gc::As_assert<Function_sp>(tfunc);
+      T_O** args = vm.stackref(sp, nargs - 1);
+      vm.push(sp, (T_O*)pc);
+      vm._pc = pc;
+      vm._stackPointer = sp;
+      T_mv res = vm_apply(vm, sp, func, nargs, args);
+      size_t nvalues = res.number_of_values();
+      multipleValues.setN(res.raw_(), nvalues);
+      return gctools::return_type(res.raw_(), nvalues);
+    }
+    VM_CASE(vm_pop_return) {
+      // pop; return
+      DBG_VM1("pop-return\n");
+      T_sp obj((gctools::Tagged)vm.pop(sp));
+      multipleValues.set1(obj);
+      return gctools::return_type(obj.raw_(), 1);
+    }
+    VM_CASE(vm_long) {
       // In a separate function to facilitate better icache utilization
       // by bytecode_vm (hopefully)
       pc++;
       // FIXME: This is a stupid way of returning two values.
       pc = long_dispatch(vm, pc, multipleValues, literals, closed, closure, fp, sp, lcc_nargs, lcc_args, *pc);
       sp = vm._stackPointer;
-      break;
+      VM_NEXT();
     }
-    default:
+    VM_DEFAULT:
       SimpleFun_sp ep = closure->entryPoint();
       BytecodeModule_sp bcm = gc::As<BytecodeSimpleFun_sp>(ep)->code();
       unsigned char* codeStart = (unsigned char*)bcm->bytecode()->rowMajorAddressOfElement_(0);
@@ -985,6 +1262,7 @@ static unsigned char* long_dispatch(VirtualMachine& vm, unsigned char* pc, Multi
     T_mv res = func->apply_raw(nargs, args);
     vm.drop(sp, nargs + 2);
     if (nvals != 0) {
+      vm.reserve(sp, nvals);
       vm.push(sp, res.raw_()); // primary
       size_t svalues = multipleValues.getSize();
       for (size_t i = 1; i < nvals; ++i)
@@ -1232,6 +1510,7 @@ static unsigned char* long_dispatch(VirtualMachine& vm, unsigned char* pc, Multi
     T_mv res = func->apply_raw(nargs, args);
     vm.drop(sp, nargs + 2); // 2 = func + nargs
     if (nvals != 0) {
+      vm.reserve(sp, nvals);
       vm.push(sp, res.raw_()); // primary
       size_t svalues = multipleValues.getSize();
       for (size_t i = 1; i < nvals; ++i)
@@ -1347,6 +1626,18 @@ static unsigned char* long_dispatch(VirtualMachine& vm, unsigned char* pc, Multi
     pc++;
     break;
   }
+  case vm_check_and_bind_required_args: {
+    uint8_t low = *(pc + 1);
+    uint16_t nargs = low + (*(pc + 2) << 8);
+    DBG_VM1("long check-and-bind-required-args %" PRIu16 "\n", nargs);
+    if (lcc_nargs != nargs) {
+      T_sp tclosure((gctools::Tagged)(gctools::tag_general(closure)));
+      wrongNumberOfArguments(tclosure, lcc_nargs, nargs);
+    }
+    vm.copytoreg(fp, lcc_args, nargs, 0);
+    pc += 3;
+    break;
+  }
   default:
     SIMPLE_ERROR("Unknown LONG sub_opcode {}", sub_opcode);
   }
@@ -1364,22 +1655,13 @@ void VMFrameDynEnv_O::proceed() {
 
 extern "C" {
 
-#define BYTECODE_COMPILE_THRESHOLD 65535
-
 gctools::return_type bytecode_call(unsigned char* pc, core::T_O* lcc_closure, size_t lcc_nargs, core::T_O** lcc_args) {
   core::Closure_O* closure = gctools::untag_general<core::Closure_O*>((core::Closure_O*)lcc_closure);
   ASSERT(gc::IsA<core::BytecodeSimpleFun_sp>(closure->entryPoint()));
   auto entry = closure->entryPoint();
   core::BytecodeSimpleFun_sp entryPoint = gctools::As_assert<core::BytecodeSimpleFun_sp>(entry);
   // Maybe compile this function, if it's been called a lot.
-  entryPoint->countCall();
-  if (entryPoint->callCount() >= BYTECODE_COMPILE_THRESHOLD && comp::_sym_STARautocompile_hookSTAR->boundP() &&
-      comp::_sym_STARautocompile_hookSTAR->symbolValue().notnilp()) {
-    core::T_sp nat = core::eval::funcall(comp::_sym_STARautocompile_hookSTAR->symbolValue(), entry, nil<core::T_O>());
-    entryPoint->setSimpleFun(gc::As_assert<core::SimpleFun_sp>(nat));
-    // Since in practice the hook doesn't replace the simple fun
-    // immediately, we just continue as we were.
-  }
+  core::bytecode_note_hotness(entryPoint, entryPoint->countCall());
   // Proceed with the bytecode call.
   DBG_printf("%s:%d:%s This is where we evaluate bytecode functions pc: %p\n", __FILE__, __LINE__, __FUNCTION__, pc);
   size_t nlocals = entryPoint->_LocalsFrameSize;
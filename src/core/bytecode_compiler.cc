@@ -577,11 +577,18 @@ void Context::emit_parse_key_args(size_t max_count, size_t key_count, size_t key
                  indx);
 }
 
-void Context::assemble0(uint8_t opcode) const { this->cfunction()->bytecode()->vectorPushExtend(opcode); }
+void Context::assemble0(uint8_t opcode) const {
+  Cfunction_sp cfunction = this->cfunction();
+  cfunction->_last_op_position = cfunction->bytecode()->length();
+  cfunction->_last_op_annotations = cfunction->annotations()->length();
+  cfunction->bytecode()->vectorPushExtend(opcode);
+}
 
 void Context::assemble1(uint8_t opcode, size_t operand) const {
   ComplexVector_byte8_t_sp bytecode = this->cfunction()->bytecode();
   if (operand < (1 << 8)) {
+    this->cfunction()->_last_op_position = bytecode->length();
+    this->cfunction()->_last_op_annotations = this->cfunction()->annotations()->length();
     bytecode->vectorPushExtend(opcode);
     bytecode->vectorPushExtend(operand);
   } else if (operand < (1 << 16)) {
@@ -596,6 +603,8 @@ void Context::assemble1(uint8_t opcode, size_t operand) const {
 void Context::assemble2(uint8_t opcode, size_t operand1, size_t operand2) const {
   ComplexVector_byte8_t_sp bytecode = this->cfunction()->bytecode();
   if ((operand1 < (1 << 8)) && (operand2 < (1 << 8))) {
+    this->cfunction()->_last_op_position = bytecode->length();
+    this->cfunction()->_last_op_annotations = this->cfunction()->annotations()->length();
     bytecode->vectorPushExtend(opcode);
     bytecode->vectorPushExtend(operand1);
     bytecode->vectorPushExtend(operand2);
@@ -651,6 +660,37 @@ void Context::emit_mv_call() const {
   }
 }
 
+// Is the last thing emitted an instruction OPCODE of SIZE bytes, with
+// nothing emitted after it that could be jumped to or resized? If so, a
+// following instruction can be fused into it. Labels that only delimit
+// debug info are fine.
+bool Context::last_op_p(uint8_t opcode, size_t size) const {
+  Cfunction_sp cfunction = this->cfunction();
+  ComplexVector_byte8_t_sp bytecode = cfunction->bytecode();
+  ComplexVector_T_sp annotations = cfunction->annotations();
+  size_t position = cfunction->_last_op_position;
+  if (position >= bytecode->length() || position + size != bytecode->length() || (*bytecode)[position] != opcode)
+    return false;
+  for (size_t i = cfunction->_last_op_annotations; i < annotations->length(); ++i) {
+    T_sp annotation = (*annotations)[i];
+    if (!gc::IsA<Label_sp>(annotation) || gc::As_unsafe<Label_sp>(annotation)->_jump_target_p)
+      return false;
+  }
+  return true;
+}
+
+void Context::emit_return() const {
+  // pop; return and call n; return end most functions, so they have
+  // their own superinstructions.
+  ComplexVector_byte8_t_sp bytecode = this->cfunction()->bytecode();
+  if (this->last_op_p(vm_pop, 1))
+    (*bytecode)[this->cfunction()->_last_op_position] = vm_pop_return;
+  else if (this->last_op_p(vm_call, 2))
+    (*bytecode)[this->cfunction()->_last_op_position] = vm_call_return;
+  else
+    this->assemble0(vm_return);
+}
+
 void Context::emit_special_bind(Symbol_sp sym) const { this->assemble1(vm_special_bind, this->vcell_index(sym)); }
 
 void Context::emit_unbind(size_t count) const {
@@ -1784,9 +1824,9 @@ void compile_with_lambda_list(T_sp lambda_list, List_sp body, Lexenv_sp env, con
 
   entry_point->contextualize(context);
   // Generate argument count check.
-  if ((min_count > 0) && (min_count == max_count) && !morep)
-    context.assemble1(vm_check_arg_count_EQ, min_count);
-  else {
+  // An exact count is checked along with binding the required arguments, below.
+  bool exact_count_p = (min_count > 0) && (min_count == max_count) && !morep;
+  if (!exact_count_p) {
     if (min_count > 0)
       context.assemble1(vm_check_arg_count_GE, min_count);
     if (!morep)
@@ -1795,7 +1835,7 @@ void compile_with_lambda_list(T_sp lambda_list, List_sp body, Lexenv_sp env, con
   if (min_count > 0) {
     Label_sp begin_label = Label_O::make();
     // Bind the required arguments.
-    context.assemble1(vm_bind_required_args, min_count);
+    context.assemble1(exact_count_p ? vm_check_and_bind_required_args : vm_bind_required_args, min_count);
     ql::list debugbindings;
     ql::list debugdecls;
     ql::list sreqs; // required parameters that are special
@@ -1991,7 +2031,7 @@ CL_DEFUN Cfunction_sp compile_lambda(T_sp lambda_list, List_sp body, Lexenv_sp e
   // We pass the original body w/declarations to compile-with-lambda-list
   // so that it can do its own handling of specials, etc.
   compile_with_lambda_list(lambda_list, body, lenv, context);
-  context.assemble0(vm_return);
+  context.emit_return();
   if (all_declares.notnilp() || source_info.notnilp())
     end->contextualize(context);
   return function;
@@ -767,9 +767,25 @@ CL_DEFUN core::T_sp core__load_faso(T_sp pathDesig, T_sp verbose, T_sp print, T_
   close(fd); // Ok to close file descriptor after mmap
   llvmo::ClaspJIT_sp jit = gc::As<llvmo::ClaspJIT_sp>(_lisp->_Roots._ClaspJIT);
   FasoHeader* header = (FasoHeader*)memory;
+  bool batch = _sym_STARfaso_batch_linkSTAR->symbolValue().notnilp();
   llvmo::JITDylib_sp jitDylib;
+  // In batch mode the object files of each JITDylib are added first and their
+  // startup functions looked up together, then run in their original order.
+  std::vector<std::string> startupNames;
+  std::vector<void*> startups;
+  auto runBatch = [&]() {
+    if (startupNames.empty())
+      return;
+    jit->lookup_all(jitDylib, startupNames, startups);
+    for (size_t ii = 0; ii < startups.size(); ++ii) {
+      DEBUG_OBJECT_FILES_PRINT(("%s:%d:%s running startup %s\n", __FILE__, __LINE__, __FUNCTION__, startupNames[ii].c_str()));
+      jit->runStartupFunction(startups[ii], unbound<core::T_O>());
+    }
+    startupNames.clear();
+  };
   for (size_t fasoIndex = 0; fasoIndex < header->_NumberOfObjectFiles; ++fasoIndex) {
     if (!jitDylib || header->_ObjectFiles[fasoIndex]._ObjectId == 0) {
+      runBatch();
       jitDylib = jit->createAndRegisterJITDylib(filename);
     }
     void* of_start = (void*)((char*)header + header->_ObjectFiles[fasoIndex]._StartPage * header->_PageSize);
@@ -788,10 +804,15 @@ CL_DEFUN core::T_sp core__load_faso(T_sp pathDesig, T_sp verbose, T_sp print, T_
     //    objectFile.raw_(), lisp_badge(objectFile), jitDylib.raw_());
     T_mv startupName = core__startup_linkage_shutdown_names(header->_ObjectFiles[fasoIndex]._ObjectId, nil<core::T_O>());
     String_sp startupName_str = gc::As<String_sp>(startupName);
+    if (batch) {
+      startupNames.push_back(startupName_str->get_std_string());
+      continue;
+    }
     DEBUG_OBJECT_FILES_PRINT(
         ("%s:%d:%s running startup %s\n", __FILE__, __LINE__, __FUNCTION__, startupName_str->get_std_string().c_str()));
     jit->runStartupCode(jitDylib, startupName_str->get_std_string(), unbound<core::T_O>());
   }
+  runBatch();
   return _lisp->_true();
 }
 
@@ -799,7 +820,27 @@ int global_jit_pid = -1;
 FILE* global_jit_log_stream = NULL;
 bool global_jit_log_symbols = false;
 
-void jit_register_symbol(const std::string& name, size_t size, void* address) {
+// Append the perf map line for one symbol to OUT.
+static void append_perf_map_line(std::string& out, const std::string& name, size_t size, void* address) {
+  char nameBuffer[1024];
+  char* namecur = nameBuffer;
+  char prevchar = ' ';
+  for (int i = 0; i < name.size() && i < 1023; i++) {
+    if (name[i] == '\r')
+      continue;
+    if (name[i] == '\n')
+      continue;
+    if (name[i] < 32 && name[i] == prevchar)
+      continue;
+    *namecur = name[i];
+    prevchar = name[i];
+    namecur++;
+  }
+  *namecur = '\0';
+  out += fmt::format("{:x} {:x} {}\n", (uintptr_t)address, size, nameBuffer);
+}
+
+static void write_perf_map(const std::string& lines) {
   WITH_READ_WRITE_LOCK(globals_->_JITLogMutex);
   int gpid = getpid();
   if (global_jit_log_stream && (global_jit_pid != gpid)) {
@@ -814,26 +855,27 @@ void jit_register_symbol(const std::string& name, size_t size, void* address) {
     global_jit_log_stream = fopen(filename.str().c_str(), "w");
   }
   if (global_jit_log_stream) {
-    char nameBuffer[1024];
-    char* namecur = nameBuffer;
-    char prevchar = ' ';
-    for (int i = 0; i < name.size() && i < 1023; i++) {
-      if (name[i] == '\r')
-        continue;
-      if (name[i] == '\n')
-        continue;
-      if (name[i] < 32 && name[i] == prevchar)
-        continue;
-      *namecur = name[i];
-      prevchar = name[i];
-      namecur++;
-    }
-    *namecur = '\0';
-    fprintf(global_jit_log_stream, "%0lx %lx %s\n", (uintptr_t)address, size, nameBuffer);
+    fwrite(lines.data(), 1, lines.size(), global_jit_log_stream);
     fflush(global_jit_log_stream);
   }
 }
 
+void jit_register_symbol(const std::string& name, size_t size, void* address) {
+  std::string line;
+  append_perf_map_line(line, name, size, address);
+  write_perf_map(line);
+}
+
+void jit_register_symbols(const std::vector<JITLogSymbol>& symbols) {
+  if (!global_jit_log_symbols || symbols.empty())
+    return;
+  // Formatted outside of the lock, and written and flushed once
+  std::string lines;
+  for (auto& sym : symbols)
+    append_perf_map_line(lines, sym._Name, sym._Size, sym._Address);
+  write_perf_map(lines);
+}
+
 CL_DEFUN void core__jit_register_symbol(const std::string& name, size_t size, void* address) {
   if (global_jit_log_symbols) {
     jit_register_symbol(name, size, address);
@@ -161,6 +161,7 @@ SYMBOL_EXPORT_SC_(CorePkg, STARenablePrintPrettySTAR);
 SYMBOL_EXPORT_SC_(CorePkg, STARenvironment_debugSTAR);
 SYMBOL_EXPORT_SC_(CorePkg, STARexit_backtraceSTAR);
 SYMBOL_EXPORT_SC_(CorePkg, STARextension_systemsSTAR);
+SYMBOL_EXPORT_SC_(CorePkg, STARfaso_batch_linkSTAR);
 SYMBOL_EXPORT_SC_(CorePkg, STARfunctions_to_inlineSTAR);
 SYMBOL_EXPORT_SC_(CorePkg, STARfunctions_to_notinlineSTAR);
 SYMBOL_EXPORT_SC_(CorePkg, STARihs_baseSTAR);
@@ -618,6 +619,7 @@ void CoreExposer_O::define_essential_globals(LispPtr lisp) {
   _sym_STARdebugLoadTimeValuesSTAR->defparameter(nil<T_O>());
   _sym_STARdebugEvalSTAR->defparameter(nil<T_O>());
   _sym_STARdebugStartupSTAR->defparameter(nil<T_O>());
+  _sym_STARfaso_batch_linkSTAR->defparameter(_lisp->_true());
   _sym_STARdebugInterpretedFunctionsSTAR->defparameter(nil<T_O>());
   _sym_STARuseInterpreterForEvalSTAR->defparameter(nil<T_O>()); // _lisp->_true());
   _sym_STARcxxDocumentationSTAR->defparameter(nil<T_O>());
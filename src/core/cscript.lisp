@@ -1,6 +1,8 @@
 (k:sources :iclasp
            #~"dummy.cc"
            #~"mpPackage.cc"
+           #~"fiber.cc"
+           #~"lockProfiler.cc"
            #~"nativeVector.cc"
            #~"evaluator.cc"
            #~"function.cc"
@@ -0,0 +1,810 @@
+/*
+    File: fiber.cc
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+
+// Fibers: stackful coroutines multiplexed onto a few carrier processes.
+//
+// A switch saves the running context's registers with swapcontext and
+// moves the per-thread state that belongs to a flow of control - the
+// special binding vector, the dynamic environment, the pending unwind and
+// the bytecode VM stack - between the ThreadLocalState and the contexts.
+// The invariant is that a context's saved slots hold its state while it
+// is suspended and are empty while it runs.
+//
+// The GC sees the running context's C stack as the thread's stack, by way
+// of GC_set_stackbottom. Suspended C stacks, all fiber VM stacks and the
+// contexts themselves are pushed from a push_other_roots callback. Switches
+// happen with the GC allocation lock held, so a collection never sees a
+// thread halfway between two stacks.
+
+#if defined(__APPLE__)
+#define _XOPEN_SOURCE 600 // for ucontext
+#endif
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <climits>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#include <clasp/core/foundation.h>
+#include <clasp/core/object.h>
+#include <clasp/core/lisp.h>
+#include <clasp/gctools/memoryManagement.h>
+#include <clasp/core/symbol.h>
+#include <clasp/core/mpPackage.h>
+#include <clasp/core/array.h>
+#include <clasp/core/multipleValues.h>
+#include <clasp/core/primitives.h>
+#include <clasp/core/designators.h>
+#include <clasp/core/lispList.h>
+#include <clasp/gctools/interrupt.h>
+#include <clasp/core/evaluator.h>
+#include <clasp/core/unwind.h>
+#include <clasp/core/wrappers.h>
+
+namespace mp {
+
+// Compiled Lisp frames are large, so be generous; untouched stack pages
+// cost nothing but address space.
+static constexpr size_t DefaultFiberStackBytes = 1024 * 1024;
+static constexpr size_t FiberVMStackBytes = 1024 * 1024;
+
+struct FiberContext {
+  ucontext_t _Registers;
+  // One mapping holding, from low to high, a guard page, the C stack and
+  // the VM stack, so that a fiber costs the kernel two memory areas.
+  // NULL for the context of a carrier, which runs on the process's own
+  // stack.
+  void* _Mapping;
+  size_t _MappingBytes;
+  void* _StackHigh;
+  // While suspended, the lowest address of the C stack that may hold
+  // live data; NULL while running.
+  void* _SavedSP;
+  // Saved thread state; see the comment at the top of the file.
+  gctools::Vec0<core::T_sp> _Bindings;
+  core::List_sp _DynEnv;
+  core::T_sp _UnwindDest;
+  size_t _UnwindDestIndex;
+  void* _LowLevelStackTop;
+  core::VirtualMachine _VM;
+  // Where this context's VM registers live right now.
+  core::VirtualMachine* _LiveVM;
+  FiberContext* _Prev;
+  FiberContext* _Next;
+  FiberContext()
+      : _Mapping(NULL), _MappingBytes(0), _StackHigh(NULL), _SavedSP(NULL), _Bindings(true), _DynEnv(nil<core::T_O>()),
+        _UnwindDest(nil<core::T_O>()), _UnwindDestIndex(0), _LowLevelStackTop(NULL), _LiveVM(NULL), _Prev(NULL), _Next(NULL){};
+};
+
+struct Carrier {
+  void* _GCHandle;
+  FiberContext* _Context;
+  Fiber_O* _CurrentFiber;
+};
+
+static thread_local Carrier* my_carrier = NULL;
+
+static std::atomic<uint64_t> global_NextWaitToken(1);
+
+static Fiber_O* current_fiber() {
+  if (my_carrier && my_carrier->_CurrentFiber)
+    return my_carrier->_CurrentFiber;
+  SIMPLE_ERROR("This can only be done in a fiber");
+}
+
+static double monotonic_now() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static double timeout_seconds(core::T_sp timeout) {
+  return timeout.nilp() ? -1.0 : std::max(0.0, core::clasp_to_double(gc::As<core::Real_sp>(timeout)));
+}
+
+#ifdef USE_BOEHM
+
+// All live contexts; only touched with the GC allocation lock held.
+static FiberContext* global_Contexts = NULL;
+static GC_push_other_roots_proc global_PreviousPushOtherRoots = NULL;
+
+static void push_fiber_roots() {
+  for (FiberContext* context = global_Contexts; context; context = context->_Next) {
+    GC_push_all((void*)context, (void*)(context + 1));
+    if (context->_SavedSP)
+      GC_push_all(context->_SavedSP, context->_StackHigh);
+    // Carriers' own VM stacks are registered roots already.
+    core::VirtualMachine* vm = context->_LiveVM;
+    if (context->_Mapping && vm && vm->_stackBottom)
+      GC_push_all((void*)vm->_stackBottom, (void*)((uintptr_t)vm->_stackBottom + vm->_stackBytes));
+  }
+  if (global_PreviousPushOtherRoots)
+    global_PreviousPushOtherRoots();
+}
+
+static void register_context(FiberContext* context) {
+  static std::once_flag installed;
+  std::call_once(installed, []() {
+    GC_alloc_lock();
+    global_PreviousPushOtherRoots = GC_get_push_other_roots();
+    GC_set_push_other_roots(push_fiber_roots);
+    GC_alloc_unlock();
+  });
+  GC_alloc_lock();
+  context->_Next = global_Contexts;
+  if (global_Contexts)
+    global_Contexts->_Prev = context;
+  global_Contexts = context;
+  GC_alloc_unlock();
+}
+
+static void unregister_context(FiberContext* context) {
+  GC_alloc_lock();
+  if (context->_Prev)
+    context->_Prev->_Next = context->_Next;
+  else
+    global_Contexts = context->_Next;
+  if (context->_Next)
+    context->_Next->_Prev = context->_Prev;
+  GC_alloc_unlock();
+}
+
+static void swap_thread_state(FiberContext* from, FiberContext* to) {
+  core::ThreadLocalState* thread = my_thread;
+  thread->_Bindings._ThreadLocalBindings.swap(from->_Bindings);
+  thread->_Bindings._ThreadLocalBindings.swap(to->_Bindings);
+  from->_DynEnv = thread->_DynEnvStackBottom;
+  thread->_DynEnvStackBottom = to->_DynEnv;
+  to->_DynEnv = nil<core::T_O>();
+  from->_UnwindDest = thread->_UnwindDest;
+  thread->_UnwindDest = to->_UnwindDest;
+  to->_UnwindDest = nil<core::T_O>();
+  from->_UnwindDestIndex = thread->_UnwindDestIndex;
+  thread->_UnwindDestIndex = to->_UnwindDestIndex;
+  thread->_VM.swap(from->_VM);
+  thread->_VM.swap(to->_VM);
+  from->_LiveVM = &from->_VM;
+  to->_LiveVM = &thread->_VM;
+  from->_LowLevelStackTop = my_thread_low_level->_StackTop;
+  my_thread_low_level->_StackTop = to->_LowLevelStackTop;
+}
+
+__attribute__((noinline)) static void switch_context(Carrier* carrier, FiberContext* from, FiberContext* to) {
+  void* marker = NULL;
+  GC_alloc_lock();
+  from->_SavedSP = (void*)((uintptr_t)&marker & ~(uintptr_t)(sizeof(void*) - 1));
+  to->_SavedSP = NULL;
+  struct GC_stack_base base = {};
+  base.mem_base = to->_StackHigh;
+  GC_set_stackbottom(carrier->_GCHandle, &base);
+  swap_thread_state(from, to);
+  swapcontext(&from->_Registers, &to->_Registers);
+  // Back in FROM. Whoever switched to us took the lock.
+  GC_alloc_unlock();
+}
+
+static void fiber_start(unsigned int high, unsigned int low) {
+  Fiber_O* raw = (Fiber_O*)(((uintptr_t)high << 32) | (uintptr_t)low);
+  GC_alloc_unlock();
+  raw->run();
+  raw->finish();
+  Carrier* carrier = my_carrier;
+  switch_context(carrier, raw->_Context, carrier->_Context);
+  printf("%s:%d:%s A finished fiber was resumed\n", __FILE__, __LINE__, __FUNCTION__);
+  abort();
+}
+
+static FiberContext* make_fiber_context(Fiber_O* fiber, size_t stackBytes) {
+  size_t pageSize = getpagesize();
+  stackBytes = (std::max(stackBytes, (size_t)(16 * pageSize)) + pageSize - 1) / pageSize * pageSize;
+  size_t mappingBytes = pageSize + stackBytes + FiberVMStackBytes;
+  void* mapping = mmap(NULL, mappingBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mapping == MAP_FAILED)
+    SIMPLE_ERROR("Could not allocate {} bytes of fiber stacks - errno {}", mappingBytes, errno);
+  // The C stack grows down toward the guard page; the VM stack above it
+  // grows up and checks its own limit.
+  mprotect(mapping, pageSize, PROT_NONE);
+  FiberContext* context = new FiberContext();
+  context->_Mapping = mapping;
+  context->_MappingBytes = mappingBytes;
+  context->_StackHigh = (void*)((uintptr_t)mapping + pageSize + stackBytes);
+  context->_LowLevelStackTop = context->_StackHigh;
+  context->_VM._registerRoots = false;
+  context->_VM.startup_in(context->_StackHigh, FiberVMStackBytes);
+  context->_LiveVM = &context->_VM;
+  getcontext(&context->_Registers);
+  context->_Registers.uc_stack.ss_sp = (void*)((uintptr_t)mapping + pageSize);
+  context->_Registers.uc_stack.ss_size = stackBytes;
+  context->_Registers.uc_link = NULL;
+  uintptr_t address = (uintptr_t)fiber;
+  makecontext(&context->_Registers, (void (*)())fiber_start, 2, (unsigned int)(address >> 32),
+              (unsigned int)(address & 0xffffffff));
+  register_context(context);
+  return context;
+}
+
+static void destroy_fiber_context(FiberContext* context) {
+  unregister_context(context);
+  munmap(context->_Mapping, context->_MappingBytes); // both stacks
+  delete context;
+}
+
+#endif // USE_BOEHM
+
+// Timers and descriptor waits. Fibers are found by wait token. A fiber in
+// here is parked and so kept alive by its own suspended stack.
+struct FiberWaits {
+  std::mutex _Mutex;
+  std::unordered_map<uint64_t, Fiber_O*> _Waiters;
+  std::multimap<double, uint64_t> _Timers;
+};
+
+static FiberWaits* waits(FiberScheduler_O* scheduler) { return (FiberWaits*)scheduler->_Waits; }
+
+static void add_waiter(FiberScheduler_O* scheduler, uint64_t token, Fiber_O* fiber, double timeout) {
+  FiberWaits* w = waits(scheduler);
+  bool earliest = false;
+  {
+    std::lock_guard<std::mutex> guard(w->_Mutex);
+    w->_Waiters[token] = fiber;
+    if (timeout >= 0.0) {
+      double deadline = monotonic_now() + timeout;
+      earliest = w->_Timers.empty() || deadline < w->_Timers.begin()->first;
+      w->_Timers.emplace(deadline, token);
+    }
+  }
+  if (earliest)
+    scheduler->wake_reactor();
+}
+
+static void remove_waiter(FiberScheduler_O* scheduler, uint64_t token) {
+  FiberWaits* w = waits(scheduler);
+  std::lock_guard<std::mutex> guard(w->_Mutex);
+  w->_Waiters.erase(token);
+}
+
+static void wake_waiter(FiberScheduler_O* scheduler, uint64_t token, Fiber_O::Wake reason) {
+  Fiber_O* fiber = NULL;
+  {
+    FiberWaits* w = waits(scheduler);
+    std::lock_guard<std::mutex> guard(w->_Mutex);
+    auto it = w->_Waiters.find(token);
+    if (it == w->_Waiters.end())
+      return;
+    fiber = it->second;
+    w->_Waiters.erase(it);
+  }
+  fiber->wake(token, reason);
+}
+
+//
+// Fiber_O
+//
+
+void Fiber_O::lock_joiners() {
+  while (this->_JoinLock.exchange(true, std::memory_order_acquire))
+    sched_yield();
+}
+
+uint64_t Fiber_O::begin_wait() {
+  this->_State.store(Parked);
+  this->_WakeReason.store(WakeNone);
+  uint64_t token = global_NextWaitToken.fetch_add(1);
+  this->_WaitToken.store(token, std::memory_order_seq_cst);
+  return token;
+}
+
+bool Fiber_O::wake(uint64_t token, Wake reason) {
+  uint64_t expected = token;
+  if (token == 0 || !this->_WaitToken.compare_exchange_strong(expected, 0, std::memory_order_seq_cst))
+    return false;
+  this->_WakeReason.store(reason);
+  this->_State.store(Runnable);
+  this->_Scheduler->make_runnable(this->asSmartPtr());
+  return true;
+}
+
+Fiber_O::Wake Fiber_O::park_current() {
+#ifdef USE_BOEHM
+  // If we were woken already we are in the run queue, and the carrier
+  // will switch right back to us.
+  Carrier* carrier = my_carrier;
+  switch_context(carrier, this->_Context, carrier->_Context);
+#endif
+  return (Wake)this->_WakeReason.load();
+}
+
+static core::T_mv run_with_bindings(Fiber_O* fiber, core::List_sp bindings) {
+  if (bindings.consp()) {
+    core::Cons_sp pair = gc::As<core::Cons_sp>(CONS_CAR(bindings));
+    core::DynamicScopeManager scope(gc::As<core::Symbol_sp>(pair->car()), core::eval::evaluate(pair->cdr(), nil<core::T_O>()));
+    return run_with_bindings(fiber, CONS_CDR(bindings));
+  }
+  return core::core__apply0(core::coerce::calledFunctionDesignator(fiber->_Function), nil<core::T_O>());
+}
+
+void Fiber_O::run() {
+  Fiber_sp me = this->asSmartPtr();
+  // Fibers start with no bindings of their own, but they do run in the
+  // carrier's process.
+  core::DynamicScopeManager scope(_sym_STARcurrent_processSTAR, my_thread->_Process);
+  try {
+    core::T_mv result_mv = run_with_bindings(this, this->_SpecialBindings);
+    ql::list values;
+    int nv = result_mv.number_of_values();
+    core::MultipleValues& mv = core::lisp_multipleValues();
+    if (nv > 0) {
+      core::T_sp result0 = result_mv;
+      values << result0;
+      for (int i = 1; i < nv; ++i)
+        values << mv.valueGet(i, nv);
+    }
+    this->_Result = values.result();
+  } catch (...) {
+    // EXIT-PROCESS, ABORT-PROCESS or a foreign exception. Nothing may
+    // unwind past the start of the fiber's stack.
+    this->_Result = nil<core::T_O>();
+  }
+}
+
+void Fiber_O::finish() {
+  this->lock_joiners();
+  this->_State.store(Finished);
+  core::List_sp joiners = this->_Joiners;
+  this->_Joiners = nil<core::T_O>();
+  this->unlock_joiners();
+  this->_Done.store(1, std::memory_order_seq_cst);
+  futex_wake(&this->_Done, INT_MAX);
+  for (auto cur : joiners) {
+    Fiber_sp joiner = gc::As<Fiber_sp>(CONS_CAR(cur));
+    joiner->_Permit.store(true);
+    joiner->wake(joiner->_WaitToken.load(), WakeUnpark);
+  }
+}
+
+string Fiber_O::__repr__() const {
+  stringstream ss;
+  ss << "#<FIBER " << _rep_(this->_Name) << ">";
+  return ss.str();
+}
+
+// Fibers do not survive a snapshot; ones that were still running come
+// back finished with no values.
+void Fiber_O::fixupInternalsForSnapshotSaveLoad(snapshotSaveLoad::Fixup* fixup) {
+  if (snapshotSaveLoad::operation(fixup) == snapshotSaveLoad::LoadOp) {
+    this->_Context = NULL;
+    if (this->_State.load() != Finished)
+      this->_Result = nil<core::T_O>();
+    this->_State.store(Finished);
+    this->_WaitToken.store(0);
+    this->_JoinLock.store(false);
+    this->_Done.store(1);
+  }
+}
+
+//
+// FiberScheduler_O
+//
+
+FiberScheduler_O::FiberScheduler_O(core::T_sp name, size_t carriers, size_t stack_bytes)
+    : _Name(name), _Processes(nil<core::T_O>()), _StackBytes(stack_bytes ? stack_bytes : DefaultFiberStackBytes), _NextCarrier(0),
+      _Shutdown(false), _PollFd(-1) {
+  this->_RunQueues = core::SimpleVector_O::make(carriers, nil<core::T_O>());
+  for (size_t i = 0; i < carriers; ++i)
+    (*this->_RunQueues)[i] = ConcurrentQueue_O::make_concurrent_queue(name, nil<core::T_O>());
+  this->_Live = new std::atomic<int64_t>[carriers];
+  for (size_t i = 0; i < carriers; ++i)
+    this->_Live[i].store(0);
+  this->_Waits = new FiberWaits();
+  if (pipe(this->_WakePipe) != 0)
+    SIMPLE_ERROR("Could not create the wakeup pipe of a fiber scheduler - errno {}", errno);
+  fcntl(this->_WakePipe[0], F_SETFL, O_NONBLOCK);
+  fcntl(this->_WakePipe[1], F_SETFL, O_NONBLOCK);
+#ifdef __linux__
+  this->_PollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (this->_PollFd < 0)
+    SIMPLE_ERROR("Could not create the epoll descriptor of a fiber scheduler - errno {}", errno);
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.u64 = 0; // tokens start at 1
+  epoll_ctl(this->_PollFd, EPOLL_CTL_ADD, this->_WakePipe[0], &event);
+#endif
+}
+
+FiberScheduler_O::~FiberScheduler_O() {
+  delete[] this->_Live;
+  delete waits(this);
+  if (this->_WakePipe[0] >= 0) {
+    close(this->_WakePipe[0]);
+    close(this->_WakePipe[1]);
+  }
+  if (this->_PollFd >= 0)
+    close(this->_PollFd);
+}
+
+// The native parts of a scheduler do not survive a snapshot, and neither
+// do its processes; it comes back shut down.
+void FiberScheduler_O::fixupInternalsForSnapshotSaveLoad(snapshotSaveLoad::Fixup* fixup) {
+  if (snapshotSaveLoad::operation(fixup) == snapshotSaveLoad::LoadOp) {
+    size_t carriers = this->carriers();
+    this->_Live = new std::atomic<int64_t>[carriers];
+    for (size_t i = 0; i < carriers; ++i)
+      this->_Live[i].store(0);
+    this->_Waits = new FiberWaits();
+    this->_WakePipe[0] = this->_WakePipe[1] = this->_PollFd = -1;
+    this->_Processes = nil<core::T_O>();
+    this->_Shutdown.store(true);
+  }
+}
+
+ConcurrentQueue_sp FiberScheduler_O::run_queue(size_t carrier) const {
+  return gc::As_unsafe<ConcurrentQueue_sp>((*this->_RunQueues)[carrier]);
+}
+
+void FiberScheduler_O::make_runnable(Fiber_sp fiber) { this->run_queue(fiber->_Carrier)->push(fiber); }
+
+void FiberScheduler_O::wake_reactor() {
+  char byte = 0;
+  (void)!write(this->_WakePipe[1], &byte, 1);
+}
+
+string FiberScheduler_O::__repr__() const {
+  stringstream ss;
+  ss << "#<FIBER-SCHEDULER " << _rep_(this->_Name) << " :carriers " << this->carriers() << ">";
+  return ss.str();
+}
+
+CL_LAMBDA(name carriers stack-size);
+CL_DOCSTRING(R"dx(Make a fiber scheduler with CARRIERS run queues and no processes yet. STACK-SIZE is the size in bytes of each fiber's C stack, or zero for the default.)dx");
+DOCGROUP(clasp);
+CL_DEFUN FiberScheduler_sp mp__PERCENTmake_fiber_scheduler(core::T_sp name, size_t carriers, size_t stack_size) {
+#ifndef USE_BOEHM
+  SIMPLE_ERROR("Fibers are only supported with the Boehm garbage collector");
+#endif
+  if (carriers < 1)
+    SIMPLE_ERROR("A fiber scheduler needs at least one carrier");
+  return gctools::GC<FiberScheduler_O>::allocate(name, carriers, stack_size);
+}
+
+DOCGROUP(clasp);
+CL_DEFUN void mp__PERCENTfiber_scheduler_set_processes(FiberScheduler_sp scheduler, core::List_sp processes) {
+  scheduler->_Processes = processes;
+}
+
+CL_DOCSTRING(R"dx(Return the carrier and reactor processes of SCHEDULER.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::List_sp mp__fiber_scheduler_processes(FiberScheduler_sp scheduler) { return scheduler->_Processes; }
+
+CL_DOCSTRING(R"dx(Return the name of SCHEDULER.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_sp mp__fiber_scheduler_name(FiberScheduler_sp scheduler) { return scheduler->_Name; }
+
+CL_DOCSTRING(R"dx(Return the number of carrier processes of SCHEDULER.)dx");
+DOCGROUP(clasp);
+CL_DEFUN size_t mp__fiber_scheduler_carriers(FiberScheduler_sp scheduler) { return scheduler->carriers(); }
+
+SYMBOL_EXPORT_SC_(KeywordPkg, quit);
+
+CL_DOCSTRING(R"dx(Ask the processes of SCHEDULER to exit. Carriers exit once all of their fibers have finished.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void mp__PERCENTfiber_scheduler_shutdown(FiberScheduler_sp scheduler) {
+  if (scheduler->_Shutdown.exchange(true))
+    return;
+  for (size_t i = 0; i < scheduler->carriers(); ++i)
+    scheduler->run_queue(i)->push(kw::_sym_quit);
+  scheduler->wake_reactor();
+}
+
+CL_DOCSTRING(R"dx(Run the fibers of carrier INDEX of SCHEDULER until it is shut down. This is the function of each carrier process.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void mp__PERCENTfiber_carrier_loop(FiberScheduler_sp scheduler, size_t index) {
+#ifdef USE_BOEHM
+  Carrier carrier;
+  struct GC_stack_base base;
+  carrier._GCHandle = GC_get_my_stackbottom(&base);
+  FiberContext* own = new FiberContext();
+  own->_StackHigh = base.mem_base;
+  own->_LiveVM = &my_thread->_VM;
+  register_context(own);
+  carrier._Context = own;
+  carrier._CurrentFiber = NULL;
+  my_carrier = &carrier;
+  ConcurrentQueue_sp queue = scheduler->run_queue(index);
+  bool quitting = false;
+  while (!quitting || scheduler->_Live[index].load() > 0) {
+    core::T_sp item;
+    queue->pop_wait(item, -1.0);
+    if (gc::IsA<Fiber_sp>(item)) {
+      Fiber_sp fiber = gc::As_unsafe<Fiber_sp>(item);
+      if (!fiber->_Context)
+        continue;
+      fiber->_State.store(Fiber_O::Running);
+      carrier._CurrentFiber = &*fiber;
+      switch_context(&carrier, own, fiber->_Context);
+      carrier._CurrentFiber = NULL;
+      if (fiber->_State.load() == Fiber_O::Finished) {
+        destroy_fiber_context(fiber->_Context);
+        fiber->_Context = NULL;
+        scheduler->_Live[index].fetch_sub(1);
+      }
+    } else
+      quitting = true;
+  }
+  my_carrier = NULL;
+  unregister_context(own);
+  delete own;
+#else
+  SIMPLE_ERROR("Fibers are only supported with the Boehm garbage collector");
+#endif
+}
+
+CL_DOCSTRING(R"dx(Serve the timers and descriptor waits of SCHEDULER until it is shut down.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void mp__PERCENTfiber_reactor_loop(FiberScheduler_sp scheduler) {
+  FiberWaits* w = waits(&*scheduler);
+  while (!scheduler->_Shutdown.load()) {
+    int milliseconds = -1;
+    {
+      std::lock_guard<std::mutex> guard(w->_Mutex);
+      if (!w->_Timers.empty())
+        milliseconds = std::max(0, (int)std::ceil((w->_Timers.begin()->first - monotonic_now()) * 1000.0));
+    }
+#ifdef __linux__
+    struct epoll_event events[64];
+    int n = epoll_wait(scheduler->_PollFd, events, 64, milliseconds);
+    for (int i = 0; i < n; ++i) {
+      if (events[i].data.u64 == 0) {
+        char buffer[64];
+        while (read(scheduler->_WakePipe[0], buffer, sizeof(buffer)) > 0)
+          ;
+      } else
+        wake_waiter(&*scheduler, events[i].data.u64, Fiber_O::WakeReady);
+    }
+#else
+    struct pollfd wake = {scheduler->_WakePipe[0], POLLIN, 0};
+    if (poll(&wake, 1, milliseconds) > 0) {
+      char buffer[64];
+      while (read(scheduler->_WakePipe[0], buffer, sizeof(buffer)) > 0)
+        ;
+    }
+#endif
+    double now = monotonic_now();
+    std::vector<uint64_t> expired;
+    {
+      std::lock_guard<std::mutex> guard(w->_Mutex);
+      while (!w->_Timers.empty() && w->_Timers.begin()->first <= now) {
+        expired.push_back(w->_Timers.begin()->second);
+        w->_Timers.erase(w->_Timers.begin());
+      }
+    }
+    for (uint64_t token : expired)
+      wake_waiter(&*scheduler, token, Fiber_O::WakeTimeout);
+    gctools::handle_all_queued_interrupts();
+  }
+}
+
+CL_LAMBDA(scheduler name function special-bindings);
+CL_DOCSTRING(R"dx(Make a fiber that will call FUNCTION with no arguments on a carrier of SCHEDULER, and make it runnable. SPECIAL-BINDINGS is an alist of (symbol . form) as for PROCESS-RUN-FUNCTION.)dx");
+DOCGROUP(clasp);
+CL_DEFUN Fiber_sp mp__PERCENTmake_fiber(FiberScheduler_sp scheduler, core::T_sp name, core::T_sp function,
+                                        core::List_sp special_bindings) {
+#ifdef USE_BOEHM
+  if (scheduler->_Shutdown.load())
+    SIMPLE_ERROR("Cannot start a fiber in {}; it has been shut down", _rep_(scheduler));
+  size_t carrier = scheduler->_NextCarrier.fetch_add(1) % scheduler->carriers();
+  Fiber_sp fiber = gctools::GC<Fiber_O>::allocate(name, function, special_bindings, scheduler, carrier);
+  fiber->_Context = make_fiber_context(&*fiber, scheduler->_StackBytes);
+  scheduler->_Live[carrier].fetch_add(1);
+  scheduler->make_runnable(fiber);
+  return fiber;
+#else
+  SIMPLE_ERROR("Fibers are only supported with the Boehm garbage collector");
+#endif
+}
+
+CL_DOCSTRING(R"dx(Return the fiber that is running, or NIL outside of a fiber.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_sp mp__current_fiber() {
+  if (my_carrier && my_carrier->_CurrentFiber)
+    return my_carrier->_CurrentFiber->asSmartPtr();
+  return nil<core::T_O>();
+}
+
+CL_DOCSTRING(R"dx(Return the name of FIBER.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_sp mp__fiber_name(Fiber_sp fiber) { return fiber->_Name; }
+
+SYMBOL_EXPORT_SC_(KeywordPkg, runnable);
+SYMBOL_EXPORT_SC_(KeywordPkg, parked);
+SYMBOL_EXPORT_SC_(KeywordPkg, finished);
+
+CL_DOCSTRING(R"dx(Return the state of FIBER: :RUNNABLE, :RUNNING, :PARKED or :FINISHED.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_sp mp__fiber_state(Fiber_sp fiber) {
+  switch (fiber->_State.load()) {
+  case Fiber_O::Runnable:
+    return kw::_sym_runnable;
+  case Fiber_O::Running:
+    return kw::_sym_running;
+  case Fiber_O::Parked:
+    return kw::_sym_parked;
+  default:
+    return kw::_sym_finished;
+  }
+}
+
+DOCGROUP(clasp);
+CL_DEFUN core::T_sp mp__PERCENTfiber_result(Fiber_sp fiber) { return fiber->_Result; }
+
+CL_DOCSTRING(R"dx(Let the other runnable fibers of this carrier run before continuing.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void mp__fiber_yield() {
+  Fiber_O* fiber = current_fiber();
+  uint64_t token = fiber->begin_wait();
+  fiber->wake(token, Fiber_O::WakeUnpark);
+  fiber->park_current();
+}
+
+CL_LAMBDA(&optional timeout);
+CL_DOCSTRING(R"dx(Suspend the current fiber until another thread or fiber calls FIBER-UNPARK on it, or until TIMEOUT seconds have passed if TIMEOUT is non-NIL. Return true if it was unparked. An unpark that comes before the park is not lost: the park returns at once.)dx");
+DOCGROUP(clasp);
+CL_DEFUN bool mp__fiber_park(core::T_sp timeout) {
+  Fiber_O* fiber = current_fiber();
+  if (fiber->_Permit.exchange(false))
+    return true;
+  double seconds = timeout_seconds(timeout);
+  uint64_t token = fiber->begin_wait();
+  if (fiber->_Permit.exchange(false) && fiber->wake(token, Fiber_O::WakeUnpark)) {
+    fiber->park_current();
+    return true;
+  }
+  if (seconds >= 0.0)
+    add_waiter(&*fiber->_Scheduler, token, fiber, seconds);
+  Fiber_O::Wake reason = fiber->park_current();
+  remove_waiter(&*fiber->_Scheduler, token);
+  if (reason == Fiber_O::WakeUnpark) {
+    fiber->_Permit.store(false);
+    return true;
+  }
+  return false;
+}
+
+CL_DOCSTRING(R"dx(Make FIBER runnable if it is parked in FIBER-PARK, or make its next FIBER-PARK return at once.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void mp__fiber_unpark(Fiber_sp fiber) {
+  fiber->_Permit.store(true);
+  uint64_t token = fiber->_WaitToken.load();
+  if (token)
+    fiber->wake(token, Fiber_O::WakeUnpark);
+}
+
+CL_DOCSTRING(R"dx(Suspend the current fiber for SECONDS seconds, letting the carrier run other fibers.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void mp__fiber_sleep(core::Real_sp seconds) {
+  Fiber_O* fiber = current_fiber();
+  uint64_t token = fiber->begin_wait();
+  add_waiter(&*fiber->_Scheduler, token, fiber, std::max(0.0, core::clasp_to_double(seconds)));
+  fiber->park_current();
+  remove_waiter(&*fiber->_Scheduler, token);
+}
+
+CL_LAMBDA(fd direction &optional timeout);
+CL_DOCSTRING(R"dx(Suspend the current fiber until the file descriptor FD is ready for DIRECTION (:INPUT or :OUTPUT), or until TIMEOUT seconds have passed if TIMEOUT is non-NIL. Return true if FD is ready.)dx");
+DOCGROUP(clasp);
+CL_DEFUN bool mp__fiber_wait_fd(int fd, core::Symbol_sp direction, core::T_sp timeout) {
+  Fiber_O* fiber = current_fiber();
+  short pollEvents;
+  if (direction == kw::_sym_input)
+    pollEvents = POLLIN;
+  else if (direction == kw::_sym_output)
+    pollEvents = POLLOUT;
+  else
+    SIMPLE_ERROR("Invalid direction {}, must be either :INPUT or :OUTPUT", _rep_(direction));
+  double seconds = timeout_seconds(timeout);
+  struct pollfd p = {fd, pollEvents, 0};
+  if (poll(&p, 1, 0) > 0)
+    return true;
+  if (seconds == 0.0)
+    return false;
+#ifdef __linux__
+  FiberScheduler_O* scheduler = &*fiber->_Scheduler;
+  uint64_t token = fiber->begin_wait();
+  struct epoll_event event = {};
+  event.events = (pollEvents == POLLIN ? EPOLLIN : EPOLLOUT) | EPOLLONESHOT;
+  event.data.u64 = token;
+  // Register the waiter before arming the one-shot event, or the reactor
+  // could see the event first, find no waiter and drop the wakeup.
+  add_waiter(scheduler, token, fiber, seconds);
+  // Another fiber may be waiting on FD for the other direction; epoll
+  // allows one registration per descriptor, so use a duplicate.
+  int registered = fd;
+  if (epoll_ctl(scheduler->_PollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+    int error = errno;
+    if (error == EEXIST && (registered = dup(fd)) >= 0 && epoll_ctl(scheduler->_PollFd, EPOLL_CTL_ADD, registered, &event) == 0)
+      error = 0;
+    else if (registered != fd && registered >= 0)
+      close(registered);
+    if (error) {
+      // Not waitable this way (e.g. a regular file); it is ready.
+      remove_waiter(scheduler, token);
+      fiber->wake(token, Fiber_O::WakeReady);
+      fiber->park_current();
+      return true;
+    }
+  }
+  Fiber_O::Wake reason = fiber->park_current();
+  remove_waiter(scheduler, token);
+  epoll_ctl(scheduler->_PollFd, EPOLL_CTL_DEL, registered, NULL);
+  if (registered != fd)
+    close(registered);
+  return reason == Fiber_O::WakeReady;
+#else
+  // No epoll; poll the descriptor between naps.
+  double deadline = seconds >= 0.0 ? monotonic_now() + seconds : -1.0;
+  while (true) {
+    mp__fiber_sleep(core::DoubleFloat_O::create(0.001));
+    if (poll(&p, 1, 0) > 0)
+      return true;
+    if (deadline >= 0.0 && monotonic_now() >= deadline)
+      return false;
+  }
+#endif
+}
+
+CL_DOCSTRING(R"dx(Wait until FIBER has finished. A fiber waiting parks; a process waiting blocks.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void mp__PERCENTfiber_join_wait(Fiber_sp fiber) {
+  Fiber_O* self = (my_carrier && my_carrier->_CurrentFiber) ? my_carrier->_CurrentFiber : NULL;
+  if (self) {
+    if (self == &*fiber)
+      SIMPLE_ERROR("A fiber cannot join itself");
+    fiber->lock_joiners();
+    bool finished = fiber->_State.load() == Fiber_O::Finished;
+    if (!finished)
+      fiber->_Joiners = core::Cons_O::create(self->asSmartPtr(), fiber->_Joiners);
+    fiber->unlock_joiners();
+    while (!finished) {
+      mp__fiber_park(nil<core::T_O>());
+      finished = fiber->_Done.load() != 0;
+    }
+    return;
+  }
+  while (fiber->_Done.load(std::memory_order_seq_cst) == 0) {
+    futex_wait(&fiber->_Done, 0, -1.0);
+    gctools::handle_all_queued_interrupts();
+  }
+}
+
+}; // namespace mp
@@ -94,6 +94,9 @@ THE SOFTWARE.
 #include <clasp/core/designators.h>
 #include <clasp/core/weakHashTable.h>
 #include <clasp/core/wrappers.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #ifdef CLASP_THREADS
 #ifdef _TARGET_OS_LINUX
 #include <sched.h>
@@ -130,7 +133,7 @@ void verifyHashTable(bool print, std::ostream& ss, HashTable_O* ht, const char*
       T_sp key = keys->rowMajorAref(it);
       HashGenerator hg;
       cl_index index = ht->sxhashKey(key, ht->_Table.size(), hg);
-      KeyValuePair* keyValue = ht->searchTable_no_read_lock(key, index);
+      KeyValuePair* keyValue = ht->searchTable_no_read_lock(key, index, HashTable_O::hashFragment(hg));
       if (!keyValue) {
         clasp_write_string(fmt::format(
             "{}:{} Could not find key {} badge = {} expected at or after Entry[{}] for ht->_Table.size() = {}\n", filename, line,
@@ -169,19 +172,32 @@ struct HashTableReadLock {
     }
   }
 };
+// Writers make _WriteVersion odd while they hold the write lock so that
+// optimistic readers (see gethash_optimistic) can tell that they raced.
+inline void hash_table_begin_write(const HashTable_O* ht) {
+  ht->_WriteVersion.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+inline void hash_table_end_write(const HashTable_O* ht) { ht->_WriteVersion.fetch_add(1, std::memory_order_release); }
+
 struct HashTableWriteLock {
   const HashTable_O* _hashTable;
   HashTableWriteLock(const HashTable_O* ht, bool upgrade = false) : _hashTable(ht) {
     if (this->_hashTable->_Mutex) {
       this->_hashTable->_Mutex->write_lock(upgrade);
+      hash_table_begin_write(this->_hashTable);
     }
   }
   ~HashTableWriteLock() {
     if (this->_hashTable->_Mutex) {
+      hash_table_end_write(this->_hashTable);
       this->_hashTable->_Mutex->write_unlock();
     }
   }
 };
+
+// How many times an optimistic reader retries before it takes the read lock.
+#define HT_OPTIMISTIC_READ_TRIES 8
 #endif
 
 #ifdef CLASP_THREADS
@@ -200,11 +216,13 @@ CL_DEFUN Vector_sp core__hash_table_pairs(HashTableBase_sp hash_table_base) {
     HT_READ_LOCK(&*hash_table);
     SimpleVector_sp keyvalues = SimpleVector_O::make(hash_table->_HashTableCount * 2);
     size_t idx(0);
-    for (size_t it(0), itEnd(hash_table->_Table.size()); it < itEnd; ++it) {
-      KeyValuePair& entry = hash_table->_Table[it];
-      if (!entry._Key.no_keyp() && !entry._Key.deletedp()) {
-        (*keyvalues)[idx++] = entry._Key;
-        (*keyvalues)[idx++] = entry._Value;
+    for (gctools::Vec0<KeyValuePair>* table : {&hash_table->_Table, &hash_table->_OldTable}) {
+      for (size_t it(0), itEnd(table->size()); it < itEnd; ++it) {
+        KeyValuePair& entry = (*table)[it];
+        if (!entry._Key.no_keyp() && !entry._Key.deletedp()) {
+          (*keyvalues)[idx++] = entry._Key;
+          (*keyvalues)[idx++] = entry._Value;
+        }
       }
     }
     return keyvalues;
@@ -350,22 +368,26 @@ HashTable_sp HashTable_O::create_thread_safe(T_sp test, SimpleBaseString_sp read
 }
 
 // FIXME: contents read could just be atomic maybe?
+// Walks _Table and then whatever an incremental rehash has not moved out of _OldTable yet.
 #define HASH_TABLE_ITER(tablep, key, value)                                                                                        \
-  gctools::tagged_pointer<gctools::GCVector_moveable<KeyValuePair>> iter_datap;                                                    \
+  gctools::tagged_pointer<gctools::GCVector_moveable<KeyValuePair>> iter_datap[2];                                                 \
   T_sp key;                                                                                                                        \
   T_sp value;                                                                                                                      \
   {                                                                                                                                \
     HT_READ_LOCK(tablep);                                                                                                          \
-    iter_datap = tablep->_Table._Vector._Contents;                                                                                 \
+    iter_datap[0] = tablep->_Table._Vector._Contents;                                                                              \
+    iter_datap[1] = tablep->_OldTable._Vector._Contents;                                                                           \
   }                                                                                                                                \
-  for (size_t it(0), itEnd(iter_datap->_End); it < itEnd; ++it) {                                                                  \
-    KeyValuePair& entry = (*iter_datap)[it];                                                                                       \
-    {                                                                                                                              \
-      HT_READ_LOCK(tablep);                                                                                                        \
-      key = entry._Key;                                                                                                            \
-      value = entry._Value;                                                                                                        \
-    }                                                                                                                              \
-    if (!key.no_keyp() && !key.deletedp())
+  for (size_t iter_which(0); iter_which < 2; ++iter_which)                                                                         \
+    if (iter_datap[iter_which])                                                                                                    \
+      for (size_t it(0), itEnd(iter_datap[iter_which]->_End); it < itEnd; ++it) {                                                  \
+        KeyValuePair& entry = (*iter_datap[iter_which])[it];                                                                       \
+        {                                                                                                                          \
+          HT_READ_LOCK(tablep);                                                                                                    \
+          key = entry._Key;                                                                                                        \
+          value = entry._Value;                                                                                                    \
+        }                                                                                                                          \
+        if (!key.no_keyp() && !key.deletedp())
 
 #define HASH_TABLE_ITER_END }
 
@@ -456,10 +478,14 @@ CL_DEFUN bool cl__remhash(T_sp key, HashTableBase_sp ht) { return ht->remhash(ke
 
 T_sp HashTable_O::clrhash() {
   ASSERT(!clasp_zerop(this->_RehashSize));
-  this->_HashTableCount = 0;
-  T_sp no_key = ::no_key<T_O>();
-  this->_Table.resize(0, KeyValuePair(no_key, no_key));
-  this->setup(16, this->_RehashSize, this->_RehashThreshold);
+  {
+    // Hold the write lock across the whole clear so that readers never see the empty _Table.
+    HT_WRITE_LOCK(this);
+    T_sp no_key = ::no_key<T_O>();
+    this->dropOldTable_no_lock();
+    this->_Table.resize(0, KeyValuePair(no_key, no_key));
+    this->resizeEmptyTable_no_lock(16);
+  }
   VERIFY_HASH_TABLE(this);
   return this->asSmartPtr();
 }
@@ -712,9 +738,97 @@ uint HashTable_O::resizeEmptyTable_no_lock(size_t sz) {
   T_sp no_key = ::no_key<T_O>();
   this->_HashTableCount = 0;
   this->_Table.resize(sz, KeyValuePair(no_key, no_key));
+  if (this->useFragments()) {
+    this->_Fragments = SimpleVector_byte8_t_O::make(sz, HT_FRAGMENT_EMPTY, true);
+  }
   return sz;
 }
 
+size_t HashTable_O::nextTableSize_no_lock(bool expandTable) const {
+  size_t curSize = this->_Table.size();
+  if (expandTable) {
+    if (cl__integerp(this->_RehashSize)) {
+      return curSize + clasp_to_int(gc::As<Integer_sp>(this->_RehashSize));
+    } else if (cl__floatp(this->_RehashSize)) {
+      return curSize * clasp_to_double(this->_RehashSize);
+    }
+  }
+  return curSize;
+}
+
+// Store KEY, which is in neither table, in the first free slot of _Table at or after INDEX.
+void HashTable_O::storeNewEntry_no_lock(T_sp key, T_sp value, cl_index index, uint8_t fragment) {
+  size_t sz = this->_Table.size();
+  for (size_t cur = index, n = 0; n < sz; ++n, cur = (cur + 1 == sz) ? 0 : cur + 1) {
+    KeyValuePair& entry = this->_Table[cur];
+    if (entry._Key.no_keyp() || entry._Key.deletedp()) {
+      entry._Key = key;
+      entry._Value = value;
+      this->setFragment_no_lock(cur, fragment);
+      return;
+    }
+  }
+  SIMPLE_ERROR("There is no room in hash-table of size {} while rehashing it incrementally", sz);
+}
+
+// Rather than moving every entry at once (and making every thread that touches a
+// huge table wait for it), keep the current table as _OldTable and let insertions
+// move a bounded number of its slots into the new, larger _Table.
+void HashTable_O::startIncrementalRehash_no_lock() {
+  size_t newSize = this->nextTableSize_no_lock(true);
+  size_t count = this->_HashTableCount;
+  this->_OldTable.swap(this->_Table);
+  this->_OldFragments = this->_Fragments;
+  this->_OldTableIndex = 0;
+  this->resizeEmptyTable_no_lock(newSize);
+  this->_HashTableCount = count;
+}
+
+void HashTable_O::incrementalRehashStep_no_lock(size_t slots) {
+  size_t oldSize = this->_OldTable.size();
+  if (oldSize == 0)
+    return;
+  size_t newSize = this->_Table.size();
+  // Move at least enough slots that we are done before the new table fills up.
+  double headroom = this->_RehashThreshold * newSize - this->_HashTableCount;
+  if (headroom >= 1.0)
+    slots = std::max(slots, (size_t)((oldSize - this->_OldTableIndex) / headroom) + 1);
+  else
+    slots = oldSize;
+  size_t end = std::min(oldSize, this->_OldTableIndex + slots);
+  for (size_t it = this->_OldTableIndex; it < end; ++it) {
+    KeyValuePair& entry = this->_OldTable[it];
+    T_sp key = entry._Key;
+    if (!key.no_keyp() && !key.deletedp()) {
+      HashGenerator hg;
+      cl_index index = this->sxhashKey(key, newSize, hg);
+      this->storeNewEntry_no_lock(key, entry._Value, index, hashFragment(hg));
+      // Leave a tombstone so that probes of the old table still get past this slot
+      entry._Key = deleted<T_O>();
+      if (this->_OldFragments.notnilp())
+        (*this->_OldFragments)[it] = HT_FRAGMENT_DELETED;
+    }
+    this->_OldTableIndex = it + 1;
+  }
+  if (this->_OldTableIndex == oldSize)
+    this->dropOldTable_no_lock();
+}
+
+void HashTable_O::dropOldTable_no_lock() {
+  gctools::Vec0<KeyValuePair> empty;
+  this->_OldTable.swap(empty);
+  this->_OldFragments = nil<SimpleVector_byte8_t_O>();
+  this->_OldTableIndex = 0;
+}
+
+KeyValuePair* HashTable_O::searchOldTable_no_read_lock(T_sp key, const HashGenerator& hg, uint8_t fragment) {
+  size_t oldSize = this->_OldTable.size();
+  if (oldSize == 0)
+    return nullptr;
+  return this->searchContents(&this->_OldTable[0], this->_OldFragments.notnilp() ? this->_OldFragments->begin() : nullptr,
+                              oldSize, key, hg.hashBound(oldSize), fragment);
+}
+
 CL_LAMBDA(arg);
 CL_DECLARE();
 CL_DOCSTRING(R"dx(hash-table-count)dx");
@@ -729,10 +843,12 @@ size_t HashTable_O::hashTableCount() const {
 uint HashTable_O::calculateHashTableCount() const {
   HT_READ_LOCK(this);
   uint cnt = 0;
-  for (size_t it(0), itEnd(this->_Table.size()); it < itEnd; ++it) {
-    const KeyValuePair& entry = this->_Table[it];
-    if (!entry._Key.no_keyp() && !entry._Key.deletedp())
-      ++cnt;
+  for (const gctools::Vec0<KeyValuePair>* table : {&this->_Table, &this->_OldTable}) {
+    for (size_t it(0), itEnd(table->size()); it < itEnd; ++it) {
+      const KeyValuePair& entry = (*table)[it];
+      if (!entry._Key.no_keyp() && !entry._Key.deletedp())
+        ++cnt;
+    }
   }
   return cnt;
 }
@@ -776,9 +892,59 @@ CL_DEFUN T_mv core__gethash3(T_sp key, T_sp hashTable, T_sp default_value) {
   return ht->gethash(key, default_value);
 };
 
-KeyValuePair* HashTable_O::searchTable_no_read_lock(T_sp key, cl_index index) {
-  KeyValuePair* table = &this->_Table[0]; // get the table for debugging
-  size_t tableSize = this->_Table.size();
+// Probe the fragments sixteen at a time (SwissTable style) starting at INDEX
+// and wrapping around, up to the first empty slot. Only slots whose fragment
+// matches need the full keyTest.
+KeyValuePair* HashTable_O::searchFragments(KeyValuePair* table, const uint8_t* fragments, size_t tableSize, T_sp key,
+                                           cl_index index, uint8_t fragment) const {
+  size_t cur = index;
+  size_t remaining = tableSize;
+  while (remaining > 0) {
+    size_t group = std::min(remaining, tableSize - cur);
+#if defined(__SSE2__)
+    if (group >= 16) {
+      __m128i bytes = _mm_loadu_si128((const __m128i*)(fragments + cur));
+      uint32_t matches = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)fragment)));
+      uint32_t empties = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8((char)HT_FRAGMENT_EMPTY)));
+      if (empties)
+        matches &= (empties & -empties) - 1; // only the slots before the first empty one
+      while (matches) {
+        KeyValuePair& entry = table[cur + __builtin_ctz(matches)];
+        // An optimistic reader may see a fragment before its key, so check the key too.
+        if (!entry._Key.no_keyp() && !entry._Key.deletedp() && this->keyTest(entry._Key, key))
+          return &entry;
+        matches &= matches - 1;
+      }
+      if (empties)
+        return nullptr;
+      cur += 16;
+      remaining -= 16;
+      if (cur == tableSize)
+        cur = 0;
+      continue;
+    }
+#endif
+    for (size_t curEnd = cur + group; cur < curEnd; ++cur) {
+      uint8_t frag = fragments[cur];
+      if (frag == HT_FRAGMENT_EMPTY)
+        return nullptr;
+      if (frag == fragment) {
+        KeyValuePair& entry = table[cur];
+        if (!entry._Key.no_keyp() && !entry._Key.deletedp() && this->keyTest(entry._Key, key))
+          return &entry;
+      }
+    }
+    remaining -= group;
+    if (cur == tableSize)
+      cur = 0;
+  }
+  return nullptr;
+}
+
+KeyValuePair* HashTable_O::searchContents(KeyValuePair* table, const uint8_t* fragments, size_t tableSize, T_sp key,
+                                          cl_index index, uint8_t fragment) const {
+  if (fragments)
+    return this->searchFragments(table, fragments, tableSize, key, index, fragment);
   for (size_t cur = index, curEnd(tableSize); cur < curEnd; ++cur) {
     KeyValuePair& entry = table[cur];
     if (entry._Key.no_keyp())
@@ -816,13 +982,13 @@ NOT_FOUND:
   return nullptr;
 }
 
-KeyValuePair* HashTable_O::tableRef_no_read_lock(T_sp key, cl_index index) {
+KeyValuePair* HashTable_O::tableRef_no_read_lock(T_sp key, cl_index index, uint8_t fragment) {
   DEBUG_HASH_TABLE({
     core::clasp_write_string(fmt::format("{}:{}:{} key = {}  index = {}\n", __FILE__, __LINE__, __FUNCTION__, _rep_(key), index));
   });
   VERIFY_HASH_TABLE(this);
   BOUNDS_ASSERT(index < this->_Table.size());
-  KeyValuePair* result = this->searchTable_no_read_lock(key, index);
+  KeyValuePair* result = this->searchTable_no_read_lock(key, index, fragment);
   VERIFY_HASH_TABLE(this);
   return result;
 }
@@ -836,8 +1002,66 @@ CL_DEFUN void core__hash_table_force_rehash(HashTable_sp ht) {
   ht->rehash_no_lock(false, no_key<T_O>());
 }
 
+#ifdef CLASP_THREADS
+// Seqlock style read: snapshot the version and the contents vector, probe
+// the snapshot and then check that no writer came along in the meantime.
+// Rehashing swaps in a fresh contents vector and the old one stays alive
+// as long as we reference it, so probing a stale snapshot is harmless.
+bool HashTable_O::gethash_optimistic(T_sp key, T_sp& value, bool& foundp) const {
+  for (size_t tries = 0; tries < HT_OPTIMISTIC_READ_TRIES; ++tries) {
+    size_t version = this->_WriteVersion.load(std::memory_order_acquire);
+    if (version & 1)
+      continue; // a writer is active
+    gctools::tagged_pointer<gctools::GCVector_moveable<KeyValuePair>> contents = this->_Table._Vector._Contents;
+    if (!contents)
+      continue;
+    size_t sz = contents->_End;
+    if (sz == 0)
+      continue;
+    SimpleVector_byte8_t_sp fragments = this->_Fragments;
+    if (fragments.notnilp() && fragments->length() < sz)
+      continue; // caught a rehash half way
+    HashGenerator hg;
+    cl_index index = this->sxhashKey(key, sz, hg);
+    uint8_t fragment = hashFragment(hg);
+    KeyValuePair* keyValuePair =
+        this->searchContents(&(*contents)[0], fragments.notnilp() ? fragments->begin() : nullptr, sz, key, index, fragment);
+    if (!keyValuePair) {
+      gctools::tagged_pointer<gctools::GCVector_moveable<KeyValuePair>> oldContents = this->_OldTable._Vector._Contents;
+      size_t oldSz = oldContents ? oldContents->_End : 0;
+      if (oldSz > 0) {
+        SimpleVector_byte8_t_sp oldFragments = this->_OldFragments;
+        if (oldFragments.notnilp() && oldFragments->length() < oldSz)
+          continue;
+        keyValuePair = this->searchContents(&(*oldContents)[0], oldFragments.notnilp() ? oldFragments->begin() : nullptr, oldSz,
+                                            key, hg.hashBound(oldSz), fragment);
+      }
+    }
+    T_sp found = keyValuePair ? keyValuePair->_Value : no_key<T_O>();
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (this->_WriteVersion.load(std::memory_order_relaxed) == version) {
+      foundp = !found.no_keyp();
+      value = found;
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
 T_mv HashTable_O::gethash(T_sp key, T_sp default_value) {
   LOG("gethash looking for key[{}]", _rep_(key));
+#ifdef CLASP_THREADS
+  if (this->_Mutex) {
+    T_sp value;
+    bool foundp;
+    if (this->gethash_optimistic(key, value, foundp)) {
+      if (foundp)
+        return Values(value, _lisp->_true());
+      return Values(default_value, nil<T_O>());
+    }
+  }
+#endif
   HT_READ_LOCK(this);
   VERIFY_HASH_TABLE(this);
   HashGenerator hg;
@@ -850,7 +1074,10 @@ T_mv HashTable_O::gethash(T_sp key, T_sp default_value) {
   }
   // #endif
   cl_index index = this->sxhashKey(key, sz, hg);
-  KeyValuePair* keyValuePair = this->tableRef_no_read_lock(key, index);
+  uint8_t fragment = hashFragment(hg);
+  KeyValuePair* keyValuePair = this->tableRef_no_read_lock(key, index, fragment);
+  if (!keyValuePair)
+    keyValuePair = this->searchOldTable_no_read_lock(key, hg, fragment);
   LOG("Found keyValueCons"); // % keyValueCons->__repr__() ); INFINITE-LOOP
   if (keyValuePair) {
     T_sp value = keyValuePair->_Value;
@@ -875,7 +1102,10 @@ KeyValuePair* HashTable_O::find(T_sp key) {
   HT_READ_LOCK(this);
   HashGenerator hg;
   cl_index index = this->sxhashKey(key, this->_Table.size(), hg);
-  KeyValuePair* keyValue = this->tableRef_no_read_lock(key, index);
+  uint8_t fragment = hashFragment(hg);
+  KeyValuePair* keyValue = this->tableRef_no_read_lock(key, index, fragment);
+  if (!keyValue)
+    keyValue = this->searchOldTable_no_read_lock(key, hg, fragment);
   if (!keyValue)
     return keyValue;
   if (keyValue->_Value.no_keyp())
@@ -893,13 +1123,23 @@ bool HashTable_O::remhash(T_sp key) {
   HT_WRITE_LOCK(this);
   HashGenerator hg;
   cl_index index = this->sxhashKey(key, this->_Table.size(), hg);
-  KeyValuePair* keyValuePair = this->tableRef_no_read_lock(key, index);
+  uint8_t fragment = hashFragment(hg);
+  KeyValuePair* keyValuePair = this->tableRef_no_read_lock(key, index, fragment);
   if (keyValuePair) {
     keyValuePair->_Key = deleted<T_O>();
+    this->setFragment_no_lock(keyValuePair - &this->_Table[0], HT_FRAGMENT_DELETED);
     this->_HashTableCount--;
     VERIFY_HASH_TABLE(this);
     return true;
   }
+  keyValuePair = this->searchOldTable_no_read_lock(key, hg, fragment);
+  if (keyValuePair) {
+    keyValuePair->_Key = deleted<T_O>();
+    if (this->_OldFragments.notnilp())
+      (*this->_OldFragments)[keyValuePair - &this->_OldTable[0]] = HT_FRAGMENT_DELETED;
+    this->_HashTableCount--;
+    return true;
+  }
   VERIFY_HASH_TABLE(this);
   return false;
 }
@@ -935,7 +1175,13 @@ T_sp HashTable_O::setf_gethash_no_write_lock(T_sp key, T_sp value) {
     core::clasp_write_string(fmt::format("{}:{}:{}   index = {}  this->_Table.size() = {}\n", __FILE__, __LINE__, __FUNCTION__,
                                          index, this->_Table.size()));
   });
-  KeyValuePair* keyValuePair = this->tableRef_no_read_lock(key, index);
+  uint8_t fragment = hashFragment(hg);
+  KeyValuePair* keyValuePair = this->tableRef_no_read_lock(key, index, fragment);
+  if (!keyValuePair) {
+    // Rewrite entries that an incremental rehash hasn't moved yet in place,
+    // only insertions move entries so that maphash may set the current value.
+    keyValuePair = this->searchOldTable_no_read_lock(key, hg, fragment);
+  }
   if (keyValuePair) {
     // rewrite value
     keyValuePair->_Value = value;
@@ -983,13 +1229,20 @@ ADD_KEY_VALUE:
   });
   entryP->_Key = key;
   entryP->_Value = value;
+  this->setFragment_no_lock(write, fragment);
   this->_HashTableCount++;
   DEBUG_HASH_TABLE({ core::clasp_write_string(fmt::format("{}:{} Found empty slot at index = {}\n", __FILE__, __LINE__, write)); });
   VERIFY_HASH_TABLE_VA(this, write, key);
   if (this->_HashTableCount > this->_RehashThreshold * this->_Table.size()) {
     LOG("Expanding hash table");
-    this->rehash_no_lock(true, no_key<T_O>());
+    if (this->_OldTable.size() == 0 && this->_Table.size() >= HT_INCREMENTAL_REHASH_MIN_SIZE) {
+      this->startIncrementalRehash_no_lock();
+    } else {
+      this->rehash_no_lock(true, no_key<T_O>());
+    }
     VERIFY_HASH_TABLE(this);
+  } else if (this->_OldTable.size() != 0) {
+    this->incrementalRehashStep_no_lock(HT_INCREMENTAL_REHASH_STEP);
   }
   return value;
 NO_ROOM:
@@ -1042,21 +1295,14 @@ KeyValuePair* HashTable_O::rehash_no_lock(bool expandTable, T_sp findKey) {
   }
 #endif
 
+  // Everything has to be in _Table before we can rebuild it
+  this->finishIncrementalRehash_no_lock();
   gc::Fixnum curSize = this->_Table.size();
   ASSERTF(this->_Table.size() != 0, "HashTable is empty in expandHashTable curSize={}  this->_Table.size()= {} this shouldn't be",
           curSize, this->_Table.size());
   KeyValuePair* foundKeyValuePair = nullptr;
   LOG("At start of expandHashTable current hash table size: {}", this->_Table.size());
-  gc::Fixnum newSize = 0;
-  if (expandTable) {
-    if (cl__integerp(this->_RehashSize)) {
-      newSize = curSize + clasp_to_int(gc::As<Integer_sp>(this->_RehashSize));
-    } else if (cl__floatp(this->_RehashSize)) {
-      newSize = curSize * clasp_to_double(this->_RehashSize);
-    }
-  } else {
-    newSize = curSize;
-  }
+  gc::Fixnum newSize = this->nextTableSize_no_lock(expandTable);
   gc::Vec0<KeyValuePair> oldTable;
   oldTable.swap(this->_Table);
   newSize = this->resizeEmptyTable_no_lock(newSize);
@@ -1104,7 +1350,7 @@ KeyValuePair* HashTable_O::rehash_no_lock(bool expandTable, T_sp findKey) {
     T_sp key = foundKeyValuePair->_Key;
     HashGenerator hg;
     cl_index index = this->sxhashKey(key, this->_Table.size(), hg);
-    foundKeyValuePair = this->tableRef_no_read_lock(foundKeyValuePair->_Key, index);
+    foundKeyValuePair = this->tableRef_no_read_lock(foundKeyValuePair->_Key, index, hashFragment(hg));
   }
   DEBUG_HASH_TABLE({
     if (foundKeyValuePair) {
@@ -1120,7 +1366,9 @@ KeyValuePair* HashTable_O::rehash_upgrade_write_lock(bool expandTable, T_sp find
   if (this->_Mutex) {
   tryAgain:
     if (this->_Mutex->write_try_lock(true /*upgrade*/)) {
+      hash_table_begin_write(this);
       KeyValuePair* result = this->rehash_no_lock(expandTable, findKey);
+      hash_table_end_write(this);
       // Releasing the read lock will be done by the caller using RAII
       this->_Mutex->write_unlock(false /*releaseReadLock*/);
       return result;
@@ -1174,36 +1422,52 @@ void dump_one_entry(HashTable_sp ht, size_t it, stringstream& ss, KeyValuePair&
 #endif
 };
 
+// While an incremental rehash is in progress, indices past the end of _Table
+// refer to the slots of _OldTable that have not been moved yet.
 CL_DEFMETHOD List_sp HashTable_O::hash_table_bucket(size_t index) {
-  KeyValuePair& entry = this->_Table[index];
-  if (!entry._Key.no_keyp() && !entry._Value.deletedp()) {
+  HT_READ_LOCK(this);
+  const gctools::Vec0<KeyValuePair>* table = &this->_Table;
+  if (index >= table->size()) {
+    index -= table->size();
+    table = &this->_OldTable;
+    if (index < this->_OldTableIndex || index >= table->size())
+      return nil<T_O>();
+  }
+  const KeyValuePair& entry = (*table)[index];
+  if (!entry._Key.no_keyp() && !entry._Key.deletedp()) {
     T_sp result = Cons_O::create(entry._Key, entry._Value);
     return result;
   }
   return nil<T_O>();
 }
 
+// Averages over both tables during an incremental rehash; entries still in
+// _OldTable are measured against the old table's size, which is how they are probed.
 CL_DEFMETHOD T_sp HashTable_O::hash_table_average_search_length() {
   HT_READ_LOCK(this);
-  gc::Fixnum iend(this->_Table.size());
   double sum = 0.0;
   gc::Fixnum count = 0;
-  for (gc::Fixnum it(0), itEnd(iend); it < itEnd; ++it) {
-    const KeyValuePair& entry = this->_Table[it];
-    if (!(entry._Key.no_keyp() || entry._Key.deletedp())) {
-      HashGenerator hg;
-      gc::Fixnum index = this->sxhashKey(entry._Key, this->_Table.size(), hg);
-      gc::Fixnum delta;
-      if (index > it) {
-        delta = (it + iend) - index;
-      } else {
-        delta = (it - index);
+  auto accumulate = [&](const gctools::Vec0<KeyValuePair>& table, gc::Fixnum start) {
+    gc::Fixnum iend(table.size());
+    for (gc::Fixnum it(start), itEnd(iend); it < itEnd; ++it) {
+      const KeyValuePair& entry = table[it];
+      if (!(entry._Key.no_keyp() || entry._Key.deletedp())) {
+        HashGenerator hg;
+        gc::Fixnum index = this->sxhashKey(entry._Key, iend, hg);
+        gc::Fixnum delta;
+        if (index > it) {
+          delta = (it + iend) - index;
+        } else {
+          delta = (it - index);
+        }
+        //      printf("%s:%d  index = %lld  it = %lld  delta=%lld\n", __FILE__, __LINE__, index, it, delta );
+        sum = sum + delta;
+        count++;
       }
-      //      printf("%s:%d  index = %lld  it = %lld  delta=%lld\n", __FILE__, __LINE__, index, it, delta );
-      sum = sum + delta;
-      count++;
     }
-  }
+  };
+  accumulate(this->_Table, 0);
+  accumulate(this->_OldTable, this->_OldTableIndex);
   if (count > 0) {
     return core::clasp_make_double_float(sum / count);
   }
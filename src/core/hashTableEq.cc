@@ -72,16 +72,18 @@ HashTableEq_sp HashTableEq_O::createFromPList(List_sp plist, Symbol_sp nilTermin
   return ht;
 }
 
-KeyValuePair* HashTableEq_O::searchTable_no_read_lock(T_sp key, cl_index index) {
-  for (size_t cur = index, curEnd(this->_Table.size()); cur < curEnd; ++cur) {
-    KeyValuePair& entry = this->_Table[cur];
+KeyValuePair* HashTableEq_O::searchContents(KeyValuePair* table, const uint8_t* fragments, size_t tableSize, T_sp key,
+                                            cl_index index, uint8_t fragment) const {
+  // EQ tables don't keep fragments, comparing the keys is as cheap as comparing fragments.
+  for (size_t cur = index, curEnd(tableSize); cur < curEnd; ++cur) {
+    KeyValuePair& entry = table[cur];
     if (entry._Key == key)
       return &entry;
     if (entry._Key.no_keyp())
       goto NOT_FOUND;
   }
   for (size_t cur = 0, curEnd(index); cur < curEnd; ++cur) {
-    KeyValuePair& entry = this->_Table[cur];
+    KeyValuePair& entry = table[cur];
     if (entry._Key == key)
       return &entry;
     if (entry._Key.no_keyp())
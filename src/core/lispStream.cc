@@ -54,6 +54,7 @@ THE SOFTWARE.
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <poll.h>
 #include <clasp/core/foundation.h>
@@ -82,6 +83,10 @@ THE SOFTWARE.
 #include <clasp/core/fileSystem.h>
 #include <clasp/core/wrappers.h>
 #include <clasp/core/bits.h>
+#include <clasp/core/pointer.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace core {
 
@@ -207,7 +212,13 @@ T_sp stream_open(T_sp fn, StreamDirection direction, StreamIfExists if_exists, S
       }
     }
   }
-  if (flags & CLASP_STREAM_C_STREAM) {
+  if (flags & CLASP_STREAM_MMAP) {
+    unlikely_if(direction != StreamDirection::input) {
+      safe_close(f);
+      SIMPLE_ERROR("Memory mapped file streams can only be opened for input, not {}", direction);
+    }
+    output = MmapFileStream_O::make(fn, f, direction, byte_size, flags, external_format);
+  } else if (flags & CLASP_STREAM_C_STREAM) {
     FILE* fp = NULL;
     switch (direction) {
     case StreamDirection::probe:
@@ -897,13 +908,17 @@ err:
   FEerror("Not a valid stream element type: ~A", 1, element_type.raw_());
 }
 
-CL_LAMBDA("filename &key (direction :input) (element-type 'base-char) (if-exists nil iesp) (if-does-not-exist nil idnesp) (external-format :default) (cstream T)");
+CL_LAMBDA("filename &key (direction :input) (element-type 'base-char) (if-exists nil iesp) (if-does-not-exist nil idnesp) (external-format :default) (cstream T) (mmap nil)");
 CL_DOCSTRING(R"dx(Creates, opens, and returns a file stream that is connected to the
 file specified by filespec. Filespec is the name of the file to be
 opened. If the filespec designator is a stream, that stream is not
-closed first or otherwise affected.)dx");
+closed first or otherwise affected.
+
+The Clasp extension keyword MMAP opens an input stream that reads from
+a memory mapping of the whole file.)dx");
 CL_DEFUN T_sp cl__open(T_sp filename, core::StreamDirection direction, T_sp element_type, core::StreamIfExists if_exists, bool iesp,
-                       core::StreamIfDoesNotExist if_does_not_exist, bool idnesp, T_sp external_format, T_sp cstream) {
+                       core::StreamIfDoesNotExist if_does_not_exist, bool idnesp, T_sp external_format, T_sp cstream,
+                       T_sp mmap) {
   if (filename.nilp()) {
     TYPE_ERROR(filename, Cons_O::createList(cl::_sym_or, cl::_sym_string, cl::_sym_Pathname_O, cl::_sym_Stream_O));
   }
@@ -946,6 +961,9 @@ CL_DEFUN T_sp cl__open(T_sp filename, core::StreamDirection direction, T_sp elem
   if (!cstream.nilp()) {
     flags |= CLASP_STREAM_C_STREAM;
   }
+  if (!mmap.nilp()) {
+    flags |= CLASP_STREAM_MMAP;
+  }
   return stream_open(filename, direction, if_exists, if_does_not_exist, byte_size, flags, external_format);
 }
 
@@ -3147,6 +3165,63 @@ int TwoWayStream_O::file_descriptor(StreamDirection direction) const {
 /* Size of the encoding buffer for vectors */
 #define VECTOR_ENCODING_BUFFER_SIZE 2048
 
+/* Return the length of the longest prefix of BUFFER made only of ASCII
+ * octets, stopping early at a linefeed or carriage return when asked to.
+ * These are the octets that decode to themselves in every ASCII compatible
+ * external format, so they can be copied without calling the decoder. */
+static size_t ascii_run_length(const unsigned char* buffer, size_t size, bool stop_at_linefeed, bool stop_at_return) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  // 0x80 never matches an ASCII octet, so it disables a stop character.
+  const __m128i linefeed = _mm_set1_epi8(stop_at_linefeed ? CLASP_CHAR_CODE_LINEFEED : (char)0x80);
+  const __m128i carriage_return = _mm_set1_epi8(stop_at_return ? CLASP_CHAR_CODE_RETURN : (char)0x80);
+  for (; i + 16 <= size; i += 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i*)(buffer + i));
+    __m128i stops = _mm_or_si128(_mm_cmpeq_epi8(chunk, linefeed), _mm_cmpeq_epi8(chunk, carriage_return));
+    int mask = _mm_movemask_epi8(_mm_or_si128(chunk, stops));
+    if (mask)
+      return i + __builtin_ctz(mask);
+  }
+#endif
+  for (; i < size; ++i) {
+    unsigned char b = buffer[i];
+    if (b >= 0x80 || (stop_at_linefeed && b == CLASP_CHAR_CODE_LINEFEED) || (stop_at_return && b == CLASP_CHAR_CODE_RETURN))
+      break;
+  }
+  return i;
+}
+
+/* Copy SIZE ASCII octets into a character string. */
+static void widen_ascii(claspCharacter* dest, const unsigned char* source, size_t size) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= size; i += 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i*)(source + i));
+    __m128i lo = _mm_unpacklo_epi8(chunk, zero);
+    __m128i hi = _mm_unpackhi_epi8(chunk, zero);
+    _mm_storeu_si128((__m128i*)(dest + i), _mm_unpacklo_epi16(lo, zero));
+    _mm_storeu_si128((__m128i*)(dest + i + 4), _mm_unpackhi_epi16(lo, zero));
+    _mm_storeu_si128((__m128i*)(dest + i + 8), _mm_unpacklo_epi16(hi, zero));
+    _mm_storeu_si128((__m128i*)(dest + i + 12), _mm_unpackhi_epi16(hi, zero));
+  }
+#endif
+  for (; i < size; ++i)
+    dest[i] = source[i];
+}
+
+/* Extend the fill pointer of a read_line buffer string by SIZE and return
+ * the address of the new elements. Grows like vectorPushExtend does. */
+template <typename BufferType>
+static typename BufferType::simple_element_type* extend_line_buffer(gctools::smart_ptr<BufferType> buffer, size_t size) {
+  size_t fp = buffer->fillPointer();
+  size_t total = buffer->arrayTotalSize();
+  if (fp + size > total)
+    buffer->resize(std::max(fp + size, total + calculate_extension(total)));
+  buffer->fillPointerSet(fp + size);
+  return &(*buffer)[fp];
+}
+
 ListenResult FileStream_O::_fd_listen(int fileno) {
 #ifdef CLASP_MS_WINDOWS_HOST
   HANDLE hnd = (HANDLE)_get_osfhandle(fileno);
@@ -3647,6 +3722,23 @@ claspCharacter FileStream_O::write_char(claspCharacter c) {
  * the strings use the same format.
  */
 
+/*
+ * True when ASCII octets decode to the same character codes, which is what
+ * the bulk paths of read_sequence and read_line rely on.
+ */
+bool FileStream_O::ascii_compatible_p() const {
+  if (_byte_size != 8)
+    return false;
+  switch (_flags & (CLASP_STREAM_FORMAT | CLASP_STREAM_LITTLE_ENDIAN)) {
+  case CLASP_STREAM_LATIN_1:
+  case CLASP_STREAM_UTF_8:
+  case CLASP_STREAM_US_ASCII:
+    return true;
+  default:
+    return false;
+  }
+}
+
 claspCharacter FileStream_O::decode(unsigned char** buffer, unsigned char* buffer_end) {
   switch (_flags & (CLASP_STREAM_FORMAT | CLASP_STREAM_LITTLE_ENDIAN)) {
 #ifdef CLASP_UNICODE
@@ -4369,8 +4461,34 @@ cl_index FileStream_O::read_sequence(T_sp data, cl_index start, cl_index end) {
        * read only as many bytes as we actually need. Otherwise, we read
        * more and later reposition the file offset. */
       bool seekable = position().notnilp();
+      /* Runs of ASCII octets are copied straight into simple strings; the
+       * decoder only sees the octets around them. */
+      SimpleBaseString_sp base_string;
+      SimpleCharacterString_sp character_string;
+      if (ascii_compatible_p()) {
+        if (gc::IsA<SimpleBaseString_sp>(vec))
+          base_string = gc::As_unsafe<SimpleBaseString_sp>(vec);
+        else if (gc::IsA<SimpleCharacterString_sp>(vec))
+          character_string = gc::As_unsafe<SimpleCharacterString_sp>(vec);
+      }
+      bool stop_at_return = _flags & CLASP_STREAM_CR;
 
       while (start < end) {
+        if (base_string || character_string) {
+          size_t run = ascii_run_length(buffer_pos, std::min<size_t>(buffer_end - buffer_pos, end - start), false, stop_at_return);
+          if (run > 0) {
+            if (base_string)
+              memcpy(&(*base_string)[start], buffer_pos, run);
+            else
+              widen_ascii(&(*character_string)[start], buffer_pos, run);
+            _last_char = _last_code[0] = buffer_pos[run - 1];
+            _last_code[1] = EOF;
+            buffer_pos += run;
+            start += run;
+            if (start >= end)
+              break;
+          }
+        }
         claspCharacter c = decode_char_from_buffer(buffer, &buffer_pos, &buffer_end, seekable, (end - start) * (_byte_size / 8));
         if (c == EOF)
           break;
@@ -4396,6 +4514,89 @@ cl_index FileStream_O::read_sequence(T_sp data, cl_index start, cl_index end) {
   return AnsiStream_O::read_sequence(data, start, end);
 }
 
+T_mv FileStream_O::read_line() {
+  /* The bulk path reads ahead of the end of the line and repositions the
+   * file afterwards, so it is limited to seekable streams. */
+  if (!ascii_compatible_p() || _eof_char != EOF || !has_file_position())
+    return AnsiStream_O::read_line();
+
+  T_sp missing_newline_p = _lisp->_true();
+  bool base = true;
+  Str8Ns_sp base_buffer = _lisp->get_Str8Ns_buffer_string();
+  StrWNs_sp extended_buffer;
+  unsigned char buffer[VECTOR_ENCODING_BUFFER_SIZE + ENCODING_BUFFER_MAX_SIZE];
+  unsigned char* buffer_pos = buffer;
+  unsigned char* buffer_end = buffer;
+  bool stop_at_return = _flags & CLASP_STREAM_CR;
+
+  while (true) {
+    size_t run = ascii_run_length(buffer_pos, buffer_end - buffer_pos, true, stop_at_return);
+    if (run > 0) {
+      if (base)
+        memcpy(extend_line_buffer(base_buffer, run), buffer_pos, run);
+      else
+        widen_ascii(extend_line_buffer(extended_buffer, run), buffer_pos, run);
+      if (memchr(buffer_pos, '\t', run)) {
+        for (size_t i = 0; i < run; ++i)
+          _input_cursor.update(buffer_pos[i]);
+      } else {
+        _input_cursor.column() += run - 1;
+        _input_cursor.update(buffer_pos[run - 1]);
+      }
+      _last_char = _last_code[0] = buffer_pos[run - 1];
+      _last_code[1] = EOF;
+      buffer_pos += run;
+    }
+
+    claspCharacter c = decode_char_from_buffer(buffer, &buffer_pos, &buffer_end, true, VECTOR_ENCODING_BUFFER_SIZE);
+    if (c == EOF)
+      break;
+    update_input_cursor(c);
+    if (c == CLASP_CHAR_CODE_NEWLINE) {
+      missing_newline_p = nil<T_O>();
+      break;
+    }
+
+    if (!clasp_base_char_p(c)) {
+      if (base) {
+        // Switch to a wide buffer as AnsiStream_O::read_line does.
+        base = false;
+        extended_buffer = _lisp->get_StrWNs_buffer_string();
+        if (extended_buffer->arrayTotalSize() < base_buffer->length())
+          extended_buffer->resize(base_buffer->length());
+        extended_buffer->unsafe_setf_subseq(0, base_buffer->length(), base_buffer->asSmartPtr());
+        extended_buffer->fillPointerSet(base_buffer->length());
+        _lisp->put_Str8Ns_buffer_string(base_buffer);
+      }
+      extended_buffer->vectorPushExtend(c);
+    } else if (base)
+      base_buffer->vectorPushExtend(c);
+    else
+      extended_buffer->vectorPushExtend(c);
+  }
+
+  // Give back the octets that were read past the end of the line.
+  if (buffer_end > buffer_pos) {
+    T_sp fp = position();
+    if (fp.fixnump()) {
+      set_position(contagion_sub(gc::As_unsafe<Number_sp>(fp), make_fixnum(buffer_end - buffer_pos)));
+    } else {
+      SIMPLE_ERROR("clasp_file_position is not a number");
+    }
+  }
+
+  T_sp result;
+  if (base) {
+    result = cl__copy_seq(base_buffer);
+    _lisp->put_Str8Ns_buffer_string(base_buffer);
+  } else {
+    result = cl__copy_seq(extended_buffer);
+    _lisp->put_StrWNs_buffer_string(extended_buffer);
+  }
+
+  return Values(result, missing_newline_p);
+}
+
 void FileStream_O::write_sequence(T_sp data, cl_index start, cl_index end) {
   if (data.isA<Vector_O>()) {
     Vector_sp vec = data.as_unsafe<Vector_O>();
@@ -4895,6 +5096,136 @@ int PosixFileStream_O::file_descriptor(StreamDirection direction) const {
 
 bool PosixFileStream_O::has_file_position() const { return clasp_has_file_position(_file_descriptor); }
 
+/**********************************************************************
+ * MEMORY MAPPED FILE STREAM
+ */
+
+MmapFileStream_sp MmapFileStream_O::make(T_sp fname, int fd, StreamDirection direction, gctools::Fixnum byte_size, int flags,
+                                         T_sp external_format) {
+  struct stat info;
+  unlikely_if(fstat(fd, &info) != 0) {
+    safe_close(fd);
+    FEcannot_open(fname);
+  }
+  unsigned char* base = NULL;
+  // mmap refuses empty mappings, so an empty file simply has no mapping.
+  if (info.st_size > 0) {
+    void* memory = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    unlikely_if(memory == MAP_FAILED) {
+      safe_close(fd);
+      FEcannot_open(fname);
+    }
+    base = (unsigned char*)memory;
+  }
+  MmapFileStream_sp stream = MmapFileStream_O::create();
+  stream->_direction = direction;
+  stream->_open = true;
+  stream->_byte_size = byte_size;
+  stream->_flags = flags;
+  stream->set_external_format(external_format);
+  stream->_filename = fname;
+  stream->_file_descriptor = fd;
+  stream->_map_base = base;
+  stream->_map_size = info.st_size;
+  stream->_map_position = 0;
+  stream->_last_op = 0;
+  return stream;
+}
+
+T_sp MmapFileStream_O::close(T_sp abort) {
+  if (_open) {
+    if (_map_base)
+      munmap(_map_base, _map_size);
+    _map_base = NULL;
+    _map_size = _map_position = 0;
+    int failed = safe_close(_file_descriptor);
+    unlikely_if(failed < 0) cannot_close(asSmartPtr());
+    _file_descriptor = -1;
+    close_cleanup(abort);
+    _open = false;
+  }
+  return _lisp->_true();
+}
+
+cl_index MmapFileStream_O::read_byte8(unsigned char* c, cl_index n) {
+  check_input();
+
+  if (_byte_stack.notnilp())
+    return consume_byte_stack(c, n);
+
+  if (_map_position >= _map_size)
+    return 0;
+  cl_index out = std::min<size_t>(n, _map_size - _map_position);
+  memcpy(c, _map_base + _map_position, out);
+  _map_position += out;
+  return out;
+}
+
+ListenResult MmapFileStream_O::listen() {
+  check_input();
+
+  if (_byte_stack.notnilp() || _map_position < _map_size)
+    return listen_result_available;
+  return listen_result_eof;
+}
+
+void MmapFileStream_O::clear_input() { check_input(); }
+
+T_sp MmapFileStream_O::length() { return Integer_O::create((gc::Fixnum)(_map_size / (_byte_size / 8))); }
+
+T_sp MmapFileStream_O::position() {
+  gc::Fixnum offset = _map_position;
+  /* If there are unread octets, we return the position at which
+   * these bytes begin! */
+  for (T_sp l = _byte_stack; l.consp(); l = oCdr(l))
+    offset--;
+  return Integer_O::create(offset / (_byte_size / 8));
+}
+
+T_sp MmapFileStream_O::set_position(T_sp pos) {
+  _byte_stack = nil<T_O>();
+  if (pos.nilp()) {
+    _map_position = _map_size;
+  } else {
+    // As with lseek, positions past the end are allowed and read as end of file.
+    _map_position = clasp_to_integral<size_t>(pos) * (_byte_size / 8);
+  }
+  return _lisp->_true();
+}
+
+int MmapFileStream_O::file_descriptor(StreamDirection direction) const {
+  return has_direction(_direction, direction) ? _file_descriptor : -1;
+}
+
+bool MmapFileStream_O::has_file_position() const { return true; }
+
+CL_LAMBDA(stream);
+CL_DOCSTRING(R"dx(Return a foreign pointer to the start of the memory mapping of an
+mmap file stream and the number of octets mapped. The pointer is only
+valid until the stream is closed.)dx");
+CL_DEFUN T_mv core__mmap_file_stream_pointer(MmapFileStream_sp stream) {
+  stream->check_open();
+  return Values(Pointer_O::create(stream->_map_base), make_fixnum(stream->_map_size));
+}
+
+CL_LAMBDA(stream &optional (start 0) end);
+CL_DOCSTRING(R"dx(Return the octets between START and END of the file behind an mmap
+file stream as a fresh (simple-array (unsigned-byte 8) (*)). The
+contents are copied out of the mapping with a single memcpy and the
+stream position is not changed.)dx");
+CL_DEFUN SimpleVector_byte8_t_sp core__mmap_file_stream_octets(MmapFileStream_sp stream, size_t start, T_sp end) {
+  stream->check_open();
+  size_t iend = end.nilp() ? stream->_map_size : clasp_to_integral<size_t>(end);
+  unlikely_if(iend > stream->_map_size || start > iend) {
+    SIMPLE_ERROR("Octet range {} to {} is outside the {} octets mapped from {}", start, iend, stream->_map_size,
+                 _rep_(stream->_filename));
+  }
+  SimpleVector_byte8_t_sp result = SimpleVector_byte8_t_O::make(iend - start);
+  if (iend > start)
+    memcpy(result->begin(), stream->_map_base + start, iend - start);
+  return result;
+}
+
 /**********************************************************************
  * C STREAMS
  */
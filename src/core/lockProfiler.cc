@@ -0,0 +1,341 @@
+/*
+    File: lockProfiler.cc
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+
+// Lock contention profiling.
+//
+// While global_lock_profiling is set, mp::Mutex, mp::SharedMutex and
+// mp::UpgradableSharedMutex call lock_profile_record for every acquisition
+// and every wait. Each thread accumulates into its own table, keyed by the
+// address of the lock, so recording never touches shared state; reports
+// merge the tables of live threads with those left by threads that exited.
+// Every Nth contended acquisition also captures the waiter's backtrace,
+// which DUMP-LOCK-CONTENTION-STACKS writes in the folded format that
+// flamegraph.pl reads (see src/profiler/do-flame-locks).
+
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <cinttypes>
+#include <chrono>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <clasp/core/foundation.h>
+#include <clasp/core/object.h>
+#include <clasp/core/lisp.h>
+#include <clasp/core/symbol.h>
+#include <clasp/core/mpPackage.h>
+#include <clasp/core/array.h>
+#include <clasp/core/pathname.h>
+#include <clasp/core/debugger.h>
+#include <clasp/core/lispList.h>
+#include <clasp/core/wrappers.h>
+
+namespace mp {
+
+std::atomic<bool> global_lock_profiling(false);
+static std::atomic<uint32_t> global_lock_profile_sample_interval(16);
+
+static constexpr int LockProfileMaxFrames = 64;
+// lock_profile_record and the profiled lock function.
+static constexpr int LockProfileSkipFrames = 2;
+
+struct LockStats {
+  uint64_t _NameWord = 0;
+  uint64_t _Acquisitions = 0;
+  uint64_t _Contended = 0;
+  uint64_t _TotalWaitNs = 0;
+  uint64_t _MaxWaitNs = 0;
+  void merge(const LockStats& other) {
+    this->_NameWord = other._NameWord;
+    this->_Acquisitions += other._Acquisitions;
+    this->_Contended += other._Contended;
+    this->_TotalWaitNs += other._TotalWaitNs;
+    this->_MaxWaitNs = std::max(this->_MaxWaitNs, other._MaxWaitNs);
+  }
+};
+
+// A sampled stack is keyed by the lock's nameword followed by the return
+// addresses, innermost first; the value is the total wait in nanoseconds.
+typedef std::map<std::vector<uintptr_t>, uint64_t> LockStacks;
+
+struct LockProfile {
+  std::unordered_map<const void*, LockStats> _Locks;
+  LockStacks _Stacks;
+  void merge(const LockProfile& other) {
+    for (auto& entry : other._Locks)
+      this->_Locks[entry.first].merge(entry.second);
+    for (auto& entry : other._Stacks)
+      this->_Stacks[entry.first] += entry.second;
+  }
+  void clear() {
+    this->_Locks.clear();
+    this->_Stacks.clear();
+  }
+};
+
+struct ThreadLockProfile;
+
+// Guards the registry and the profile of exited threads. A std::mutex,
+// not an mp::Mutex, so that the profiler does not profile itself.
+static std::mutex global_lock_profiles_mutex;
+static std::vector<ThreadLockProfile*> global_lock_profiles;
+static LockProfile global_exited_lock_profile;
+
+struct ThreadLockProfile {
+  // Only contended while a report is being made.
+  std::mutex _Mutex;
+  LockProfile _Profile;
+  uint32_t _ContendedSinceSample = 0;
+  ThreadLockProfile() {
+    std::lock_guard<std::mutex> guard(global_lock_profiles_mutex);
+    global_lock_profiles.push_back(this);
+  }
+  ~ThreadLockProfile() {
+    std::lock_guard<std::mutex> guard(global_lock_profiles_mutex);
+    global_lock_profiles.erase(std::find(global_lock_profiles.begin(), global_lock_profiles.end(), this));
+    global_exited_lock_profile.merge(this->_Profile);
+  }
+};
+
+static thread_local ThreadLockProfile my_lock_profile;
+
+uint64_t lock_profile_now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void lock_profile_record(const void* lock, uint64_t nameword, uint64_t wait_ns, bool contended, bool acquired) {
+  ThreadLockProfile& profile = my_lock_profile;
+  std::lock_guard<std::mutex> guard(profile._Mutex);
+  LockStats& stats = profile._Profile._Locks[lock];
+  stats._NameWord = nameword;
+  if (acquired)
+    ++stats._Acquisitions;
+  if (!contended)
+    return;
+  ++stats._Contended;
+  stats._TotalWaitNs += wait_ns;
+  stats._MaxWaitNs = std::max(stats._MaxWaitNs, wait_ns);
+  uint32_t interval = global_lock_profile_sample_interval.load(std::memory_order_relaxed);
+  if (interval && ++profile._ContendedSinceSample >= interval) {
+    profile._ContendedSinceSample = 0;
+    void* frames[LockProfileMaxFrames];
+    int nframes = backtrace(frames, LockProfileMaxFrames);
+    std::vector<uintptr_t> key;
+    key.reserve(nframes + 1);
+    key.push_back(nameword);
+    for (int i = LockProfileSkipFrames; i < nframes; ++i)
+      key.push_back((uintptr_t)frames[i]);
+    profile._Profile._Stacks[key] += wait_ns;
+  }
+}
+
+bool Mutex::profiled_lock(bool waitp) {
+  if (this->reenter() || this->_Lock.try_lock()) {
+    this->acquired();
+    lock_profile_record(this, this->_NameWord, 0, false, true);
+  } else if (!waitp)
+    return false;
+  else {
+    uint64_t start = lock_profile_now();
+    {
+#ifdef DEBUG_DTRACE_LOCK_PROBE
+      DtraceLockProbe _guard((char*)&this->_NameWord);
+#endif
+      this->_Lock.lock();
+    }
+    this->acquired();
+    lock_profile_record(this, this->_NameWord, lock_profile_now() - start, true, true);
+  }
+  if (waitp)
+    ++this->_Counter;
+  return true;
+}
+
+static void collect_lock_profile(LockProfile& result) {
+  std::lock_guard<std::mutex> guard(global_lock_profiles_mutex);
+  result.merge(global_exited_lock_profile);
+  for (ThreadLockProfile* profile : global_lock_profiles) {
+    std::lock_guard<std::mutex> thread_guard(profile->_Mutex);
+    result.merge(profile->_Profile);
+  }
+}
+
+static std::string nameword_string(uint64_t nameword) {
+  const char* chars = (const char*)&nameword;
+  std::string name(chars, strnlen(chars, sizeof(nameword)));
+  while (!name.empty() && name.back() == ' ')
+    name.pop_back();
+  return name;
+}
+
+static std::string frame_name(uintptr_t address) {
+  const char* symbol = NULL;
+  uintptr_t start, end;
+  // Return addresses point after the call.
+  if (core::lookup_address(address - 1, symbol, start, end) && symbol)
+    return symbol;
+  Dl_info info;
+  if (dladdr((void*)(address - 1), &info) && info.dli_sname) {
+    int status;
+    char* demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+    if (status == 0 && demangled) {
+      std::string name(demangled);
+      free(demangled);
+      return name;
+    }
+    return info.dli_sname;
+  }
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "0x%" PRIxPTR, address);
+  return buffer;
+}
+
+static double ns_to_seconds(uint64_t ns) { return (double)ns / 1.0e9; }
+
+CL_LAMBDA(&key (sample-interval 16));
+CL_DOCSTRING(R"dx(Start recording, for every mutex, the number of acquisitions and the time threads spend waiting for it. The backtrace of every SAMPLE-INTERVAL-th contended acquisition in each thread is also kept; zero keeps none. Recording adds to what was recorded before; see RESET-LOCK-CONTENTION-PROFILE.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void mp__start_lock_contention_profiling(size_t sample_interval) {
+  global_lock_profile_sample_interval.store(sample_interval);
+  global_lock_profiling.store(true);
+}
+
+CL_DOCSTRING(R"dx(Stop recording lock contention. What was recorded is kept.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void mp__stop_lock_contention_profiling() { global_lock_profiling.store(false); }
+
+CL_DOCSTRING(R"dx(Forget all recorded lock contention.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void mp__reset_lock_contention_profile() {
+  std::lock_guard<std::mutex> guard(global_lock_profiles_mutex);
+  global_exited_lock_profile.clear();
+  for (ThreadLockProfile* profile : global_lock_profiles) {
+    std::lock_guard<std::mutex> thread_guard(profile->_Mutex);
+    profile->_Profile.clear();
+  }
+}
+
+SYMBOL_EXPORT_SC_(KeywordPkg, name);
+SYMBOL_EXPORT_SC_(KeywordPkg, lock);
+SYMBOL_EXPORT_SC_(KeywordPkg, locks);
+SYMBOL_EXPORT_SC_(KeywordPkg, acquisitions);
+SYMBOL_EXPORT_SC_(KeywordPkg, contended);
+SYMBOL_EXPORT_SC_(KeywordPkg, total_wait);
+SYMBOL_EXPORT_SC_(KeywordPkg, max_wait);
+
+CL_LAMBDA(&key (group-by :name));
+CL_DOCSTRING(R"dx(Return a list of the recorded lock contention, most total wait first. Each entry is a plist of :NAME, :ACQUISITIONS, :CONTENDED, :TOTAL-WAIT and :MAX-WAIT (in seconds). If GROUP-BY is :NAME, the locks that share a name are summed and :LOCKS gives how many there were; if it is :LOCK, each lock has an entry and :LOCK gives its address. Lock names are truncated to seven characters.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::List_sp mp__lock_contention_report(core::Symbol_sp group_by) {
+  if (group_by != kw::_sym_name && group_by != kw::_sym_lock)
+    SIMPLE_ERROR("Invalid group-by {}, must be either :NAME or :LOCK", _rep_(group_by));
+  LockProfile profile;
+  collect_lock_profile(profile);
+  struct Entry {
+    std::string _Name;
+    const void* _Lock;
+    size_t _Locks;
+    LockStats _Stats;
+  };
+  std::vector<Entry> entries;
+  if (group_by == kw::_sym_lock) {
+    for (auto& lock : profile._Locks)
+      entries.push_back(Entry{nameword_string(lock.second._NameWord), lock.first, 1, lock.second});
+  } else {
+    std::map<std::string, size_t> byName;
+    for (auto& lock : profile._Locks) {
+      std::string name = nameword_string(lock.second._NameWord);
+      auto found = byName.find(name);
+      if (found == byName.end()) {
+        byName[name] = entries.size();
+        entries.push_back(Entry{name, NULL, 1, lock.second});
+      } else {
+        Entry& entry = entries[found->second];
+        ++entry._Locks;
+        entry._Stats._Acquisitions += lock.second._Acquisitions;
+        entry._Stats._Contended += lock.second._Contended;
+        entry._Stats._TotalWaitNs += lock.second._TotalWaitNs;
+        entry._Stats._MaxWaitNs = std::max(entry._Stats._MaxWaitNs, lock.second._MaxWaitNs);
+      }
+    }
+  }
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+    if (a._Stats._TotalWaitNs != b._Stats._TotalWaitNs)
+      return a._Stats._TotalWaitNs > b._Stats._TotalWaitNs;
+    return a._Stats._Acquisitions > b._Stats._Acquisitions;
+  });
+  ql::list result;
+  for (auto& entry : entries) {
+    ql::list plist;
+    plist << kw::_sym_name << core::SimpleBaseString_O::make(entry._Name);
+    if (group_by == kw::_sym_lock)
+      plist << kw::_sym_lock << core::Integer_O::create((uintptr_t)entry._Lock);
+    else
+      plist << kw::_sym_locks << core::make_fixnum(entry._Locks);
+    plist << kw::_sym_acquisitions << core::Integer_O::create(entry._Stats._Acquisitions) << kw::_sym_contended
+          << core::Integer_O::create(entry._Stats._Contended) << kw::_sym_total_wait
+          << core::DoubleFloat_O::create(ns_to_seconds(entry._Stats._TotalWaitNs)) << kw::_sym_max_wait
+          << core::DoubleFloat_O::create(ns_to_seconds(entry._Stats._MaxWaitNs));
+    result << plist.cons();
+  }
+  return result.cons();
+}
+
+CL_DOCSTRING(R"dx(Write the sampled backtraces of contended lock acquisitions to the file PATHNAME, one line per distinct stack in the folded format of flamegraph.pl: the lock name and the frames from outermost to innermost separated by semicolons, then the microseconds spent waiting there. Return the number of stacks written.)dx");
+DOCGROUP(clasp);
+CL_DEFUN size_t mp__dump_lock_contention_stacks(core::T_sp pathname) {
+  std::string filename = core::core__coerce_to_filename(pathname)->get_std_string();
+  LockProfile profile;
+  collect_lock_profile(profile);
+  FILE* fout = fopen(filename.c_str(), "w");
+  if (!fout)
+    SIMPLE_ERROR("Could not open {} for writing - {}", filename, strerror(errno));
+  std::unordered_map<uintptr_t, std::string> names;
+  size_t count = 0;
+  for (auto& stack : profile._Stacks) {
+    const std::vector<uintptr_t>& key = stack.first;
+    std::string line = "lock:" + nameword_string(key[0]);
+    for (size_t i = key.size() - 1; i > 0; --i) {
+      auto found = names.find(key[i]);
+      if (found == names.end()) {
+        std::string name = frame_name(key[i]);
+        std::replace(name.begin(), name.end(), ';', ':');
+        found = names.emplace(key[i], name).first;
+      }
+      line += ";" + found->second;
+    }
+    fprintf(fout, "%s %" PRIu64 "\n", line.c_str(), std::max<uint64_t>(1, stack.second / 1000));
+    ++count;
+  }
+  fclose(fout);
+  return count;
+}
+
+}; // namespace mp
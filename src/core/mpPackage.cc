@@ -27,6 +27,15 @@ THE SOFTWARE.
 
 #include <sched.h>
 #include <sys/types.h>
+#include <time.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <mutex>
+#include <condition_variable>
+#endif
 #include <clasp/core/foundation.h>
 #include <clasp/core/object.h>
 #include <clasp/core/lisp.h>
@@ -34,6 +43,7 @@ THE SOFTWARE.
 #include <clasp/core/symbol.h>
 #include <clasp/core/pointer.h>
 #include <clasp/core/mpPackage.h>
+#include <clasp/core/array.h>
 #include <clasp/core/multipleValues.h>
 #include <clasp/core/primitives.h>
 #include <clasp/core/designators.h>
@@ -222,7 +232,7 @@ __attribute__((noinline)) void start_thread_inner(uintptr_t uniqueId, void* cold
 #endif
   gctools::ThreadLocalStateLowLevel thread_local_state_low_level(cold_end_of_stack);
   core::ThreadLocalState thread_local_state;
-  thread_local_state.startUpVM();
+  thread_local_state.startUpVM(process->_VMStackSize);
   my_thread_low_level = &thread_local_state_low_level;
   my_thread = &thread_local_state;
 //  printf("%s:%d entering start_thread  &my_thread -> %p \n", __FILE__, __LINE__, (void*)&my_thread);
@@ -381,16 +391,18 @@ CL_DEFUN void mp__process_start(Process_sp process) {
 };
 
 CL_DOCSTRING(
-    R"dx(Convenience function that creates a process and then immediately starts it. Arguments are as in MAKE-PROCESS; the ARGUMENTS parameter is always NIL.)dx");
-CL_LAMBDA(name function &optional special_bindings);
+    R"dx(Convenience function that creates a process and then immediately starts it. Arguments are as in MAKE-PROCESS; the ARGUMENTS parameter is always NIL. VM-STACK-SIZE is the number of bytes of address space reserved for the process's bytecode VM stack, which is committed as it is used; zero means the default.)dx");
+CL_LAMBDA(name function &optional special_bindings (vm-stack-size 0));
 DOCGROUP(clasp);
-CL_DEFUN Process_sp mp__process_run_function(core::T_sp name, core::T_sp function, core::List_sp special_bindings) {
+CL_DEFUN Process_sp mp__process_run_function(core::T_sp name, core::T_sp function, core::List_sp special_bindings,
+                                             size_t vm_stack_size) {
 #ifdef DEBUG_FASTGF
   core::Cons_sp fastgf = core::Cons_O::create(core::_sym_STARdebug_fastgfSTAR, nil<core::T_O>());
   special_bindings = core::Cons_O::create(fastgf, special_bindings);
 #endif
   if (cl__functionp(function)) {
-    Process_sp process = Process_O::make_process(name, function, nil<core::T_O>(), special_bindings, DEFAULT_THREAD_STACK_SIZE);
+    Process_sp process = Process_O::make_process(name, function, nil<core::T_O>(), special_bindings, DEFAULT_THREAD_STACK_SIZE,
+                                                 vm_stack_size);
     // The process needs to be added to the list of processes before process->start() is called.
     // The child process code needs this to find the process in the list
     _lisp->add_process(process);
@@ -730,6 +742,309 @@ string ConditionVariable_O::__repr__() const {
   return ss.str();
 }
 
+#ifndef __linux__
+// Without futexes, hash each word to a mutex and condition variable.
+// A waiter checks the word while holding its bucket's mutex and a waker
+// changes the word before taking that mutex, so no wakeup is lost.
+namespace {
+struct FutexBucket {
+  std::mutex _Mutex;
+  std::condition_variable _CV;
+};
+FutexBucket futex_buckets[64];
+FutexBucket& futex_bucket(std::atomic<uint32_t>* word) {
+  return futex_buckets[(reinterpret_cast<uintptr_t>(word) >> 2) % 64];
+}
+}; // namespace
+#endif
+
+void futex_wait(std::atomic<uint32_t>* word, uint32_t expected, double timeout) {
+#ifdef __linux__
+  struct timespec ts;
+  struct timespec* pts = NULL;
+  if (timeout >= 0.0) {
+    ts.tv_sec = (time_t)timeout;
+    ts.tv_nsec = (long)((timeout - (double)ts.tv_sec) * 1e9);
+    pts = &ts;
+  }
+  syscall(SYS_futex, (uint32_t*)word, FUTEX_WAIT_PRIVATE, expected, pts, NULL, 0);
+#else
+  FutexBucket& bucket = futex_bucket(word);
+  std::unique_lock<std::mutex> guard(bucket._Mutex);
+  if (word->load(std::memory_order_seq_cst) != expected)
+    return;
+  if (timeout >= 0.0)
+    bucket._CV.wait_for(guard, std::chrono::duration<double>(timeout));
+  else
+    bucket._CV.wait(guard);
+#endif
+}
+
+void futex_wake(std::atomic<uint32_t>* word, int nwaiters) {
+#ifdef __linux__
+  syscall(SYS_futex, (uint32_t*)word, FUTEX_WAKE_PRIVATE, nwaiters, NULL, NULL, 0);
+#else
+  // Other words share the bucket, so wake everyone and let them recheck.
+  (void)nwaiters;
+  FutexBucket& bucket = futex_bucket(word);
+  std::lock_guard<std::mutex> guard(bucket._Mutex);
+  bucket._CV.notify_all();
+#endif
+}
+
+void AdaptiveLock::lock_slow() {
+  uint32_t state = this->_State.load(std::memory_order_relaxed);
+  // Critical sections are mostly short; spinning a little is much cheaper
+  // than sleeping. Once others are parked, though, join them.
+  for (int round = 0; round < SpinRounds && state != 2; ++round) {
+    for (int i = 0; i < (1 << round); ++i)
+      cpu_relax();
+    state = this->_State.load(std::memory_order_relaxed);
+    if (state == 0 && this->_State.compare_exchange_weak(state, 1, std::memory_order_acquire, std::memory_order_relaxed))
+      return;
+  }
+  // Mark the lock as having waiters, so that unlock wakes one.
+  while (this->_State.exchange(2, std::memory_order_acquire) != 0)
+    futex_wait(&this->_State, 2, -1.0);
+}
+
+ConcurrentQueue_sp ConcurrentQueue_O::make_concurrent_queue(core::T_sp name, core::T_sp capacity) {
+  size_t size = 0;
+  if (capacity.notnilp()) {
+    if (!capacity.fixnump() || capacity.unsafe_fixnum() < 1 || capacity.unsafe_fixnum() > (1 << 30))
+      SIMPLE_ERROR("The capacity of a concurrent queue must be NIL or an integer between 1 and 2^30, not {}", _rep_(capacity));
+    size_t want = capacity.unsafe_fixnum();
+    size = 1;
+    while (size < want)
+      size <<= 1;
+  }
+  return gctools::GC<ConcurrentQueue_O>::allocate(name, size);
+}
+
+ConcurrentQueue_O::ConcurrentQueue_O(core::T_sp name, size_t capacity)
+    : _Name(name), _Slots(nil<core::T_O>()), _Mask(0), _Sequence(NULL), _EnqueuePos(0), _DequeuePos(0), _Epoch(0), _Sleepers(0) {
+  core::T_sp dummy = core::Cons_O::create(nil<core::T_O>(), nil<core::T_O>());
+  this->_Head.store(dummy);
+  this->_Tail.store(dummy);
+  if (capacity) {
+    this->_Slots = core::SimpleVector_O::make(capacity, nil<core::T_O>());
+    this->_Mask = capacity - 1;
+    this->_Sequence = new std::atomic<size_t>[capacity];
+    for (size_t i = 0; i < capacity; ++i)
+      this->_Sequence[i].store(i, std::memory_order_relaxed);
+  }
+}
+
+ConcurrentQueue_O::~ConcurrentQueue_O() { delete[] this->_Sequence; }
+
+// The sequence numbers of a bounded queue live outside the GC heap, so a
+// bounded queue comes back from a snapshot empty.
+void ConcurrentQueue_O::fixupInternalsForSnapshotSaveLoad(snapshotSaveLoad::Fixup* fixup) {
+  if (snapshotSaveLoad::operation(fixup) == snapshotSaveLoad::LoadOp && this->boundedp()) {
+    size_t capacity = this->_Mask + 1;
+    core::SimpleVector_sp slots = gc::As_unsafe<core::SimpleVector_sp>(this->_Slots);
+    this->_Sequence = new std::atomic<size_t>[capacity];
+    for (size_t i = 0; i < capacity; ++i) {
+      this->_Sequence[i].store(i, std::memory_order_relaxed);
+      (*slots)[i] = nil<core::T_O>();
+    }
+    this->_EnqueuePos.store(0, std::memory_order_relaxed);
+    this->_DequeuePos.store(0, std::memory_order_relaxed);
+  }
+  this->_Epoch.store(0, std::memory_order_relaxed);
+  this->_Sleepers.store(0, std::memory_order_relaxed);
+}
+
+bool ConcurrentQueue_O::push(core::T_sp item) {
+  if (this->boundedp()) {
+    core::SimpleVector_sp slots = gc::As_unsafe<core::SimpleVector_sp>(this->_Slots);
+    size_t pos = this->_EnqueuePos.load(std::memory_order_relaxed);
+    while (true) {
+      std::atomic<size_t>& seq = this->_Sequence[pos & this->_Mask];
+      intptr_t diff = (intptr_t)seq.load(std::memory_order_acquire) - (intptr_t)pos;
+      if (diff == 0) {
+        if (this->_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          (*slots)[pos & this->_Mask] = item;
+          seq.store(pos + 1, std::memory_order_release);
+          break;
+        }
+      } else if (diff < 0)
+        return false; // full
+      else
+        pos = this->_EnqueuePos.load(std::memory_order_relaxed);
+    }
+  } else {
+    core::T_sp node = core::Cons_O::create(item, nil<core::T_O>());
+    while (true) {
+      core::Cons_sp tail = gc::As_unsafe<core::Cons_sp>(this->_Tail.load(std::memory_order_acquire));
+      core::T_sp next = tail->_Cdr.load(std::memory_order_acquire);
+      if (next.nilp()) {
+        core::T_sp expected = nil<core::T_O>();
+        if (tail->_Cdr.compare_exchange_weak(expected, node, std::memory_order_release, std::memory_order_relaxed)) {
+          core::T_sp ttail = tail;
+          this->_Tail.compare_exchange_strong(ttail, node, std::memory_order_release, std::memory_order_relaxed);
+          break;
+        }
+      } else {
+        // Tail is lagging; help the other producer along.
+        core::T_sp ttail = tail;
+        this->_Tail.compare_exchange_weak(ttail, next, std::memory_order_release, std::memory_order_relaxed);
+      }
+    }
+  }
+  // seq_cst so that either we see a consumer that is about to sleep, or
+  // it sees our epoch and rechecks the queue. See pop_wait.
+  this->_Epoch.fetch_add(1, std::memory_order_seq_cst);
+  if (this->_Sleepers.load(std::memory_order_seq_cst) != 0)
+    futex_wake(&this->_Epoch, 1);
+  return true;
+}
+
+bool ConcurrentQueue_O::try_pop(core::T_sp& item) {
+  if (this->boundedp()) {
+    core::SimpleVector_sp slots = gc::As_unsafe<core::SimpleVector_sp>(this->_Slots);
+    size_t pos = this->_DequeuePos.load(std::memory_order_relaxed);
+    while (true) {
+      std::atomic<size_t>& seq = this->_Sequence[pos & this->_Mask];
+      intptr_t diff = (intptr_t)seq.load(std::memory_order_acquire) - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (this->_DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          item = (*slots)[pos & this->_Mask];
+          (*slots)[pos & this->_Mask] = nil<core::T_O>(); // don't retain it
+          seq.store(pos + this->_Mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0)
+        return false; // empty
+      else
+        pos = this->_DequeuePos.load(std::memory_order_relaxed);
+    }
+  }
+  while (true) {
+    core::T_sp thead = this->_Head.load(std::memory_order_acquire);
+    core::Cons_sp head = gc::As_unsafe<core::Cons_sp>(thead);
+    core::T_sp next = head->_Cdr.load(std::memory_order_acquire);
+    if (next.nilp())
+      return false;
+    core::Cons_sp nnext = gc::As_unsafe<core::Cons_sp>(next);
+    core::T_sp value = nnext->_Car.load(std::memory_order_relaxed);
+    if (this->_Head.compare_exchange_weak(thead, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      // Keep the tail from pointing behind the head.
+      core::T_sp ttail = thead;
+      this->_Tail.compare_exchange_strong(ttail, next, std::memory_order_release, std::memory_order_relaxed);
+      // NEXT is the new dummy. Anyone else who read its car lost the
+      // race for _Head and will retry, so we can drop the reference.
+      nnext->_Car.store(nil<core::T_O>(), std::memory_order_relaxed);
+      item = value;
+      return true;
+    }
+  }
+}
+
+bool ConcurrentQueue_O::pop_wait(core::T_sp& item, double timeout) {
+  if (this->try_pop(item))
+    return true;
+  if (timeout == 0.0)
+    return false;
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  while (true) {
+    double remaining = -1.0;
+    if (timeout > 0.0) {
+      struct timespec now;
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      double elapsed = (double)(now.tv_sec - start.tv_sec) + (double)(now.tv_nsec - start.tv_nsec) * 1e-9;
+      remaining = timeout - elapsed;
+      if (remaining <= 0.0)
+        return this->try_pop(item);
+    }
+    this->_Sleepers.fetch_add(1, std::memory_order_seq_cst);
+    uint32_t epoch = this->_Epoch.load(std::memory_order_seq_cst);
+    if (this->try_pop(item)) {
+      this->_Sleepers.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+    futex_wait(&this->_Epoch, epoch, remaining);
+    this->_Sleepers.fetch_sub(1, std::memory_order_relaxed);
+    gctools::handle_all_queued_interrupts();
+    if (this->try_pop(item))
+      return true;
+  }
+}
+
+size_t ConcurrentQueue_O::count() const {
+  if (this->boundedp()) {
+    size_t out = this->_DequeuePos.load(std::memory_order_relaxed);
+    size_t in = this->_EnqueuePos.load(std::memory_order_relaxed);
+    return in > out ? in - out : 0;
+  }
+  size_t n = 0;
+  core::Cons_sp head = gc::As_unsafe<core::Cons_sp>(this->_Head.load(std::memory_order_acquire));
+  for (core::T_sp cur = head->_Cdr.load(std::memory_order_acquire); cur.consp();
+       cur = gc::As_unsafe<core::Cons_sp>(cur)->_Cdr.load(std::memory_order_acquire))
+    ++n;
+  return n;
+}
+
+string ConcurrentQueue_O::__repr__() const {
+  stringstream ss;
+  ss << "#<CONCURRENT-QUEUE ";
+  ss << _rep_(this->_Name);
+  if (this->boundedp())
+    ss << " :capacity " << (this->_Mask + 1);
+  ss << ">";
+  return ss.str();
+}
+
+CL_DOCSTRING(R"dx(Add ITEM to the end of QUEUE. Return true, or false if QUEUE is bounded and full.)dx");
+DOCGROUP(clasp);
+CL_DEFUN bool mp__concurrent_queue_push(ConcurrentQueue_sp queue, core::T_sp item) { return queue->push(item); }
+
+CL_DOCSTRING(R"dx(Remove and return the first item of QUEUE and true. If QUEUE is empty, return NIL and false without waiting.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_mv mp__concurrent_queue_try_pop(ConcurrentQueue_sp queue) {
+  core::T_sp item;
+  if (queue->try_pop(item))
+    return Values(item, _lisp->_true());
+  return Values(nil<core::T_O>(), nil<core::T_O>());
+}
+
+CL_LAMBDA(queue &optional timeout);
+CL_DOCSTRING(R"dx(Remove and return the first item of QUEUE and true, waiting for one to be pushed if QUEUE is empty. If TIMEOUT (in seconds) is non-NIL and runs out first, return NIL and false.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_mv mp__concurrent_queue_pop(ConcurrentQueue_sp queue, core::T_sp timeout) {
+  double seconds = timeout.nilp() ? -1.0 : std::max(0.0, core::clasp_to_double(gc::As<core::Real_sp>(timeout)));
+  core::T_sp item;
+  if (queue->pop_wait(item, seconds))
+    return Values(item, _lisp->_true());
+  return Values(nil<core::T_O>(), nil<core::T_O>());
+}
+
+CL_DOCSTRING(R"dx(Return the number of items in QUEUE. Other threads may change this at any time.)dx");
+DOCGROUP(clasp);
+CL_DEFUN size_t mp__concurrent_queue_count(ConcurrentQueue_sp queue) { return queue->count(); }
+
+CL_DOCSTRING(R"dx(Return true if QUEUE has no items. Other threads may change this at any time.)dx");
+DOCGROUP(clasp);
+CL_DEFUN bool mp__concurrent_queue_emptyp(ConcurrentQueue_sp queue) {
+  if (queue->boundedp())
+    return queue->count() == 0;
+  core::Cons_sp head = gc::As_unsafe<core::Cons_sp>(queue->_Head.load(std::memory_order_acquire));
+  return head->_Cdr.load(std::memory_order_acquire).nilp();
+}
+
+CL_DOCSTRING(R"dx(Return the name of QUEUE.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_sp mp__concurrent_queue_name(ConcurrentQueue_sp queue) { return queue->_Name; }
+
+CL_DOCSTRING(R"dx(Return the capacity of QUEUE, or NIL if it is unbounded.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_sp mp__concurrent_queue_capacity(ConcurrentQueue_sp queue) {
+  if (queue->boundedp())
+    return core::clasp_make_fixnum(queue->_Mask + 1);
+  return nil<core::T_O>();
+}
+
 DOCGROUP(clasp);
 CL_DEFUN void mp__push_default_special_binding(core::Symbol_sp symbol, core::T_sp form) {
   _lisp->push_default_special_binding(symbol, form);
@@ -489,11 +489,10 @@ void Package_O::initialize() {
   this->_InternalSymbols = HashTableEqual_O::create_default();
   this->_ExternalSymbols = HashTableEqual_O::create_default();
   this->_Shadowing = HashTableEq_O::create_default();
-#if 0
+  // The symbol tables are read without the package lock by findSymbol_optimistic,
+  // which relies on the tables' own write versions to detect concurrent changes.
   this->_InternalSymbols->setupThreadSafeHashTable();
   this->_ExternalSymbols->setupThreadSafeHashTable();
-  this->_Shadowing->setupThreadSafeHashTable();
-#endif
   this->_KeywordPackage = false;
   this->_AmpPackage = false;
 }
@@ -590,7 +589,67 @@ Symbol_mv Package_O::findSymbol_SimpleString_no_lock(SimpleString_sp nameKey) co
   return Values(nil<Symbol_O>(), nil<Symbol_O>());
 }
 
+#ifdef CLASP_THREADS
+// How many times an optimistic reader retries before it takes the read lock.
+#define PACKAGE_OPTIMISTIC_READ_TRIES 8
+
+// Same search as findSymbol_SimpleString_no_lock but without the package lock.
+// The symbol tables validate their own probes, and _WriteVersion catches a writer
+// that moved the symbol between tables or changed the use list while we looked.
+bool Package_O::findSymbol_optimistic(SimpleString_sp nameKey, Symbol_sp& sym, Symbol_sp& status) const {
+  for (size_t tries = 0; tries < PACKAGE_OPTIMISTIC_READ_TRIES; ++tries) {
+    size_t version = this->_WriteVersion.load(std::memory_order_acquire);
+    if (version & 1)
+      continue; // a writer is active
+    T_sp value;
+    bool foundp = false;
+    Symbol_sp foundStatus = nil<Symbol_O>();
+    if (!this->_ExternalSymbols->gethash_optimistic(nameKey, value, foundp))
+      continue;
+    if (foundp) {
+      foundStatus = kw::_sym_external;
+    } else if (!this->isKeywordPackage()) {
+      if (!this->_InternalSymbols->gethash_optimistic(nameKey, value, foundp))
+        continue;
+      if (foundp) {
+        foundStatus = kw::_sym_internal;
+      } else {
+        // Snapshot the use list - a writer may swap in new contents under us.
+        gctools::tagged_pointer<gctools::GCVector_moveable<Package_sp>> used = this->_UsingPackages._Vector._Contents;
+        size_t numUsed = used ? used->_End : 0;
+        bool raced = false;
+        for (size_t idx = 0; idx < numUsed; ++idx) {
+          if (!(*used)[idx]->_ExternalSymbols->gethash_optimistic(nameKey, value, foundp)) {
+            raced = true;
+            break;
+          }
+          if (foundp) {
+            foundStatus = kw::_sym_inherited;
+            break;
+          }
+        }
+        if (raced)
+          continue;
+      }
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (this->_WriteVersion.load(std::memory_order_relaxed) == version) {
+      sym = foundp ? gc::As_unsafe<Symbol_sp>(value) : nil<Symbol_O>();
+      status = foundStatus;
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
 Symbol_mv Package_O::findSymbol_SimpleString(SimpleString_sp nameKey) const {
+#ifdef CLASP_THREADS
+  Symbol_sp sym;
+  Symbol_sp status;
+  if (this->findSymbol_optimistic(nameKey, sym, status))
+    return Values(sym, status);
+#endif
   WITH_PACKAGE_READ_LOCK(this);
   return this->findSymbol_SimpleString_no_lock(nameKey);
 }
@@ -698,7 +757,8 @@ bool Package_O::usePackage(Package_sp usePackage) {
   while (true) {
     FindConflicts findConflicts(this->asSmartPtr());
     {
-      WITH_PACKAGE_READ_LOCK(this);
+      // The write lock - the use list changes below.
+      WITH_PACKAGE_READ_WRITE_LOCK(this);
       if (this->usingPackageP_no_lock(usePackage)) {
         LOG("You are already using that package");
         return true;
@@ -913,6 +973,18 @@ void Package_O::bootstrap_add_symbol_to_package(const char* symName, Symbol_sp s
 }
 
 T_mv Package_O::intern(SimpleString_sp name) {
+#ifdef CLASP_THREADS
+  // Most interns find an existing symbol - do that without the write lock.
+  {
+    Symbol_sp sym;
+    Symbol_sp status;
+    if (this->findSymbol_optimistic(name, sym, status) && status.notnilp()) {
+      if (this->actsLikeKeywordPackage())
+        sym->setf_symbolValue(sym);
+      return Values(sym, status);
+    }
+  }
+#endif
   WITH_PACKAGE_READ_WRITE_LOCK(this);
   //  client_validate(name);
   Symbol_mv values = this->findSymbol_SimpleString_no_lock(name);
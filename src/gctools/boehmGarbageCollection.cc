@@ -393,6 +393,47 @@ int globalBoehmMarker = 0;
 #endif
 
 namespace gctools {
+BoehmPauseStatistics global_boehm_pause_statistics;
+
+static void boehm_collection_event(GC_EventType event) {
+  BoehmPauseStatistics& stats = global_boehm_pause_statistics;
+  if (event == GC_EVENT_PRE_STOP_WORLD) {
+    stats._PauseStart = std::chrono::steady_clock::now();
+  } else if (event == GC_EVENT_POST_START_WORLD) {
+    uint64_t ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - stats._PauseStart).count();
+    stats._Pauses.fetch_add(1, std::memory_order_relaxed);
+    stats._TotalPauseNs.fetch_add(ns, std::memory_order_relaxed);
+    stats._RealTimeNs.fetch_add(ns, std::memory_order_relaxed);
+    if (ns > stats._MaxPauseNs.load(std::memory_order_relaxed))
+      stats._MaxPauseNs.store(ns, std::memory_order_relaxed);
+  }
+}
+
+/*! CLASP_GC_INCREMENTAL turns on incremental, generational collection. The
+    collector then marks a little at a time as threads allocate and only stops
+    the world to finish a cycle, when it rescans just the pages that were written
+    since it last looked. It learns which those are from the kernel's soft-dirty
+    bits where it can and otherwise by write protecting the pointer-containing
+    heap; either way the stores done by C++ and by compiled code are seen without
+    any barrier of our own. Pointer-free objects are never protected, which is
+    what keeps read(2) into strings and octet vectors working.
+    CLASP_GC_PAUSE_MS sets the pause the collector aims for and
+    CLASP_GC_FULL_FREQ the number of partial collections between full ones. */
+static void boehm_configure_incremental() {
+  const char* incremental = getenv("CLASP_GC_INCREMENTAL");
+  if (!incremental || !*incremental || strcmp(incremental, "0") == 0)
+    return;
+  // The write fault handler that GC_enable_incremental may install passes the
+  // faults it does not own to the handler that was there before it, so this
+  // relies on initialize_signals having already installed handle_segv.
+  GC_enable_incremental();
+  if (const char* pause = getenv("CLASP_GC_PAUSE_MS"))
+    GC_set_time_limit(strtoul(pause, NULL, 10));
+  if (const char* full = getenv("CLASP_GC_FULL_FREQ"))
+    GC_set_full_freq(atoi(full));
+}
+
 __attribute__((noinline)) void startupBoehm(gctools::ClaspInfo* claspInfo) {
   GC_set_handle_fork(1);
   GC_INIT();
@@ -401,7 +442,8 @@ __attribute__((noinline)) void startupBoehm(gctools::ClaspInfo* claspInfo) {
   GC_set_all_interior_pointers(1); // tagged pointers require this
                                    // printf("%s:%d Turning on interior pointers\n",__FILE__,__LINE__);
   GC_set_warn_proc(clasp_warn_proc);
-  //  GC_enable_incremental();
+  GC_set_on_collection_event(boehm_collection_event);
+  boehm_configure_incremental();
   GC_init();
   // ctor sets up my_thread
   gctools::ThreadLocalStateLowLevel* thread_local_state_low_level = new gctools::ThreadLocalStateLowLevel(claspInfo);
@@ -544,9 +586,11 @@ CL_DEFUN size_t core__dynamic_space_size() { return GC_get_total_bytes(); }
 
 CL_DEFUN size_t core__dynamic_usage() { return GC_get_heap_size(); }
 
+CL_DOCSTRING(R"dx(Return the time, in internal time units, that the garbage collector has kept all threads stopped.)dx");
+DOCGROUP(clasp);
 CL_DEFUN size_t core__gc_real_time() {
-  IMPLEMENT_MEF("Find a way to measure time spent gc'ing");
-  return 0;
+  return global_boehm_pause_statistics._RealTimeNs.load(std::memory_order_relaxed) /
+         (1000000000 / CLASP_INTERNAL_TIME_UNITS_PER_SECOND);
 }
 
 void clasp_gc_registerRoots(void* rootsStart, size_t numberOfRoots) {
@@ -475,7 +475,7 @@ CL_DEFUN core::T_mv cl__room(core::Symbol_sp x) {
 
 namespace gctools {
 
-CL_LAMBDA(filename &key executable test-memory);
+CL_LAMBDA(filename &key executable test-memory compress);
 CL_DECLARE();
 CL_DOCSTRING(R"dx(Save a snapshot, i.e. enough information to restart a Lisp process
 later in the same state, in the file of the specified name. Only
@@ -488,18 +488,23 @@ The following &KEY arguments are defined:
      snapshot will not be executable on its own.
   :TEST-MEMORY
      Test memory prior to saving snapshot.
-     If NIL then snapshot saving is faster.)dx")
+     If NIL then snapshot saving is faster.
+  :COMPRESS
+     If true, compress the snapshot in independent sections using zstd
+     (or zlib if LLVM was built without zstd).  The snapshot is smaller
+     and is decompressed in parallel when it is loaded.)dx")
 DOCGROUP(clasp);
-CL_DEFUN void gctools__save_lisp_and_die(core::T_sp filename, core::T_sp executable, core::T_sp testMemory) {
+CL_DEFUN void gctools__save_lisp_and_die(core::T_sp filename, core::T_sp executable, core::T_sp testMemory, core::T_sp compress) {
 #ifdef USE_PRECISE_GC
   throw(core::SaveLispAndDie(gc::As<core::String_sp>(filename)->get_std_string(), executable.notnilp(),
-                             globals_->_Bundle->_Directories->_LibDir, true, core::noStomp, testMemory.notnilp() ));
+                             globals_->_Bundle->_Directories->_LibDir, true, core::noStomp, testMemory.notnilp(),
+                             compress.notnilp() ));
 #else
   SIMPLE_ERROR("save-lisp-and-die only works for precise GC");
 #endif
 }
 
-CL_LAMBDA(filename &key executable);
+CL_LAMBDA(filename &key executable compress);
 CL_DECLARE();
 CL_DOCSTRING(R"dx(Save a snapshot, i.e. enough information to restart a Lisp process
 later in the same state, in the file of the specified name. Only
@@ -510,12 +515,14 @@ The following &KEY arguments are defined:
   :EXECUTABLE
      If true, arrange to combine the Clasp runtime and the snapshot
      to create a standalone executable.  If false (the default), the
-     snapshot will not be executable on its own.)dx")
+     snapshot will not be executable on its own.
+  :COMPRESS
+     If true, compress the snapshot (see SAVE-LISP-AND-DIE).)dx")
 DOCGROUP(clasp);
-CL_DEFUN void gctools__save_lisp_and_continue(core::T_sp filename, core::T_sp executable) {
+CL_DEFUN void gctools__save_lisp_and_continue(core::T_sp filename, core::T_sp executable, core::T_sp compress) {
 #ifdef USE_PRECISE_GC
   core::SaveLispAndDie ee(gc::As<core::String_sp>(filename)->get_std_string(), executable.notnilp(),
-                          globals_->_Bundle->_Directories->_LibDir, false );
+                          globals_->_Bundle->_Directories->_LibDir, false, core::noStomp, true, compress.notnilp() );
   snapshotSaveLoad::snapshot_save(ee);
 #else
   SIMPLE_ERROR("save-lisp-and-continue only works for precise GC");
@@ -691,6 +698,43 @@ CL_DEFUN void gctools__garbage_collect() {
   //        printf("Garbage collection done\n");
 };
 
+SYMBOL_EXPORT_SC_(KeywordPkg, incremental);
+SYMBOL_EXPORT_SC_(KeywordPkg, write_protection);
+SYMBOL_EXPORT_SC_(KeywordPkg, collections);
+SYMBOL_EXPORT_SC_(KeywordPkg, pauses);
+SYMBOL_EXPORT_SC_(KeywordPkg, total_pause);
+SYMBOL_EXPORT_SC_(KeywordPkg, max_pause);
+
+CL_DOCSTRING(R"dx(Return a plist describing how long the garbage collector has stopped the world: :INCREMENTAL is true if it collects incrementally (see CLASP_GC_INCREMENTAL), :WRITE-PROTECTION is true if it finds written pages by write protecting the heap rather than from the kernel, :COLLECTIONS and :PAUSES count the collections and the stops of the world, and :TOTAL-PAUSE and :MAX-PAUSE are in seconds. See RESET-GC-PAUSE-STATISTICS.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::List_sp gctools__gc_pause_statistics() {
+#if defined(USE_BOEHM)
+  const BoehmPauseStatistics& stats = global_boehm_pause_statistics;
+  core::ql::list plist;
+  plist << kw::_sym_incremental << _lisp->_boolean(GC_is_incremental_mode()) << kw::_sym_write_protection
+        << _lisp->_boolean(GC_incremental_protection_needs() & GC_PROTECTS_POINTER_HEAP)
+        << kw::_sym_collections << core::Integer_O::create((uint64_t)GC_get_gc_no()) << kw::_sym_pauses
+        << core::Integer_O::create((uint64_t)stats._Pauses.load()) << kw::_sym_total_pause
+        << core::DoubleFloat_O::create((double)stats._TotalPauseNs.load() / 1.0e9) << kw::_sym_max_pause
+        << core::DoubleFloat_O::create((double)stats._MaxPauseNs.load() / 1.0e9);
+  return plist.cons();
+#else
+  MISSING_GC_SUPPORT();
+#endif
+}
+
+CL_DOCSTRING(R"dx(Forget the pauses counted by GC-PAUSE-STATISTICS.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void gctools__reset_gc_pause_statistics() {
+#if defined(USE_BOEHM)
+  global_boehm_pause_statistics._Pauses.store(0);
+  global_boehm_pause_statistics._TotalPauseNs.store(0);
+  global_boehm_pause_statistics._MaxPauseNs.store(0);
+#else
+  MISSING_GC_SUPPORT();
+#endif
+}
+
 DOCGROUP(clasp);
 CL_DEFUN void gctools__register_stamp_name(const std::string& name, size_t stamp_num) { register_stamp_name(name, stamp_num); }
 
@@ -145,7 +145,7 @@ inline bool interrupts_disabled_by_lisp() { return core::_sym_STARinterrupts_ena
 // functions, representing interrupts.
 
 static void queue_signal_or_interrupt(core::ThreadLocalState* thread, core::T_sp thing, bool allocate) {
-  mp::SafeSpinLock spinlock(thread->_SparePendingInterruptRecordsSpinLock);
+  mp::AdaptiveLockGuard guard(thread->_SparePendingInterruptRecordsLock);
   core::T_sp record;
   if (allocate) {
     record = core::Cons_O::create(nil<core::T_O>(), nil<core::T_O>());
@@ -165,12 +165,12 @@ static void queue_signal_or_interrupt(core::ThreadLocalState* thread, core::T_sp
 static void queue_signal(int signo) { queue_signal_or_interrupt(my_thread, core::clasp_make_fixnum(signo), false); }
 
 // Pop a thing from the queue.
-// NOTE: Don't call this unless you're holding the spare records spinlock.
+// NOTE: Don't call this unless you're holding the spare records lock.
 core::T_sp pop_signal_or_interrupt(core::ThreadLocalState* thread) {
   core::T_sp value;
   core::Cons_sp record;
-  { // <---- brace for spinlock scope
-    mp::SafeSpinLock spinlock(thread->_SparePendingInterruptRecordsSpinLock);
+  { // <---- brace for lock scope
+    mp::AdaptiveLockGuard guard(thread->_SparePendingInterruptRecordsLock);
     record = gc::As<core::Cons_sp>(thread->_PendingInterrupts);
     value = record->car();
     thread->_PendingInterrupts = record->cdr();
@@ -406,6 +406,10 @@ void handle_fpe(int signo, siginfo_t* info, void* context) {
 
 void handle_segv(int signo, siginfo_t* info, void* context) {
   (void)context; // unused
+  // Something pushed more than SlackWords past its frame into the
+  // uncommitted part of the VM stack.
+  if (my_thread && my_thread->_VM.guard_address_p(info->si_addr))
+    my_thread->_VM.overflow();
   core::eval::funcall(ext::_sym_segmentation_violation, core::Integer_O::create((uintptr_t)(info->si_addr)));
 }
 
@@ -19,6 +19,8 @@
 #include <clasp/external/bloom/bloom_filter.h>
 
 #include <clasp/external/thread-pool/thread_pool.h>
+#include <llvm/Support/Compression.h>
+#include <llvm/Support/Error.h>
 #include <clasp/core/foundation.h>
 #include <clasp/core/lispStream.h>
 #include <clasp/core/debugger.h>
@@ -48,7 +50,7 @@ size_t memory_test(bool dosleep, FILE* fout, const char* message = NULL);
 FixupOperation_ operation(Fixup* fixup) { return fixup->_operation; };
 
 bool global_debugSnapshot = false;
-bool global_debugSnapshotObjectFile = false;
+thread_local bool global_debugSnapshotObjectFile = false;
 
 }; // namespace snapshotSaveLoad
 
@@ -1192,6 +1194,23 @@ typedef enum {
   End = 0xbedabb1e06060606
 } ISLKind; // END
 
+typedef enum { CompressNone = 0, CompressZlib = 1, CompressZstd = 2 } ISLCompression;
+
+//
+// A compressed snapshot keeps the header page uncompressed, followed by a table of
+// ISLCompressedSection_s and then the compressed sections.  Each section is compressed
+// on its own so they can be decompressed in parallel.  The offsets in the header
+// describe the image after decompression.
+//
+struct ISLCompressedSection_s {
+  uintptr_t _UncompressedOffset;
+  uintptr_t _UncompressedSize;
+  uintptr_t _CompressedOffset;
+  uintptr_t _CompressedSize;
+};
+
+#define COMPRESSED_SECTION_SIZE (16 * 1024 * 1024)
+
 #define MAGIC_NUMBER 348235823
 struct ISLFileHeader {
   size_t _Magic;
@@ -1217,8 +1236,14 @@ struct ISLFileHeader {
   size_t _global_JITDylibCounter;
   size_t _global_JITCompileCounter;
 
+  uintptr_t _Compression;
+  uintptr_t _UncompressedSize;
+  uintptr_t _CompressedSectionsOffset;
+  uintptr_t _NumberOfCompressedSections;
+
   ISLFileHeader(size_t sz, size_t num, uintptr_t sbs)
-      : _Magic(MAGIC_NUMBER), _MemorySize(sz), _NumberOfObjects(num), _MemoryStart(sbs) {
+      : _Magic(MAGIC_NUMBER), _MemorySize(sz), _NumberOfObjects(num), _MemoryStart(sbs), _Compression(CompressNone),
+        _UncompressedSize(0), _CompressedSectionsOffset(0), _NumberOfCompressedSections(0) {
     this->_global_JITDylibCounter = llvmo::global_JITDylibCounter.load();
     this->_global_JITCompileCounter = core::core__get_jit_compile_counter();
   };
@@ -1241,6 +1266,8 @@ struct ISLFileHeader {
     printf(" %32s -> %lu(0x%lx)\n", "uintptr_t _ObjectFileSize", _ObjectFileSize, _ObjectFileSize);
     printf(" %32s -> %lu(0x%lx)\n", "NextUnshiftedClbindStamp", _NextUnshiftedClbindStamp, _NextUnshiftedClbindStamp);
     printf(" %32s -> %lu(0x%lx)\n", "NextUnshiftedStamp", _NextUnshiftedStamp, _NextUnshiftedStamp);
+    printf(" %32s -> %lu\n", "uintptr_t _Compression", _Compression);
+    printf(" %32s -> %lu\n", "uintptr_t _NumberOfCompressedSections", _NumberOfCompressedSections);
   }
 };
 
@@ -1778,11 +1805,12 @@ struct copy_objects_t : public walker_callback_t {
 
 //
 // walk snapshot save/load objects that start at cur
+//   and stop at the End header or at limit
 //
-template <typename Walker> void walk_snapshot_save_load_objects(ISLHeader_s* start, Walker& walker) {
+template <typename Walker> void walk_snapshot_save_load_objects(ISLHeader_s* start, Walker& walker, ISLHeader_s* limit = NULL) {
   DBG_SL_WALK_SL(BF("Starting walk cur = %p\n") % (void*)cur);
   ISLHeader_s* cur = start;
-  while (cur->_Kind != End) {
+  while (cur->_Kind != End && cur != limit) {
     DBG_SL_WALK_SL(BF("walk: %p 0x%lx\n") % (void*)cur % cur->_Kind);
     if (walker._debug)
       printf("%s:%d:%s Walking %p 0x%lx\n", __FILE__, __LINE__, __FUNCTION__, (void*)cur, cur->_Kind);
@@ -1810,6 +1838,103 @@ template <typename Walker> void walk_snapshot_save_load_objects(ISLHeader_s* sta
   }
 }
 
+//
+// Split the snapshot objects into chunks of about objectsPerChunk objects.
+// Hopping from header to header is cheap compared to scanning the objects,
+// so this lets walks whose callbacks only touch the object they are given
+// run over the chunks in parallel.
+// The result holds the first header of every chunk followed by the End header.
+//
+std::vector<ISLHeader_s*> snapshot_save_load_object_chunks(ISLHeader_s* start, size_t objectsPerChunk) {
+  std::vector<ISLHeader_s*> chunks;
+  size_t count = 0;
+  ISLHeader_s* cur = start;
+  while (cur->_Kind != End) {
+    if (count % objectsPerChunk == 0)
+      chunks.push_back(cur);
+    count++;
+    cur = cur->next(cur->_Kind);
+  }
+  chunks.push_back(cur);
+  return chunks;
+}
+
+using snapshot_thread_pool_t = thread_pool<ThreadManager>;
+
+template <typename Walker>
+void parallel_walk_snapshot_save_load_objects(snapshot_thread_pool_t& pool, const std::vector<ISLHeader_s*>& chunks,
+                                              Walker& walker) {
+  pool.parallelize_loop((size_t)0, chunks.size() - 1, [&chunks, &walker](size_t start, size_t end) {
+    for (size_t idx = start; idx < end; idx++)
+      walk_snapshot_save_load_objects(chunks[idx], walker, chunks[idx + 1]);
+  });
+}
+
+ISLCompression snapshot_compression_format() {
+#if LLVM_VERSION_MAJOR >= 16
+  if (llvm::compression::zstd::isAvailable())
+    return CompressZstd;
+#endif
+  if (llvm::compression::zlib::isAvailable())
+    return CompressZlib;
+  return CompressNone;
+}
+
+//
+// Decompress the sections of a compressed snapshot into a fresh anonymous mapping.
+// Return the mapping and its size in imageSize.
+//
+void* decompress_snapshot(snapshot_thread_pool_t& pool, void* compressed, size_t& imageSize) {
+  ISLFileHeader* header = (ISLFileHeader*)compressed;
+  if (header->_Compression != CompressZstd && header->_Compression != CompressZlib) {
+    printf("%s:%d:%s Unknown snapshot compression format %lu\n", __FILE__, __LINE__, __FUNCTION__, header->_Compression);
+    abort();
+  }
+#if LLVM_VERSION_MAJOR < 16
+  if (header->_Compression == CompressZstd) {
+    printf("%s:%d:%s The snapshot is compressed with zstd, which needs LLVM 16 or later\n", __FILE__, __LINE__, __FUNCTION__);
+    abort();
+  }
+#endif
+  imageSize = header->_UncompressedSize;
+  void* image = mmap(NULL, imageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (image == MAP_FAILED) {
+    printf("%s:%d:%s Could not mmap %lu bytes to decompress the snapshot because of %s\n", __FILE__, __LINE__, __FUNCTION__,
+           imageSize, strerror(errno));
+    abort();
+  }
+  memcpy(image, compressed, header->_LibrariesOffset);
+  ((ISLFileHeader*)image)->_Compression = CompressNone;
+  ISLCompressedSection_s* sections = (ISLCompressedSection_s*)((char*)compressed + header->_CompressedSectionsOffset);
+  uintptr_t format = header->_Compression;
+  std::atomic<size_t> failures(0);
+  pool.parallelize_loop((size_t)0, (size_t)header->_NumberOfCompressedSections, [&](size_t start, size_t end) {
+    for (size_t idx = start; idx < end; idx++) {
+      ISLCompressedSection_s& section = sections[idx];
+      llvm::ArrayRef<uint8_t> input((const uint8_t*)compressed + section._CompressedOffset, section._CompressedSize);
+      uint8_t* output = (uint8_t*)image + section._UncompressedOffset;
+      size_t outputSize = section._UncompressedSize;
+#if LLVM_VERSION_MAJOR >= 16
+      llvm::Error err = (format == CompressZstd) ? llvm::compression::zstd::decompress(input, output, outputSize)
+                                                 : llvm::compression::zlib::decompress(input, output, outputSize);
+#else
+      llvm::Error err = llvm::compression::zlib::decompress(input, output, outputSize);
+#endif
+      if (err) {
+        llvm::consumeError(std::move(err));
+        failures++;
+      } else if (outputSize != section._UncompressedSize) {
+        failures++;
+      }
+    }
+  });
+  if (failures.load() != 0) {
+    printf("%s:%d:%s Could not decompress %lu sections of the snapshot\n", __FILE__, __LINE__, __FUNCTION__, failures.load());
+    abort();
+  }
+  return image;
+}
+
 struct fixup_objects_t : public walker_callback_t {
   FixupOperation_ _operation;
   gctools::clasp_ptr_t _buffer;
@@ -2331,6 +2456,99 @@ CL_DEFUN size_t gctools__memory_test(core::T_sp filename) {
   return result;
 }
 
+//
+// snapshot_save_impl runs with the allocation lock held, and registering a
+// thread with the GC needs that lock, so the threads that compress the
+// snapshot must stay unknown to the GC.  They only touch malloc'd buffers.
+//
+struct UnregisteredThreadManager {
+  struct Worker {};
+  void register_thread(std::thread& th){};
+  void unregister_thread(std::thread& th){};
+};
+
+//
+// Write all of data to filedes, retrying partial writes.  Report a failure and
+// return false if that can't be done.
+//
+bool write_all_to_filedes(int filedes, const void* data, size_t size) {
+  const char* cur = (const char*)data;
+  while (size > 0) {
+    ssize_t wrote = write(filedes, cur, size);
+    if (wrote < 0 && errno == EINTR)
+      continue;
+    if (wrote <= 0) {
+      printf("%s:%d:%s Could not write %lu bytes of the snapshot: %s\n", __FILE__, __LINE__, __FUNCTION__, size,
+             wrote < 0 ? strerror(errno) : "nothing was written");
+      return false;
+    }
+    cur += wrote;
+    size -= wrote;
+  }
+  return true;
+}
+
+//
+// Write the snapshot with the libraries, objects and object files split into
+// independently compressed sections.  The header offsets still describe the
+// uncompressed image that snapshot_load will rebuild.
+// Return the number of bytes written, or zero if the snapshot could not be written.
+//
+size_t write_compressed_snapshot(int filedes, Snapshot& snapshot, ISLCompression format) {
+  ISLFileHeader* fileHeader = snapshot._FileHeader;
+  std::vector<ISLCompressedSection_s> sections;
+  std::vector<char*> sources;
+  auto addSections = [&sections, &sources](copy_buffer_t* buffer, uintptr_t offset) {
+    for (size_t start = 0; start < buffer->_Size; start += COMPRESSED_SECTION_SIZE) {
+      ISLCompressedSection_s section;
+      section._UncompressedOffset = offset + start;
+      section._UncompressedSize = std::min((size_t)COMPRESSED_SECTION_SIZE, buffer->_Size - start);
+      sections.push_back(section);
+      sources.push_back(buffer->_BufferStart + start);
+    }
+  };
+  addSections(snapshot._Libraries, fileHeader->_LibrariesOffset);
+  addSections(snapshot._Memory, fileHeader->_MemoryStart);
+  addSections(snapshot._ObjectFiles, fileHeader->_ObjectFileStart);
+  std::vector<llvm::SmallVector<uint8_t, 0>> compressed(sections.size());
+  {
+    thread_pool<UnregisteredThreadManager> pool(snapshot_thread_pool_t::sane_number_of_threads());
+    pool.parallelize_loop((size_t)0, sections.size(), [&](size_t start, size_t end) {
+      for (size_t idx = start; idx < end; idx++) {
+        llvm::ArrayRef<uint8_t> input((const uint8_t*)sources[idx], sections[idx]._UncompressedSize);
+#if LLVM_VERSION_MAJOR >= 16
+        if (format == CompressZstd)
+          llvm::compression::zstd::compress(input, compressed[idx]);
+        else
+#endif
+          llvm::compression::zlib::compress(input, compressed[idx]);
+      }
+    });
+  }
+  uintptr_t offset = snapshot._HeaderBuffer->_Size + sizeof(ISLCompressedSection_s) * sections.size();
+  for (size_t idx = 0; idx < sections.size(); idx++) {
+    sections[idx]._CompressedOffset = offset;
+    sections[idx]._CompressedSize = compressed[idx].size();
+    offset += gctools::AlignUp(compressed[idx].size());
+  }
+  fileHeader->_UncompressedSize = fileHeader->_ObjectFileStart + fileHeader->_ObjectFileSize;
+  fileHeader->_Compression = format;
+  fileHeader->_CompressedSectionsOffset = snapshot._HeaderBuffer->_Size;
+  fileHeader->_NumberOfCompressedSections = sections.size();
+  if (!write_all_to_filedes(filedes, snapshot._HeaderBuffer->_BufferStart, snapshot._HeaderBuffer->_Size) ||
+      !write_all_to_filedes(filedes, sections.data(), sizeof(ISLCompressedSection_s) * sections.size()))
+    return 0;
+  uint8_t padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  for (size_t idx = 0; idx < compressed.size(); idx++) {
+    if (!write_all_to_filedes(filedes, compressed[idx].data(), compressed[idx].size()) ||
+        !write_all_to_filedes(filedes, padding, gctools::AlignUp(compressed[idx].size()) - compressed[idx].size()))
+      return 0;
+  }
+  core::lisp_write(fmt::format("Compressed snapshot from {} to {} bytes in {} sections\n", fileHeader->_UncompressedSize, offset,
+                               sections.size()));
+  return offset;
+}
+
 /* This is not allowed to do any allocations. */
 void* snapshot_save_impl(void* data) {
   global_badge_count = 0;
@@ -2648,10 +2866,18 @@ void* snapshot_save_impl(void* data) {
       filename = tfbuffer;
     }
     core::lisp_write(fmt::format("Writing snapshot to temporary file {} filedes = {}\n", filename.c_str(), filedes));
-    snapshot._HeaderBuffer->write_to_filedes(filedes);
-    snapshot._Libraries->write_to_filedes(filedes);
-    snapshot._Memory->write_to_filedes(filedes);
-    snapshot._ObjectFiles->write_to_filedes(filedes);
+    ISLCompression format = snapshot_data->_Compress ? snapshot_compression_format() : CompressNone;
+    if (snapshot_data->_Compress && format == CompressNone)
+      core::lisp_write(fmt::format("LLVM was built without zstd or zlib - writing an uncompressed snapshot\n"));
+    if (format != CompressNone) {
+      if (write_compressed_snapshot(filedes, snapshot, format) == 0)
+        printf("%s:%d:%s The snapshot in %s is incomplete\n", __FILE__, __LINE__, __FUNCTION__, filename.c_str());
+    } else {
+      snapshot._HeaderBuffer->write_to_filedes(filedes);
+      snapshot._Libraries->write_to_filedes(filedes);
+      snapshot._Memory->write_to_filedes(filedes);
+      snapshot._ObjectFiles->write_to_filedes(filedes);
+    }
     int closeres = close(filedes);
     if (closeres < 0) {
       printf("%s:%d:%s Error closing file %s\n", __FILE__, __LINE__, __FUNCTION__, filename.c_str());
@@ -2853,9 +3079,11 @@ struct temporary_root_holder_t {
   }
 };
 
-template <typename Walker> void walk_temporary_root_objects(const temporary_root_holder_t& roots, Walker& walker) {
+template <typename Walker>
+void walk_temporary_root_objects(const temporary_root_holder_t& roots, Walker& walker, size_t start = 0, size_t end = ~(size_t)0) {
   DBG_SL_WALK_TEMP(BF("Starting walk of %lu roots at %p\n") % roots._Number % (void*)roots._buffer);
-  for (size_t idx = 0; idx < roots._Number; idx++) {
+  end = std::min(end, roots._Number);
+  for (size_t idx = start; idx < end; idx++) {
     core::T_O* tagged_client = (core::T_O*)roots._buffer[idx];
     // This will handle general and weak objects
     if (gctools::tagged_generalp(tagged_client)) {
@@ -2953,27 +3181,71 @@ void snapshot_load(void* maybeStartOfSnapshot, void* maybeEndOfSnapshot, const s
     }
     off_t fsize = 0;
     void* memory = NULL;
+    bool embeddedInPlace = false;
+    bool decompressedImage = false;
+    //
+    // The decompression, relocation and pointer fixup steps below are run
+    // in chunks across a thread pool.
+    //
+    snapshot_thread_pool_t pool(snapshot_thread_pool_t::sane_number_of_threads());
     //
     // mmap the snapshot into memory
     //    OR copy it from the executable memory
     //
-    if (filename.size() != 0) {
-      int fd = open(filename.c_str(), O_RDONLY);
-      fsize = lseek(fd, 0, SEEK_END);
-      lseek(fd, 0, SEEK_SET);
-      memory = mmap(NULL, fsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FILE, fd, 0);
-      if (memory == MAP_FAILED) {
-        close(fd);
-        printf("%s:%d:%s Could not mmap %s because of %s\n", __FILE__, __LINE__, __FUNCTION__, filename.c_str(), strerror(errno));
-        SIMPLE_ERROR("Could not mmap {} because of {}", filename, strerror(errno));
+    {
+      MaybeTimeStartup timeRead("Read snapshot");
+      if (filename.size() != 0) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        fsize = lseek(fd, 0, SEEK_END);
+        lseek(fd, 0, SEEK_SET);
+        memory = mmap(NULL, fsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FILE, fd, 0);
+        if (memory == MAP_FAILED) {
+          close(fd);
+          printf("%s:%d:%s Could not mmap %s because of %s\n", __FILE__, __LINE__, __FUNCTION__, filename.c_str(), strerror(errno));
+          SIMPLE_ERROR("Could not mmap {} because of {}", filename, strerror(errno));
+        }
+      } else if (maybeStartOfSnapshot && maybeEndOfSnapshot && (maybeStartOfSnapshot < maybeEndOfSnapshot)) {
+        size_t size = (uintptr_t)maybeEndOfSnapshot - (uintptr_t)maybeStartOfSnapshot;
+        //
+        // The embedded snapshot lives in a private file mapping of the executable.
+        // If it is word aligned and we can make it writable, relocate it where it is
+        // and let copy-on-write bring in just the pages we touch instead of copying
+        // the whole thing up front.
+        //
+        uintptr_t pageSize = getpagesize();
+        uintptr_t pageStart = (uintptr_t)maybeStartOfSnapshot & ~(pageSize - 1);
+        uintptr_t pageEnd = ((uintptr_t)maybeEndOfSnapshot + pageSize - 1) & ~(pageSize - 1);
+        if (((uintptr_t)maybeStartOfSnapshot & 0x7) == 0 &&
+            mprotect((void*)pageStart, pageEnd - pageStart, PROT_READ | PROT_WRITE) == 0) {
+          memory = maybeStartOfSnapshot;
+          embeddedInPlace = true;
+        } else {
+          memory = malloc(size);
+          memcpy(memory, maybeStartOfSnapshot, size);
+        }
+        fsize = size;
+      } else {
+        printf("There is no snapshot file or embedded\n");
+        abort();
       }
-    } else if (maybeStartOfSnapshot && maybeEndOfSnapshot && (maybeStartOfSnapshot < maybeEndOfSnapshot)) {
-      size_t size = (uintptr_t)maybeEndOfSnapshot - (uintptr_t)maybeStartOfSnapshot;
-      memory = malloc(size);
-      memcpy(memory, maybeStartOfSnapshot, size);
-    } else {
-      printf("There is no snapshot file or embedded\n");
-      abort();
+    }
+    //
+    // A compressed snapshot is expanded into an anonymous mapping
+    //   and the compressed image is released.
+    //
+    if (reinterpret_cast<ISLFileHeader*>(memory)->good_magic() &&
+        reinterpret_cast<ISLFileHeader*>(memory)->_Compression != CompressNone) {
+      MaybeTimeStartup timeDecompress("Decompress snapshot");
+      size_t imageSize;
+      void* image = decompress_snapshot(pool, memory, imageSize);
+      if (maybeStartOfSnapshot == NULL)
+        munmap(memory, fsize);
+      else if (!embeddedInPlace)
+        free(memory);
+      memory = image;
+      fsize = imageSize;
+      embeddedInPlace = false;
+      decompressedImage = true;
     }
     ISLFileHeader* fileHeader = reinterpret_cast<ISLFileHeader*>(memory);
     gctools::global_NextUnshiftedStamp.store(fileHeader->_NextUnshiftedStamp);
@@ -3094,6 +3366,9 @@ void snapshot_load(void* maybeStartOfSnapshot, void* maybeEndOfSnapshot, const s
     if (start == NULL) {
       printf("%s:%d:%s vtable section range start is NULL\n", __FILE__, __LINE__, __FUNCTION__);
     }
+    std::vector<ISLHeader_s*> chunks = snapshot_save_load_object_chunks(
+        (ISLHeader_s*)islbuffer, std::max((size_t)1024, (size_t)(fileHeader->_NumberOfObjects / (4 * pool.get_thread_count()))));
+
     {
       MaybeTimeStartup time3("Fixup vtables");
       fixup_vtables_t fixup_vtables(&fixup, (uintptr_t)start, (uintptr_t)end, &islInfo);
@@ -3111,7 +3386,7 @@ void snapshot_load(void* maybeStartOfSnapshot, void* maybeEndOfSnapshot, const s
       DBG_SL("4  Starting   globalSavedBase %p    globalLoadedBase  %p\n", (void*)globalSavedBase, (void*)globalLoadedBase);
       globalPointerFix = relocate_pointer;
       relocate_objects_t relocate_objects(&islInfo);
-      walk_snapshot_save_load_objects((ISLHeader_s*)islbuffer, relocate_objects);
+      parallel_walk_snapshot_save_load_objects(pool, chunks, relocate_objects);
     }
     // Do the roots as well
     // After this they will be internally consistent with the loaded objects
@@ -3120,7 +3395,9 @@ void snapshot_load(void* maybeStartOfSnapshot, void* maybeEndOfSnapshot, const s
     relocateLoadedRootPointers(lispRoot, 1, (void*)&islInfo);
     gctools::clasp_ptr_t* symbolRoots =
         (gctools::clasp_ptr_t*)((char*)islbuffer + fileHeader->_SymbolRootsOffset + sizeof(ISLRootHeader_s));
-    relocateLoadedRootPointers(symbolRoots, fileHeader->_SymbolRootsCount, (void*)&islInfo);
+    pool.parallelize_loop((size_t)0, (size_t)fileHeader->_SymbolRootsCount, [symbolRoots, &islInfo](size_t start, size_t end) {
+      relocateLoadedRootPointers(symbolRoots + start, end - start, (void*)&islInfo);
+    });
 
     //
     // Fixup the CodeBase_O objects
@@ -3268,7 +3545,6 @@ void snapshot_load(void* maybeStartOfSnapshot, void* maybeEndOfSnapshot, const s
       llvmo::ClaspJIT_O* claspJIT = (llvmo::ClaspJIT_O*)gctools::untag_general<core::T_O*>(obj_claspJIT.raw_());
       new (claspJIT) llvmo::ClaspJIT_O(true, mainJITDylib);
       gc::As<llvmo::ClaspJIT_sp>(obj_claspJIT)->registerJITDylibAfterLoad(&*obj_mainJITDylib);
-      // llvm_sys__create_lljit_thread_pool();
       if (mainJITDylib->_Id != 0) {
         printf("%s:%d:%s The mainJITDylib _Id MUST be zero !!!  Instead it is: %lu\n", __FILE__, __LINE__, __FUNCTION__,
                mainJITDylib->_Id);
@@ -3344,8 +3620,6 @@ void snapshot_load(void* maybeStartOfSnapshot, void* maybeEndOfSnapshot, const s
       {
         // Link all the code objects
         MaybeTimeStartup time5("Object file linking");
-        using TP = thread_pool<ThreadManager>;
-        TP pool(TP::sane_number_of_threads());
         //        printf("%s:%d:%s Started thread pool\n", __FILE__, __LINE__, __FUNCTION__ );
         for (cur_header = start_header; cur_header->_Kind != End;) {
           DBG_SL_ALLOCATE(BF("-----Allocating based on cur_header %p\n") % (void*)cur_header);
@@ -3777,7 +4051,10 @@ void snapshot_load(void* maybeStartOfSnapshot, void* maybeEndOfSnapshot, const s
       fixup_objects_t fixup_objects(LoadOp, (gctools::clasp_ptr_t)islbuffer, &islInfo);
       globalPointerFix = maybe_follow_forwarding_pointer;
       globalPointerFixStage = "snapshot_load/fixupObjects";
-      walk_temporary_root_objects(root_holder, fixup_objects);
+      MaybeTimeStartup time7("Fixup pointers");
+      pool.parallelize_loop((size_t)0, root_holder._Number, [&root_holder, &fixup_objects](size_t start, size_t end) {
+        walk_temporary_root_objects(root_holder, fixup_objects, start, end);
+      });
     }
 
 #ifdef DEBUG_GUARD
@@ -3798,7 +4075,9 @@ void snapshot_load(void* maybeStartOfSnapshot, void* maybeEndOfSnapshot, const s
       //    copyRoots((uintptr_t*)&_lisp, (uintptr_t*)lispRoot, fileHeader->_LispRootCount );
       gctools::clasp_ptr_t* symbolRoots =
           (gctools::clasp_ptr_t*)((char*)islbuffer + fileHeader->_SymbolRootsOffset + sizeof(ISLRootHeader_s));
-      followForwardingPointersForRoots(symbolRoots, fileHeader->_SymbolRootsCount, (void*)&islInfo);
+      pool.parallelize_loop((size_t)0, (size_t)fileHeader->_SymbolRootsCount, [symbolRoots, &islInfo](size_t start, size_t end) {
+        followForwardingPointersForRoots(symbolRoots + start, end - start, (void*)&islInfo);
+      });
       copyRoots((uintptr_t*)&global_symbols[0], (uintptr_t*)symbolRoots, fileHeader->_SymbolRootsCount);
     }
 
@@ -3827,10 +4106,17 @@ void snapshot_load(void* maybeStartOfSnapshot, void* maybeEndOfSnapshot, const s
 //  memset(memory,0xc0,fsize);
 #else
     //  printf("%s:%d:%s munmap'ing loaded snapshot - filling with 0xc0\n", __FILE__, __LINE__, __FUNCTION__ );
-    if (maybeStartOfSnapshot == NULL) {
+    if (maybeStartOfSnapshot == NULL || decompressedImage) {
       int res = munmap(memory, fsize);
       if (res != 0)
         SIMPLE_ERROR("Could not munmap memory");
+    } else if (embeddedInPlace) {
+      // Drop the pages we dirtied - they revert to the executable's contents.
+      uintptr_t pageSize = getpagesize();
+      uintptr_t pageStart = ((uintptr_t)memory + pageSize - 1) & ~(pageSize - 1);
+      uintptr_t pageEnd = ((uintptr_t)memory + fsize) & ~(pageSize - 1);
+      if (pageStart < pageEnd)
+        madvise((void*)pageStart, pageEnd - pageStart, MADV_DONTNEED);
     } else {
       // It's a copy of the embedded snapshot
       free(memory);
@@ -120,7 +120,7 @@ ThreadLocalStateLowLevel::~ThreadLocalStateLowLevel(){};
 namespace core {
 
 VirtualMachine::VirtualMachine()
-    : _Running(true)
+    : _Running(true), _stackBottom(NULL), _stackBytes(0), _stackReservedBytes(0), _stackTop(NULL)
 #ifdef DEBUG_VIRTUAL_MACHINE
       ,
       _counter0(0), _unwind_counter(0), _throw_counter(0)
@@ -128,50 +128,142 @@ VirtualMachine::VirtualMachine()
 {
 }
 
-void VirtualMachine::startup() {
-  size_t stackSpace = VirtualMachine::MaxStackWords * sizeof(T_O*);
-  this->_stackBottom = (T_O**)gctools::RootClassAllocator<T_O>::allocateRootsAndZero(VirtualMachine::MaxStackWords);
-  this->_stackTop = this->_stackBottom + VirtualMachine::MaxStackWords - 1;
-  //  printf("%s:%d:%s vm._stackTop = %p\n", __FILE__, __LINE__, __FUNCTION__, this->_stackTop );
+void VirtualMachine::startup(size_t reserveBytes) {
   size_t pageSize = getpagesize();
-  uintptr_t stackGuardPage = ((uintptr_t)this->_stackTop - pageSize) / pageSize;
-  uintptr_t stackGuard = stackGuardPage * pageSize;
-  this->_stackGuard = (core::T_O**)stackGuard;
-  //  printf("%s:%d:%s stackGuard = %p\n", __FILE__, __LINE__, __FUNCTION__, (void*)stackGuard );
-  this->_stackBytes = stackSpace;
-  // Clear the stack memory
-  memset(this->_stackBottom, 0, stackSpace);
+  size_t minimumBytes = (InitialCommitWords + SlackWords + EmergencyWords) * sizeof(T_O*) + pageSize;
+  if (reserveBytes == 0)
+    reserveBytes = DefaultStackBytes;
+  reserveBytes = std::max(reserveBytes, minimumBytes);
+  reserveBytes = (reserveBytes + pageSize - 1) / pageSize * pageSize;
+  // Reserve the whole range but commit none of it - the pages are only
+  // made accessible as the stack grows into them (see commit).
+  void* reserved = mmap(NULL, reserveBytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (reserved == MAP_FAILED) {
+    printf("%s:%d:%s Could not reserve %lu bytes for the VM stack errno = %d\n", __FILE__, __LINE__, __FUNCTION__, reserveBytes,
+           errno);
+    abort();
+  }
+  this->initialize(reserved, reserveBytes);
+}
+
+// Run the stack in REGION, which the caller has mapped readable and
+// writable and will unmap. Committing is then only bookkeeping, which
+// saves the mappings that mprotect would split off; the limit checks in
+// push_frame stand in for the guard region. Fibers use this.
+void VirtualMachine::startup_in(void* region, size_t bytes) {
+  this->_ownsStack = false;
+  this->initialize(region, bytes);
+}
+
+void VirtualMachine::initialize(void* region, size_t bytes) {
+  size_t pageSize = getpagesize();
+  this->_stackBottom = (T_O**)region;
+  this->_stackReservedBytes = bytes;
+  this->_stackBytes = 0;
+  // The last page is never committed so that running off the end faults.
+  core::T_O** hardEnd = (T_O**)((uintptr_t)region + bytes - pageSize);
+  this->_stackLimit = hardEnd - EmergencyWords;
+  this->commit(InitialCommitWords * sizeof(T_O*));
   this->enable_guards();
   this->_stackPointer = this->_stackBottom;
   (*this->_stackPointer) = NULL;
 }
 
-void VirtualMachine::enable_guards() {
-//  printf("%s:%d:%s pid %d\n", __FILE__, __LINE__, __FUNCTION__, getpid()  );
-#if 0
+// Make the first BYTES of the reserved range accessible and tell the GC
+// to scan them. Fresh anonymous pages are zero filled.
+void VirtualMachine::commit(size_t bytes) {
   size_t pageSize = getpagesize();
-  int mprotectResult = mprotect((void*)this->_stackGuard,pageSize,PROT_READ);
-  if (mprotectResult!=0) {
-    printf("%s:%d:%s mprotect failed with %d\n", __FILE__, __LINE__, __FUNCTION__, mprotectResult );
+  bytes = (bytes + pageSize - 1) / pageSize * pageSize;
+  bytes = std::min(bytes, this->_stackReservedBytes - pageSize);
+  if (bytes <= this->_stackBytes)
+    return;
+  if (this->_ownsStack) {
+    int mprotectResult = mprotect((void*)this->_stackBottom, bytes, PROT_READ | PROT_WRITE);
+    if (mprotectResult != 0) {
+      printf("%s:%d:%s mprotect of %lu bytes of the VM stack failed errno = %d\n", __FILE__, __LINE__, __FUNCTION__, bytes, errno);
+      abort();
+    }
   }
+#if defined(USE_BOEHM)
+  // Boehm extends an existing root set that has the same start address,
+  // so the committed part is never unregistered while growing.
+  if (this->_registerRoots)
+    GC_add_roots((void*)this->_stackBottom, (void*)((uintptr_t)this->_stackBottom + bytes));
 #endif
+  this->_stackBytes = bytes;
+  this->_stackTop = (T_O**)((uintptr_t)this->_stackBottom + bytes) - 1;
+  this->_stackGuard = this->_stackTop - SlackWords;
 }
-void VirtualMachine::disable_guards() {
-//  printf("%s:%d:%s pid %d\n", __FILE__, __LINE__, __FUNCTION__, getpid()  );
-#if 0
-  size_t pageSize = getpagesize();
-  int mprotectResult = mprotect((void*)this->_stackGuard,pageSize,PROT_READ|PROT_WRITE);
-  if (mprotectResult!=0) {
-    printf("%s:%d:%s mprotect failed with %d\n", __FILE__, __LINE__, __FUNCTION__, mprotectResult );
+
+// Called by push_frame when a new frame extending to NEEDED would come
+// within SlackWords of the committed end.
+void VirtualMachine::grow(core::T_O** needed) {
+  if (needed + SlackWords >= this->_stackLimit)
+    this->overflow();
+  size_t neededBytes = (uintptr_t)(needed + SlackWords + 1) - (uintptr_t)this->_stackBottom;
+  this->commit(std::max(neededBytes, 2 * this->_stackBytes));
+}
+
+SYMBOL_EXPORT_SC_(ExtPkg, stack_overflow);
+
+// Signal EXT:STACK-OVERFLOW. The handlers get to run in the emergency
+// zone at the end of the reservation, which is closed again once control
+// leaves here, normally or by unwinding.
+void VirtualMachine::overflow() {
+  core::T_O** hardEnd = (T_O**)((uintptr_t)this->_stackBottom + this->_stackReservedBytes - getpagesize());
+  if (this->_stackLimit == hardEnd) {
+    printf("%s:%d:%s The VM stack overflowed while handling a VM stack overflow\n", __FILE__, __LINE__, __FUNCTION__);
+    abort();
   }
+  struct RestoreLimit {
+    VirtualMachine& _vm;
+    core::T_O** _limit;
+    ~RestoreLimit() { this->_vm._stackLimit = this->_limit; }
+  } restore{*this, this->_stackLimit};
+  this->_stackLimit = hardEnd;
+  ERROR(ext::_sym_stack_overflow, core::lisp_createList(kw::_sym_size, Integer_O::create((uint64_t)this->_stackReservedBytes),
+                                                        kw::_sym_type, SimpleBaseString_O::make("Bytecode VM stack")));
+}
+
+void VirtualMachine::swap(VirtualMachine& other) {
+  std::swap(this->_Running, other._Running);
+  std::swap(this->_registerRoots, other._registerRoots);
+  std::swap(this->_ownsStack, other._ownsStack);
+  std::swap(this->_stackBottom, other._stackBottom);
+  std::swap(this->_stackBytes, other._stackBytes);
+  std::swap(this->_stackReservedBytes, other._stackReservedBytes);
+  std::swap(this->_stackTop, other._stackTop);
+  std::swap(this->_stackGuard, other._stackGuard);
+  std::swap(this->_stackLimit, other._stackLimit);
+  std::swap(this->_stackPointer, other._stackPointer);
+  std::swap(this->_framePointer, other._framePointer);
+#ifdef DEBUG_VIRTUAL_MACHINE
+  std::swap(this->_data, other._data);
+  std::swap(this->_data1, other._data1);
+  std::swap(this->_counter0, other._counter0);
+  std::swap(this->_unwind_counter, other._unwind_counter);
+  std::swap(this->_throw_counter, other._throw_counter);
 #endif
+  std::swap(this->_literals, other._literals);
+  std::swap(this->_pc, other._pc);
 }
 
+void VirtualMachine::enable_guards() {
+  // The guard region is the uncommitted tail of the reservation, which is
+  // PROT_NONE from the start and survives fork - nothing to do here.
+}
+void VirtualMachine::disable_guards() {}
+
 VirtualMachine::~VirtualMachine() {
-#if 1
+  if (!this->_stackBottom)
+    return;
   this->disable_guards();
+#if defined(USE_BOEHM)
+  if (this->_registerRoots)
+    GC_remove_roots((void*)this->_stackBottom, (void*)((uintptr_t)this->_stackBottom + this->_stackBytes));
 #endif
-  gctools::RootClassAllocator<T_O>::freeRoots(this->_stackBottom);
+  if (this->_ownsStack)
+    munmap((void*)this->_stackBottom, this->_stackReservedBytes);
 }
 
 // For main thread initialization - it happens too early and _Nil is undefined
@@ -376,7 +468,7 @@ void ThreadLocalState::popObjectFile() {
   SIMPLE_ERROR("There were no more object files");
 }
 
-void ThreadLocalState::startUpVM() { this->_VM.startup(); }
+void ThreadLocalState::startUpVM(size_t vmStackBytes) { this->_VM.startup(vmStackBytes); }
 
 ThreadLocalState::~ThreadLocalState() {}
 
@@ -149,6 +149,8 @@
              :clasp-cleavir
              #~"kernel/cmp/arguments.lisp"
              #~"kernel/lsp/queue.lisp" ;; cclasp sources
+             #~"kernel/lsp/executor.lisp"
+             #~"kernel/lsp/fiber.lisp"
              #~"kernel/lsp/generated-encodings.lisp"
              #~"kernel/lsp/process.lisp"
              #~"kernel/lsp/encodings.lisp"
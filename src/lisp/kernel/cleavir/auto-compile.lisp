@@ -26,19 +26,17 @@
 (defvar *autocompilation-log* nil)
 
 ;;; Enqueue a command to the autocompilation thread.
-;;; The queue implementation is not lock-free, so there is a
-;;; small possibility that queue-autocompilation could be called
-;;; while the lock is held, which could cause a deadlock. This
-;;; is avoided by temporarily disabling autocompilation while
-;;; the lock is held.
-;;; Making the queue lock-free might be a more elegant solution.
+;;; The queue is lock-free and implemented natively, so this can't
+;;; run any bytecode that would call back into queue-autocompilation.
 (defun autocompilation-enqueue (command)
-  (let ((cmp:*autocompile-hook* nil))
-    (core:atomic-enqueue *autocompilation-queue* command)))
+  (core:atomic-enqueue *autocompilation-queue* command))
 
 (defun autocompilation-dequeue ()
-  (let ((cmp:*autocompile-hook* nil))
-    (core:dequeue *autocompilation-queue*)))
+  (core:dequeue *autocompilation-queue*))
+
+;;; Like the above, but return NIL instead of waiting if the queue is empty.
+(defun autocompilation-dequeue-no-hang ()
+  (core:dequeue *autocompilation-queue* :timeout 0 :timeout-val nil))
 
 (defun autocompilation-log ()
   ;; During build we're not set up to use cleavir processing to determine
@@ -49,6 +47,9 @@
   (setf (mp:atomic (symbol-value '*autocompilation-log*) :order :relaxed) nil))
 
 ;;; Value of *autocompile-hook*.
+;;; The VM calls this once a bytecode function's hotness (calls plus loop
+;;; iterations) reaches CORE:BYTECODE-AUTOCOMPILE-THRESHOLD, and the
+;;; bytecode compiler calls it for functions declared (OPTIMIZE SPEED 3).
 ;;; We don't queue anything until start-autocompilation is run.
 ;;; Afterwards we queue even if the worker is not going - more work for later.
 (defun queue-autocompilation (definition environment)
@@ -67,6 +68,22 @@
          (fboundp name)
          (eq definition (fdefinition name)))))
 
+;;; Jobs are not compiled in the order they were queued. The worker keeps
+;;; every job that has come in, and each time it's free it compiles the
+;;; hottest one, as functions keep counting calls while they wait. Ties go
+;;; to the job that was queued first.
+(defun autocompilation-hotness (item)
+  (if (consp item)
+      (core:bytecode-simple-fun/call-count (car item))
+      -1))
+
+(defun autocompilation-next-job (pending)
+  (let ((best (first pending)))
+    (dolist (item (rest pending) best)
+      ;; PENDING is newest first, so >= prefers the older job on a tie.
+      (when (>= (autocompilation-hotness item) (autocompilation-hotness best))
+        (setf best item)))))
+
 (defun autocompile-worker ()
   (macrolet ((log (thing)
                `(when (mp:atomic (symbol-value '*autocompilation-logging*)
@@ -74,23 +91,31 @@
                   (mp:atomic-push-explicit ,thing
                                            ((symbol-value '*autocompilation-log*)
                                             :order :relaxed)))))
-    (loop for item = (autocompilation-dequeue)
-          when (eq item :quit)
-            do (log item)
+    (loop with pending = nil
+          ;; Wait for work if we have none, then take everything queued.
+          do (when (null pending)
+               (push (autocompilation-dequeue) pending))
+             (loop for new = (autocompilation-dequeue-no-hang)
+                   while new
+                   do (push new pending))
+          when (member :quit pending)
+            do (log :quit)
             and return nil
-          when (consp item)
-            do (let ((def (car item)) (env (cdr item)))
-                 (declare (ignore env))
-                 ;; Make sure it hasn't been compiled already.
-                 (if (eq (core:entry-point def) def)
-                     (handler-case (clasp-bytecode-to-bir:compile-function def)
-                       (serious-condition (e)
-                         (log `(:error ,def ,e)))
-                       (:no-error (f)
-                         (log `(:success ,def ,f))
-                         (core:set-simple-fun def f)))
-                     (log `(:redundant ,def))))
-          else do (log `(:bad-queue ,item)))))
+          do (let ((item (autocompilation-next-job pending)))
+               (setf pending (delete item pending :count 1 :test #'eq))
+               (if (consp item)
+                   (let ((def (car item)) (env (cdr item)))
+                     (declare (ignore env))
+                     ;; Make sure it hasn't been compiled already.
+                     (if (eq (core:entry-point def) def)
+                         (handler-case (clasp-bytecode-to-bir:compile-function def)
+                           (serious-condition (e)
+                             (log `(:error ,def ,e)))
+                           (:no-error (f)
+                             (log `(:success ,def ,f))
+                             (core:set-simple-fun def f)))
+                         (log `(:redundant ,def))))
+                   (log `(:bad-queue ,item)))))))
 
 
 (defun start-autocompilation* ()
@@ -946,6 +946,22 @@
                                 inserter context &rest args)
   (declare (ignore inserter context args)))
 
+;;; Superinstructions just do the work of their components.
+(defmethod compile-instruction ((mnemonic (eql :check-and-bind-required-args))
+                                inserter context &rest args)
+  (apply #'compile-instruction :bind-required-args inserter context args))
+
+(defmethod compile-instruction ((mnemonic (eql :call-return))
+                                inserter context &rest args)
+  (apply #'compile-instruction :call inserter context args)
+  (compile-instruction :return inserter context))
+
+(defmethod compile-instruction ((mnemonic (eql :pop-return))
+                                inserter context &rest args)
+  (destructuring-bind () args
+    (compile-instruction :pop inserter context)
+    (compile-instruction :return inserter context)))
+
 (defmethod compile-instruction ((mnemonic (eql :push-values))
                                 inserter context &rest args)
   (destructuring-bind () args
@@ -124,7 +124,53 @@
 
 (defparameter *dump-compile-module* nil)
 
-(defparameter *jit-lock* (mp:make-recursive-mutex 'jit-lock))
+;;; Processes serving LLVM-SYS:JIT-SERVE-TASKS.  Without them each
+;;; thread compiles the modules it adds when it looks them up.  Either
+;;; way, threads add and finalize modules without a lock.
+(defvar *jit-compile-processes* nil)
+
+(defun start-jit-compile-processes* (count)
+  (unless *jit-compile-processes*
+    (setf *jit-compile-processes*
+          (loop for i below count
+                collect (mp:process-run-function
+                         (format nil "jit-compile-~d" i)
+                         #'llvm-sys:jit-serve-tasks)))
+    ;; A stop only reaches the workers that have started serving.
+    (llvm-sys:jit-wait-for-task-workers count))
+  (values))
+
+(defun stop-jit-compile-processes* ()
+  (when *jit-compile-processes*
+    (llvm-sys:jit-stop-serving-tasks)
+    ;; One that was killed has already left.
+    (dolist (process *jit-compile-processes*)
+      (handler-case (mp:process-join process)
+        (mp:process-join-error ())))
+    (setf *jit-compile-processes* nil))
+  (values))
+
+(defvar *jit-compile-process-count* nil)
+
+(defun restart-jit-compile-processes* ()
+  (start-jit-compile-processes* *jit-compile-process-count*))
+
+(defun ext:start-jit-compile-threads
+    (&optional (count (max 1 (1- (core:num-logical-processors)))))
+  "Start COUNT processes that compile and link JIT modules in parallel.
+Like autocompilation, they are stopped before a snapshot is saved and
+started again when it is loaded."
+  (check-type count (integer 1))
+  (unless *jit-compile-processes*
+    (setf *jit-compile-process-count* count)
+    (pushnew 'stop-jit-compile-processes* core:*terminate-hooks*)
+    (pushnew 'restart-jit-compile-processes* core:*initialize-hooks*)
+    (start-jit-compile-processes* count)))
+
+(defun ext:stop-jit-compile-threads ()
+  (setf core:*terminate-hooks* (remove 'stop-jit-compile-processes* core:*terminate-hooks*)
+        core:*initialize-hooks* (remove 'restart-jit-compile-processes* core:*initialize-hooks*))
+  (stop-jit-compile-processes*))
 
 (defun jit-add-module-return-function (original-module startup-shutdown-id literals-list
                                        &key output-path)
@@ -145,9 +191,10 @@
                    (llvm-sys:dump-module module)
                    (format t "startup-name |{}|~%" startup-name)
                    (format t "Done dump module~%"))
-               (mp:with-lock (*jit-lock*)
-                 (when (member :dump-compile *features*)
-                   (llvm-sys:dump-module module))
-                 (llvm-sys:add-irmodule jit-engine (llvm-sys:get-main-jitdylib jit-engine) module cmp:*thread-safe-context* startup-shutdown-id)
-                 (llvm-sys:jit-finalize-repl-function jit-engine startup-name shutdown-name literals-list))))))
+               (when (member :dump-compile *features*)
+                 (llvm-sys:dump-module module))
+               ;; The startup lookup materializes the module before this
+               ;; thread builds any more IR in its context.
+               (llvm-sys:add-irmodule jit-engine (llvm-sys:get-main-jitdylib jit-engine) module cmp:*thread-safe-context* startup-shutdown-id)
+               (llvm-sys:jit-finalize-repl-function jit-engine startup-name shutdown-name literals-list)))))
     (gctools:thread-local-cleanup)))
@@ -95,6 +95,12 @@
     ("fdesignator" 59 ((constant-arg 1)) ((constant-arg 2)))
     ("called-fdefinition" 60 ((constant-arg 1)) ((constant-arg 2)))
     ("encell" 63 (1) (2))
+    ;; Superinstructions. Each is equivalent to the sequence of
+    ;; instructions it is named after, and is only emitted by the
+    ;; compiler when no label falls between them.
+    ("check-and-bind-required-args" 64 (1) (2)) ; check-arg-count-EQ n; bind-required-args n
+    ("call-return" 65 (1)) ; call n; return
+    ("pop-return" 66) ; pop; return
     ("long" 255)))
 
 (defun pythonify-arguments (args)
@@ -20,8 +20,9 @@
 (defmacro cfp-log (fmt &rest args) (declare (ignore fmt args)))
 
 (defclass thread-pool ()
-  ((%queue :initarg :queue :reader thread-pool-queue)
-   (%threads :initarg :threads :reader thread-pool-threads)))
+  ((%executor :initarg :executor :reader thread-pool-executor)
+   (%function :initarg :function :reader thread-pool-function)
+   (%arguments :initarg :arguments :reader thread-pool-arguments)))
 
 (defclass job ()
   ((%serious-condition :initform nil :accessor job-serious-condition
@@ -30,33 +31,27 @@
    (%notes :initform nil :accessor job-notes :type list)
    (%other-conditions :initform nil :accessor job-other-conditions :type list)))
 
-(defun thread-pool-jobber (queue function arguments)
-  (lambda ()
-    (unwind-protect
-         (loop for job = (core:dequeue queue :timeout 1.0 :timeout-val nil)
-               until (eq job :quit)
-               when job
-                 do (cfp-log "Thread ~a working on ~s~%"
-                             (mp:process-name mp:*current-process*) job)
-                    (block nil
-                      (handler-bind
-                          ((serious-condition
-                             (lambda (e)
-                               (setf (job-serious-condition job) e)
-                               ;; Cannot continue with this job,
-                               ;; so return to the loop to wait for more jobs.
-                               (return)))
-                           ;; Other conditions are suppressed and saved for the manager.
-                           (warning
-                             (lambda (w) (push w (job-warnings job)) (muffle-warning w)))
-                           (ext:compiler-note
-                             (lambda (n) (push n (job-notes job)) (muffle-note n)))
-                           ((not (or ext:compiler-note serious-condition warning))
-                             (lambda (c) (push c (job-other-conditions job)))))
-                        (apply function job arguments)))
-                    (cfp-log "Thread ~a done with job~%"
-                             (mp:process-name mp:*current-process*)))
-      (cfp-log "Leaving thread ~a~%" (mp:process-name mp:*current-process*)))))
+(defun run-job (job function arguments)
+  (cfp-log "Thread ~a working on ~s~%"
+           (mp:process-name mp:*current-process*) job)
+  (block nil
+    (handler-bind
+        ((serious-condition
+           (lambda (e)
+             (setf (job-serious-condition job) e)
+             ;; Cannot continue with this job,
+             ;; so return to the executor to wait for more jobs.
+             (return)))
+         ;; Other conditions are suppressed and saved for the manager.
+         (warning
+           (lambda (w) (push w (job-warnings job)) (muffle-warning w)))
+         (ext:compiler-note
+           (lambda (n) (push n (job-notes job)) (muffle-note n)))
+         ((not (or ext:compiler-note serious-condition warning))
+           (lambda (c) (push c (job-other-conditions job)))))
+      (apply function job arguments)))
+  (cfp-log "Thread ~a done with job~%"
+           (mp:process-name mp:*current-process*)))
 
 (defgeneric report-job-conditions (job)
   (:method ((job job))
@@ -79,32 +74,22 @@
 (defun make-thread-pool (function &key arguments (name 'thread-pool)
                                   (nthreads (core:num-logical-processors))
                                   special-bindings)
-  (loop with queue = (core:make-queue name)
-        with conc-name = (format nil "~(~a~)-" (symbol-name name))
-        for thread-num below nthreads
-        collect (mp:process-run-function
-                 (format nil "~a-~d" conc-name thread-num)
-                 (thread-pool-jobber queue function arguments)
-                 special-bindings)
-          into threads
-        finally (return (make-instance 'thread-pool
-                          :queue queue :threads threads))))
+  (make-instance 'thread-pool
+    :executor (mp:make-executor :name (format nil "~(~a~)" (symbol-name name))
+                                :workers nthreads
+                                :special-bindings special-bindings)
+    :function function :arguments arguments))
 
 (defun thread-pool-enqueue (pool job)
-  (core:atomic-enqueue (thread-pool-queue pool) job))
+  (mp:submit (thread-pool-executor pool) #'run-job
+             job (thread-pool-function pool) (thread-pool-arguments pool)))
 
 (defun thread-pool-quit (pool)
-  (loop with queue = (thread-pool-queue pool)
-        for thread in (thread-pool-threads pool)
-        do (cfp-log "Sending two :quit (why not?) for thread ~a~%"
-                    (mp:process-name thread))
-           (core:atomic-enqueue queue :quit)
-           (core:atomic-enqueue queue :quit)))
+  (mp:executor-shutdown (thread-pool-executor pool) :wait nil))
 
 (defun thread-pool-join (pool)
-  (loop for thread in (thread-pool-threads pool)
-        do (mp:process-join thread)
-           (cfp-log "Process-join of thread ~a~%" (mp:process-name thread))))
+  (mp:executor-shutdown (thread-pool-executor pool))
+  (cfp-log "Joined the threads of ~a~%" (thread-pool-executor pool)))
 
 ;;;
 
@@ -0,0 +1,406 @@
+;;;;  executor.lisp  -- A work-stealing thread pool with futures.
+;;;;
+;;;;  An EXECUTOR owns a fixed set of worker processes.  Each worker has
+;;;;  its own deque of tasks: work submitted from inside a worker goes on
+;;;;  that worker's deque and is popped LIFO by its owner, while idle
+;;;;  workers steal FIFO from the other end.  Work submitted from any other
+;;;;  process goes through a shared MP:CONCURRENT-QUEUE, on which idle
+;;;;  workers block.
+;;;;
+;;;;  SUBMIT returns a FUTURE.  The task runs with the submitter's values
+;;;;  of *SUBMIT-SPECIAL-VARIABLES*, and a serious condition that escapes
+;;;;  it is captured and resignaled by FUTURE-VALUE in the waiting thread.
+
+(in-package "MP")
+
+(export '(executor executorp make-executor executor-name executor-worker-count
+          executor-shutdown executor-shutdown-p default-executor
+          *default-executor-workers* *submit-special-variables*
+          future futurep submit future-done-p future-wait future-value
+          make-promise fulfill-promise fail-promise
+          parallel-map parallel-reduce))
+
+(defvar *submit-special-variables*
+  '(*package* *readtable*
+    *read-base* *read-default-float-format* *read-eval* *read-suppress*
+    *print-array* *print-base* *print-case* *print-circle* *print-escape*
+    *print-gensym* *print-length* *print-level* *print-lines*
+    *print-miser-width* *print-pretty* *print-radix* *print-readably*
+    *print-right-margin*)
+  "Special variables whose values in the submitting process are rebound
+around a task run by an executor.")
+
+(defvar *default-executor-workers* nil
+  "Number of workers in the default executor, or NIL to use one per
+logical processor.")
+
+;;; (executor . index) in a worker process, NIL elsewhere.
+(defvar *executor-worker* nil)
+
+;;; ------------------------------------------------------------
+;;; Futures
+
+(defstruct (future (:constructor %make-future (executor))
+                   (:predicate futurep)
+                   (:copier nil))
+  executor
+  (lock (make-lock :name "future"))
+  (cvar (make-condition-variable :name "future"))
+  (state :pending) ; :pending, :done or :failed
+  (values nil)
+  (condition nil))
+
+(defmethod print-object ((future future) stream)
+  (print-unreadable-object (future stream :type t :identity t)
+    (princ (future-state future) stream))
+  future)
+
+(defun make-promise ()
+  "Return a new future that is settled by FULFILL-PROMISE or FAIL-PROMISE
+rather than by running a task."
+  (%make-future nil))
+
+(defun %settle-future (future state values condition)
+  (with-lock ((future-lock future))
+    (unless (eq (future-state future) :pending)
+      (error "~a has already been settled." future))
+    (setf (future-values future) values
+          (future-condition future) condition
+          (future-state future) state)
+    (condition-variable-broadcast (future-cvar future)))
+  (when (future-executor future)
+    (%wake-helpers (future-executor future)))
+  future)
+
+(defun fulfill-promise (promise &rest values)
+  "Settle PROMISE so that FUTURE-VALUE returns VALUES."
+  (%settle-future promise :done values nil))
+
+(defun fail-promise (promise condition)
+  "Settle PROMISE so that FUTURE-VALUE signals CONDITION."
+  (%settle-future promise :failed nil condition))
+
+(defun future-done-p (future)
+  "Return true if FUTURE has been settled, either with values or with a
+condition."
+  (with-lock ((future-lock future))
+    (not (eq (future-state future) :pending))))
+
+;;; ------------------------------------------------------------
+;;; Per-worker deques
+;;;
+;;; TASKS holds the live entries between HEAD and the fill pointer.  The
+;;; owner pushes and pops at the fill pointer, thieves take from HEAD.
+
+(defstruct (work-deque (:constructor make-work-deque ())
+                       (:copier nil))
+  (lock (make-lock :name "work-deque"))
+  (tasks (make-array 32 :adjustable t :fill-pointer 0))
+  (head 0))
+
+(defun work-deque-push (deque task)
+  (with-lock ((work-deque-lock deque))
+    (vector-push-extend task (work-deque-tasks deque))))
+
+(defun %work-deque-take (deque fromp)
+  (with-lock ((work-deque-lock deque))
+    (let* ((tasks (work-deque-tasks deque))
+           (head (work-deque-head deque))
+           (tail (fill-pointer tasks)))
+      (when (< head tail)
+        (let ((index (if fromp head (1- tail))))
+          (prog1 (aref tasks index)
+            (setf (aref tasks index) nil)
+            (if fromp
+                (setf (work-deque-head deque) (1+ head))
+                (setf (fill-pointer tasks) index))
+            (when (= (work-deque-head deque) (fill-pointer tasks))
+              (setf (work-deque-head deque) 0
+                    (fill-pointer tasks) 0))))))))
+
+(defun work-deque-pop (deque) (%work-deque-take deque nil))
+(defun work-deque-steal (deque) (%work-deque-take deque t))
+
+;;; ------------------------------------------------------------
+;;; Executors
+
+(defstruct (executor (:constructor %make-executor (name injector deques))
+                     (:predicate executorp)
+                     (:copier nil))
+  name
+  ;; Tasks submitted from outside the workers, plus :WAKE and :QUIT
+  ;; tokens addressed to whichever worker takes them.
+  injector
+  ;; One WORK-DEQUE per worker.
+  deques
+  (workers nil)
+  ;; Number of workers blocked on the injector.
+  (idle 0)
+  ;; Workers in FUTURE-WAIT with nothing to run wait on HELP-CVAR for new
+  ;; work or a settled future; HELP-EPOCH counts the signals.
+  (helpers 0)
+  (help-epoch 0)
+  (help-lock (make-lock :name "executor-help"))
+  (help-cvar (make-condition-variable :name "executor-help"))
+  (shutdown-p nil))
+
+(defmethod print-object ((executor executor) stream)
+  (print-unreadable-object (executor stream :type t :identity t)
+    (format stream "~a (~d worker~:p)~:[~; shut down~]"
+            (executor-name executor) (executor-worker-count executor)
+            (executor-shutdown-p executor)))
+  executor)
+
+(defun executor-worker-count (executor)
+  (length (executor-deques executor)))
+
+;;; Wake the workers waiting in FUTURE-WAIT, if any.  Call this after
+;;; making the work or the settled future visible: a helper counts itself
+;;; in HELPERS before it reads HELP-EPOCH and looks for work, so either it
+;;; sees our change or we see it and bump the epoch it waits on.
+(defun %wake-helpers (executor)
+  (when (plusp (atomic (executor-helpers executor)))
+    (with-lock ((executor-help-lock executor))
+      (atomic-incf (executor-help-epoch executor))
+      (condition-variable-broadcast (executor-help-cvar executor)))))
+
+;;; Return the next item for worker INDEX (NIL outside of a worker):
+;;; its own newest task, then a task from the injector, then the oldest
+;;; task of another worker.  A :QUIT token from the injector is returned
+;;; as is; NIL means there is nothing to do right now.
+(defun %find-task (executor index)
+  (let ((deques (executor-deques executor)))
+    (or (and index (work-deque-pop (svref deques index)))
+        (loop (multiple-value-bind (item foundp)
+                  (concurrent-queue-try-pop (executor-injector executor))
+                (cond ((not foundp) (return nil))
+                      ((not (eq item :wake)) (return item)))))
+        (loop with n = (length deques)
+              with start = (if index (1+ index) 0)
+              for k below n
+              for victim = (svref deques (mod (+ start k) n))
+                thereis (work-deque-steal victim)))))
+
+(defun %worker-loop (executor index)
+  (flet ((drain ()
+           (loop for task = (%find-task executor index)
+                 while (functionp task)
+                 do (funcall task)
+                 ;; Leave other workers' :QUITs for them.
+                 finally (when task
+                           (concurrent-queue-push (executor-injector executor)
+                                                  task)))))
+    (loop
+      (let ((item (%find-task executor index)))
+        (unless item
+          ;; Announce ourselves as idle before looking once more, so
+          ;; that a worker pushing to its own deque either sees us and
+          ;; sends a :WAKE, or we see its task.
+          (atomic-incf (executor-idle executor))
+          (setf item
+                (unwind-protect
+                     (or (%find-task executor index)
+                         (values (concurrent-queue-pop
+                                  (executor-injector executor))))
+                  (atomic-decf (executor-idle executor)))))
+        (cond ((functionp item) (funcall item))
+              ((eq item :quit) (drain) (return)))))))
+
+(defun make-executor (&key (name "executor")
+                           (workers (or *default-executor-workers*
+                                        (core:num-logical-processors)))
+                           special-bindings)
+  "Create an executor with WORKERS worker processes.
+SPECIAL-BINDINGS is an alist of (symbol . form) established in each
+worker, as for PROCESS-RUN-FUNCTION."
+  (check-type workers (integer 1))
+  (let* ((deques (make-array workers))
+         (executor (%make-executor name (make-concurrent-queue :name name)
+                                   deques)))
+    (dotimes (i workers)
+      (setf (svref deques i) (make-work-deque)))
+    (setf (executor-workers executor)
+          (loop for i below workers
+                for worker = (cons executor i)
+                collect (process-run-function
+                         (format nil "~a-~d" name i)
+                         (let ((i i))
+                           (lambda () (%worker-loop executor i)))
+                         (list* (cons '*executor-worker* `',worker)
+                                special-bindings))))
+    executor))
+
+(defun executor-shutdown (executor &key (wait t))
+  "Stop EXECUTOR from accepting new work.  Its workers exit once all work
+already submitted has run.  If WAIT is true, wait for them to do so."
+  (unless (executor-shutdown-p executor)
+    (setf (executor-shutdown-p executor) t)
+    (loop repeat (executor-worker-count executor)
+          do (concurrent-queue-push (executor-injector executor) :quit)))
+  (when wait
+    (mapc #'process-join (executor-workers executor)))
+  executor)
+
+(defvar *default-executor* nil)
+(defvar *default-executor-lock* (make-lock :name "default-executor"))
+
+(defun default-executor ()
+  "Return the executor used when none is given, creating it on first use."
+  (or *default-executor*
+      (with-lock (*default-executor-lock*)
+        (or *default-executor*
+            (setf *default-executor*
+                  (make-executor :name "default-executor"))))))
+
+;;; ------------------------------------------------------------
+;;; Submitting work
+
+(defun %run-task (future function arguments)
+  (unwind-protect
+       (handler-case (multiple-value-list (apply function arguments))
+         (serious-condition (condition)
+           (%settle-future future :failed nil condition))
+         (:no-error (values)
+           (%settle-future future :done values nil)))
+    ;; The task was unwound past us, e.g. by ABORT-PROCESS.
+    (when (eq (future-state future) :pending)
+      (ignore-errors
+       (%settle-future future :failed nil
+                       (make-condition 'simple-error
+                                       :format-control "The task of ~a was aborted."
+                                       :format-arguments (list future)))))))
+
+(defun submit (executor function &rest arguments)
+  "Arrange for FUNCTION to be applied to ARGUMENTS by a worker of EXECUTOR
+(the default executor if NIL), and return a FUTURE for its values."
+  (let* ((executor (or executor (default-executor)))
+         (future (%make-future executor))
+         (symbols (remove-if-not #'boundp *submit-special-variables*))
+         (values (mapcar #'symbol-value symbols))
+         (task (lambda ()
+                 (progv symbols values
+                   (%run-task future function arguments))))
+         (worker *executor-worker*))
+    (when (executor-shutdown-p executor)
+      (error "Cannot submit work to ~a." executor))
+    (cond ((and worker (eq (car worker) executor))
+           (work-deque-push (svref (executor-deques executor) (cdr worker))
+                            task)
+           (when (plusp (atomic (executor-idle executor)))
+             (concurrent-queue-push (executor-injector executor) :wake)))
+          (t (concurrent-queue-push (executor-injector executor) task)))
+    (%wake-helpers executor)
+    future))
+
+(defun future-wait (future &optional timeout)
+  "Wait until FUTURE is settled, or until TIMEOUT seconds have passed if
+TIMEOUT is non-NIL.  Return true if it was settled.
+A worker waiting on a future of its own executor runs other tasks in the
+meantime, so nested submissions cannot starve the pool."
+  (let ((executor (future-executor future))
+        (worker *executor-worker*)
+        (deadline (and timeout
+                       (+ (get-internal-real-time)
+                          (* timeout internal-time-units-per-second)))))
+    (flet ((remaining ()
+             (and deadline
+                  (max 0d0 (/ (float (- deadline (get-internal-real-time)) 1d0)
+                              internal-time-units-per-second))))
+           (done-p ()
+             (not (eq (future-state future) :pending))))
+      (if (and worker (eq (car worker) executor))
+          ;; Run tasks until the future is settled; when there are none,
+          ;; sleep until a task is submitted or a future is settled.
+          (progn
+            (atomic-incf (executor-helpers executor))
+            (unwind-protect
+                 (loop
+                   (let ((epoch (atomic (executor-help-epoch executor))))
+                     (when (future-done-p future)
+                       (return t))
+                     (let ((task (%find-task executor (cdr worker))))
+                       (cond ((functionp task) (funcall task))
+                             (t
+                              ;; Keep a :QUIT for the worker loop.
+                              (when task
+                                (concurrent-queue-push
+                                 (executor-injector executor) task))
+                              (when (and deadline (zerop (remaining)))
+                                (return (future-done-p future)))
+                              (with-lock ((executor-help-lock executor))
+                                (when (= epoch
+                                         (atomic (executor-help-epoch executor)))
+                                  (if deadline
+                                      (condition-variable-timedwait
+                                       (executor-help-cvar executor)
+                                       (executor-help-lock executor)
+                                       (remaining))
+                                      (condition-variable-wait
+                                       (executor-help-cvar executor)
+                                       (executor-help-lock executor))))))))))
+              (atomic-decf (executor-helpers executor))))
+          (with-lock ((future-lock future))
+            (loop until (done-p)
+                  do (if deadline
+                         (condition-variable-timedwait
+                          (future-cvar future) (future-lock future)
+                          (remaining))
+                         (condition-variable-wait (future-cvar future)
+                                                  (future-lock future)))
+                     (when (and deadline (zerop (remaining)))
+                       (return)))
+            (done-p))))))
+
+(defun future-value (future)
+  "Wait for FUTURE and return the values of its task.  If the task was
+ended by a serious condition, signal that condition here instead."
+  (future-wait future)
+  (ecase (future-state future)
+    (:done (values-list (future-values future)))
+    (:failed (error (future-condition future)))))
+
+;;; ------------------------------------------------------------
+;;; Data parallelism
+
+(defun %chunk-bounds (length executor chunk-size)
+  (let ((size (or chunk-size
+                  (max 1 (ceiling length
+                                  (* 4 (executor-worker-count executor)))))))
+    (loop for start from 0 below length by size
+          collect (cons start (min length (+ start size))))))
+
+(defun parallel-map (result-type function sequence &key executor chunk-size)
+  "Like MAP with one sequence, but calls FUNCTION on the elements in
+parallel, CHUNK-SIZE elements per task.  The order of the calls is
+unspecified; the order of the results is preserved."
+  (let* ((executor (or executor (default-executor)))
+         (input (coerce sequence 'simple-vector))
+         (output (make-array (length input)))
+         (futures (loop for (start . end)
+                          in (%chunk-bounds (length input) executor chunk-size)
+                        collect (submit executor
+                                        (lambda (start end)
+                                          (loop for i from start below end
+                                                do (setf (svref output i)
+                                                         (funcall function
+                                                                  (svref input i)))))
+                                        start end))))
+    (mapc #'future-value futures)
+    (and result-type (coerce output result-type))))
+
+(defun parallel-reduce (function sequence
+                        &key executor key (initial-value nil initial-value-p)
+                          chunk-size)
+  "Like REDUCE, but reduces chunks of SEQUENCE in parallel and then
+combines their results in order.  FUNCTION must be associative."
+  (let* ((executor (or executor (default-executor)))
+         (input (coerce sequence 'simple-vector))
+         (futures (loop for (start . end)
+                          in (%chunk-bounds (length input) executor chunk-size)
+                        collect (submit executor #'reduce function input
+                                        :start start :end end :key key)))
+         (partials (mapcar #'future-value futures)))
+    (cond (initial-value-p
+           (reduce function partials :initial-value initial-value))
+          (partials (reduce function partials))
+          (t (funcall function)))))
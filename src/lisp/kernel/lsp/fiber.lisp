@@ -0,0 +1,84 @@
+;;;;  fiber.lisp  -- Lightweight threads scheduled over carrier processes.
+;;;;
+;;;;  A FIBER-SCHEDULER owns a fixed set of carrier processes, each with
+;;;;  its own run queue, and one reactor process that serves the timers
+;;;;  and file descriptor waits of its fibers.  A fiber runs on the
+;;;;  carrier it was first placed on; when it parks, sleeps or waits for
+;;;;  a descriptor, the carrier runs its other fibers in the meantime.
+;;;;
+;;;;  FIBER-JOIN returns the values of a fiber's function, and resignals
+;;;;  a serious condition that ended it, like FUTURE-VALUE.
+
+(in-package "MP")
+
+(export '(make-fiber-scheduler fiber-scheduler-shutdown default-fiber-scheduler
+          *default-fiber-carriers* fiber-run-function fiber-join))
+
+(defvar *default-fiber-carriers* nil
+  "Number of carriers in the default fiber scheduler, or NIL to use one
+per logical processor.")
+
+(defun make-fiber-scheduler (&key (name "fiber-scheduler")
+                                  (carriers (or *default-fiber-carriers*
+                                                (core:num-logical-processors)))
+                                  stack-size)
+  "Create a fiber scheduler with CARRIERS carrier processes.
+STACK-SIZE is the size in bytes of the C stack of each fiber, or NIL for
+the default of one megabyte."
+  (check-type carriers (integer 1))
+  (check-type stack-size (or null (integer 1)))
+  (let ((scheduler (%make-fiber-scheduler name carriers (or stack-size 0))))
+    (%fiber-scheduler-set-processes
+     scheduler
+     (list* (process-run-function (format nil "~a-reactor" name)
+                                  (lambda () (%fiber-reactor-loop scheduler)))
+            (loop for i below carriers
+                  collect (process-run-function
+                           (format nil "~a-~d" name i)
+                           (let ((i i))
+                             (lambda () (%fiber-carrier-loop scheduler i)))))))
+    scheduler))
+
+(defun fiber-scheduler-shutdown (scheduler &key (wait t))
+  "Stop SCHEDULER from accepting new fibers.  Its carriers exit once all
+of their fibers have finished.  If WAIT is true, wait for them to do so."
+  (%fiber-scheduler-shutdown scheduler)
+  (when wait
+    (mapc #'process-join (fiber-scheduler-processes scheduler)))
+  scheduler)
+
+(defvar *default-fiber-scheduler* nil)
+(defvar *default-fiber-scheduler-lock* (make-lock :name "default-fiber-scheduler"))
+
+(defun default-fiber-scheduler ()
+  "Return the fiber scheduler used when none is given, creating it on
+first use."
+  (or *default-fiber-scheduler*
+      (with-lock (*default-fiber-scheduler-lock*)
+        (or *default-fiber-scheduler*
+            (setf *default-fiber-scheduler*
+                  (make-fiber-scheduler :name "default-fiber-scheduler"))))))
+
+(defun fiber-run-function (name function &key special-bindings scheduler)
+  "Start a fiber named NAME that calls FUNCTION with no arguments on a
+carrier of SCHEDULER (the default scheduler if NIL), and return it.
+SPECIAL-BINDINGS is an alist of (symbol . form) as for
+PROCESS-RUN-FUNCTION."
+  (%make-fiber (or scheduler (default-fiber-scheduler))
+               name
+               (lambda ()
+                 (handler-case (multiple-value-list (funcall function))
+                   (serious-condition (condition) (list :failed condition))
+                   (:no-error (values) (list* :done values))))
+               special-bindings))
+
+(defun fiber-join (fiber)
+  "Wait until FIBER has finished and return the values of its function.
+If the function was ended by a serious condition, signal that condition
+here instead."
+  (%fiber-join-wait fiber)
+  (let ((result (first (%fiber-result fiber))))
+    (case (car result)
+      (:done (values-list (cdr result)))
+      (:failed (error (second result)))
+      (t (error "~a was aborted." fiber)))))
@@ -252,5 +252,7 @@
             with-current-source-form
             start-autocompilation
             stop-autocompilation
+            start-jit-compile-threads
+            stop-jit-compile-threads
             ;; Misc
             printing-char-p)))
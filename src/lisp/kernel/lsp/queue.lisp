@@ -51,15 +51,15 @@
   (gctools:wait-for-user-signal "About to crash"))
 
 
+;;; The queue itself is a lock-free MP:CONCURRENT-QUEUE; this structure
+;;; just gives it a name and the old interface.
 (defstruct (queue
             (:constructor make-queue
                 (name
-                 &aux
-                   (lock (mp:make-lock :name (format nil "~A-LOCK" name)))
-                   (not-empty (mp:make-condition-variable :name (format nil "~A-NOT-EMPTY" name)))))
+                 &aux (native (mp:make-concurrent-queue :name name))))
             (:copier nil)
             (:predicate queuep))
-  name (head nil) (tail nil) lock not-empty)
+  name native)
 
 (eval-when (:compile-toplevel :load-toplevel :execute)
   (setf (documentation 'make-queue 'function) "
@@ -67,21 +67,12 @@ RETURN:     A new queue named NAME
 "
         (documentation 'queue-name 'function) "
 RETURN:     The name of the QUEUE.
-"
-        (documentation 'queue-head 'function) "
-RETURN:     the head CONS cell of the QUEUE.
-"
-        (documentation 'queue-tail 'function) "
-RETURN:     the tail CONS cell of the QUEUE.
 "
         (documentation 'queuep 'function) "
 RETURN:     Predicate for the QUEUE type.
 "
-        (documentation 'queue-lock 'function) "
-RETURN:     The lock of the QUEUE.
-"
-        (documentation 'queue-not-empty 'function) "
-RETURN:     The NOT-EMPTY condition variable of the QUEUE.
+        (documentation 'queue-native 'function) "
+RETURN:     The MP:CONCURRENT-QUEUE holding the entries of the QUEUE.
 "))
 
 (defun atomic-enqueue (queue message)
@@ -90,52 +81,30 @@ DO:         Atomically enqueues the MESSAGE in the QUEUE.
 
 RETURN:     MESSAGE
 "
-  (mp:with-lock ((queue-lock queue))
-    (if (queue-tail queue)
-        (setf (cdr (queue-tail queue)) (list message)
-              (queue-tail queue) (cdr (queue-tail queue)))
-        (setf (queue-head queue) (setf (queue-tail queue) (list message))))
-    (mp:condition-variable-signal (queue-not-empty queue)))
+  (mp:concurrent-queue-push (queue-native queue) message)
   message)
 
 (defun dequeue (queue &key (timeout nil) (timeout-val nil))
   "
 DO:         Atomically, dequeue the first message from the QUEUE.  If
-            the queue is empty,  then wait on the not-empty condition
-            of the queue.
+            the queue is empty, wait until a message is enqueued, or
+            until TIMEOUT seconds have passed if TIMEOUT is non-NIL.
 
-RETURN:     the dequeued MESSAGE.
+RETURN:     the dequeued MESSAGE, or TIMEOUT-VAL on timeout.
 "
-  (mp:with-lock ((queue-lock queue))
-    (loop :until (queue-head queue)
-          :do (if timeout
-                  (mp:condition-variable-timedwait (queue-not-empty queue) (queue-lock queue) timeout)
-                  (mp:condition-variable-wait (queue-not-empty queue) (queue-lock queue)))
-          :if (and timeout (null (queue-head queue)))
-            :do (return-from dequeue timeout-val))
-    (if (eq (queue-head queue) (queue-tail queue))
-        (prog1 (car (queue-head queue))
-          (setf (queue-head queue) nil
-                (queue-tail queue) nil))
-        (pop (queue-head queue)))))
+  (multiple-value-bind (message foundp)
+      (mp:concurrent-queue-pop (queue-native queue) timeout)
+    (if foundp message timeout-val)))
 
 (defun dequeue-timed (queue time)
   "
 DO:         Atomically, dequeue the first message from the QUEUE.  If
-            the queue is empty,  then wait on the not-empty condition
-            of the queue.
+            the queue is empty,  then wait until a message is enqueued.
 
 RETURN:     the dequeued MESSAGE.
 "
   (declare (ignore time))
-  (mp:with-lock ((queue-lock queue))
-    (loop :until (queue-head queue)
-          :do (mp:condition-variable-wait (queue-not-empty queue) (queue-lock queue)))
-    (if (eq (queue-head queue) (queue-tail queue))
-        (prog1 (car (queue-head queue))
-          (setf (queue-head queue) nil
-                (queue-tail queue) nil))
-        (pop (queue-head queue)))))
+  (values (mp:concurrent-queue-pop (queue-native queue))))
 
 (defun queue-count (queue)
   "
@@ -144,8 +113,7 @@ RETURN:     The number of entries in the QUEUE.
 NOTE:       The result may be falsified immediately, if another thread
             enqueues or dequeues.
 "
-  (mp:with-lock ((queue-lock queue))
-    (length (queue-head queue))))
+  (mp:concurrent-queue-count (queue-native queue)))
 
 (defun queue-emptyp (queue)
   "
@@ -155,7 +123,7 @@ NOTE:       The result may be falsified immediately, becoming false if
             another thread enqueues, or becoming true if another
             thread dequeues.
 "
-  (not (queue-head queue)))
+  (mp:concurrent-queue-emptyp (queue-native queue)))
 
 ;;;; THE END ;;;;
          
@@ -30,6 +30,10 @@
   (let ((core:*use-interpreter-for-eval* nil))
     #-staging (when (ext:getenv "CLASP_AUTOCOMPILATION")
                 (funcall 'ext:start-autocompilation))
+    #-staging (let ((threads (ext:getenv "CLASP_JIT_THREADS")))
+                (when threads
+                  (funcall 'ext:start-jit-compile-threads
+                           (parse-integer threads))))
     (case (core:startup-type)
       ((:snapshot-file :embedded-snapshot)
        (sys::load-foreign-libraries))
@@ -2,8 +2,8 @@
 ;;
 ;; This file provides a port the SBCL/CMUCL 'serve-event'
 ;; functionality to ecl.  serve-event provides a lispy abstraction of
-;; unix select(2) non-blocking IO (and potentially other variants such as
-;; epoll).  It works with Unix-level file-descriptors, which can be
+;; unix select(2) non-blocking IO, and of epoll(7) where it is
+;; available.  It works with Unix-level file-descriptors, which can be
 ;; retrieved from the sockets module using the socket-file-descriptor
 ;; slot.
 ;;
@@ -37,12 +37,14 @@
 (defpackage "SERVE-EVENT"
   (:use "CL" #-clasp "UFFI" #+clasp "SERVE-EVENT-INTERNAL")
   (:export "WITH-FD-HANDLER" "ADD-FD-HANDLER" "REMOVE-FD-HANDLER"
-           "SERVE-EVENT" "SERVE-ALL-EVENTS"))
+           "SERVE-EVENT" "SERVE-ALL-EVENTS" "WAIT-UNTIL-FD-USABLE"
+           "*SERVE-EVENT-BACKEND*"))
 (in-package "SERVE-EVENT")
 
 
 (defstruct (handler
-             (:constructor make-handler (descriptor direction function))
+             (:constructor make-handler (descriptor direction function
+                                         &optional edge-triggered))
              (:copier nil))
   ;; Reading or writing...
   (direction nil :type (member :input :output))
@@ -50,24 +52,48 @@
   ;; FIXME: Should be based on FD_SETSIZE
   (descriptor 0)
   ;; Function to call.
-  (function nil :type function))
+  (function nil :type function)
+  ;; Only used by the epoll backend - report readiness once per change
+  ;; rather than for as long as the descriptor stays ready.
+  (edge-triggered nil))
 
 
 (defvar *descriptor-handlers* nil
   ;;  #!+sb-doc
   "List of all the currently active handlers for file descriptors")
 
+(defvar *serve-event-backend* (if (ll-epoll-available-p) :epoll :select)
+  "Either :EPOLL or :SELECT. The epoll backend keeps the handlers
+registered with the kernel between calls to SERVE-EVENT, so waiting
+does not depend on the number of handlers and descriptors are not
+limited to FD_SETSIZE.")
+
+;;; State of the epoll backend. Handlers are registered as they are
+;;; added and removed, keyed by descriptor since epoll only allows one
+;;; registration per descriptor.
+(defvar *epoll-descriptor* nil)
+(defvar *epoll-handlers* (make-hash-table))
+;;; Descriptors that epoll refuses with EPERM, such as regular files.
+;;; select always reports them as usable, so their handlers are called
+;;; on every SERVE-EVENT.
+(defvar *epoll-always-ready* (make-hash-table))
+(defvar *epoll-max-events* 256)
+
 (defun coerce-to-descriptor (stream-or-fd direction)
   (if (typep stream-or-fd 'fixnum)
       stream-or-fd
       (gray:stream-file-descriptor stream-or-fd direction)))
 
 ;;; Add a new handler to *descriptor-handlers*.
-(defun add-fd-handler (stream-or-fd direction function)
+(defun add-fd-handler (stream-or-fd direction function &key edge-triggered)
   "Arrange to call FUNCTION whenever the fd designated by STREAM-OR-FD
   is usable. DIRECTION should be either :INPUT or :OUTPUT. The value
   returned should be passed to SYSTEM:REMOVE-FD-HANDLER when it is no
-  longer needed."
+  longer needed. If EDGE-TRIGGERED is true and the epoll backend is in
+  use, FUNCTION is only called when the fd becomes usable, so it must
+  consume everything that is available. While the fd also has handlers
+  that are not edge triggered, it is called whenever the fd is usable,
+  like them."
   (unless (member direction '(:input :output))
     (error 'simple-type-error
            :format-control "Invalid direction ~S, must be either :INPUT or :OUTPUT."
@@ -76,7 +102,11 @@
            :expected-type '(member :input :output)))
   (let ((handler (make-handler (coerce-to-descriptor stream-or-fd direction)
                                direction
-                               function)))
+                               function
+                               edge-triggered)))
+    ;; Register first so that a failure leaves no handler behind.
+    (when (eq *serve-event-backend* :epoll)
+      (epoll-add-handler handler))
     (push handler *descriptor-handlers*)
     handler))
 
@@ -84,6 +114,8 @@
 (defun remove-fd-handler (handler)
   ;;  #!+sb-doc
   "Removes HANDLER from the list of active handlers."
+  (when (eq *serve-event-backend* :epoll)
+    (epoll-remove-handler handler))
   (setf *descriptor-handlers*
         (delete handler *descriptor-handlers*)))
 
@@ -115,13 +147,125 @@
   `(ll-fdset-size))
 
 
+;;; epoll backend
+
+(defun epoll-descriptor ()
+  (or *epoll-descriptor*
+      (multiple-value-bind (epfd errno)
+          (ll-epoll-create)
+        (when (minusp epfd)
+          (error "Error during epoll_create errno:~A" errno))
+        (setf *epoll-descriptor* epfd))))
+
+;;; The registration covers every handler of the descriptor, so it can
+;;; only be edge triggered if all of them are.
+(defun epoll-event-mask (handlers)
+  (let ((mask (if (and handlers (every #'handler-edge-triggered handlers))
+                  +epollet+
+                  0)))
+    (dolist (handler handlers mask)
+      (setf mask (logior mask
+                         (ecase (handler-direction handler)
+                           (:input +epollin+)
+                           (:output +epollout+)))))))
+
+(defun epoll-ctl (op fd handlers)
+  (ll-epoll-ctl (epoll-descriptor) op fd (epoll-event-mask handlers)))
+
+(defun epoll-update (fd old-handlers new-handlers)
+  ;; A descriptor that was always ready may have been closed and its
+  ;; number reused, so try to register it again.
+  (let ((op (cond ((null new-handlers) +epoll-ctl-del+)
+                  ((or (null old-handlers) (gethash fd *epoll-always-ready*))
+                   +epoll-ctl-add+)
+                  (t +epoll-ctl-mod+))))
+    (multiple-value-bind (retval errno)
+        (epoll-ctl op fd new-handlers)
+      ;; Our idea of what is registered can be stale: the kernel drops a
+      ;; descriptor that is closed without REMOVE-FD-HANDLER, but keeps
+      ;; one whose file is still open through a duplicate.
+      (when (minusp retval)
+        (cond ((and (= op +epoll-ctl-mod+) (= errno +enoent+))
+               (multiple-value-setq (retval errno)
+                 (epoll-ctl +epoll-ctl-add+ fd new-handlers)))
+              ((and (= op +epoll-ctl-add+) (= errno +eexist+))
+               (multiple-value-setq (retval errno)
+                 (epoll-ctl +epoll-ctl-mod+ fd new-handlers)))))
+      (cond ((not (minusp retval))
+             (remhash fd *epoll-always-ready*))
+            ;; Removing a descriptor that is already gone is not an error.
+            ((= op +epoll-ctl-del+))
+            ((= errno +eperm+)
+             (setf (gethash fd *epoll-always-ready*) t))
+            (t
+             (error "Error during epoll_ctl fd:~A errno:~A" fd errno))))
+    (if new-handlers
+        (setf (gethash fd *epoll-handlers*) new-handlers)
+        (progn (remhash fd *epoll-handlers*)
+               (remhash fd *epoll-always-ready*)))))
+
+(defun epoll-add-handler (handler)
+  (let* ((fd (handler-descriptor handler))
+         (old (gethash fd *epoll-handlers*)))
+    (epoll-update fd old (cons handler old))))
+
+(defun epoll-remove-handler (handler)
+  (let* ((fd (handler-descriptor handler))
+         (old (gethash fd *epoll-handlers*)))
+    (when (member handler old)
+      (epoll-update fd old (remove handler old)))))
+
+(defun epoll-serve-always-ready ()
+  ;; Handlers may add or remove handlers, so don't call them while
+  ;; iterating over the tables.
+  (let ((served nil))
+    (dolist (fd (loop for fd being the hash-keys of *epoll-always-ready*
+                      collect fd)
+                served)
+      (dolist (handler (gethash fd *epoll-handlers*))
+        (setf served t)
+        (funcall (handler-function handler) fd)))))
+
+(defun epoll-serve-event (seconds)
+  (let ((esize (* *epoll-max-events* (ll-epoll-event-size)))
+        ;; Don't wait if some descriptors are usable anyway.
+        (always-ready (plusp (hash-table-count *epoll-always-ready*))))
+    (clasp-ffi:with-foreign-objects ((events `(:array :unsigned-byte ,esize)))
+      (multiple-value-bind (retval errno)
+          (ll-epoll-wait (epoll-descriptor) events *epoll-max-events*
+                         (cond (always-ready 0)
+                               ((null seconds) -1)
+                               (t (ceiling (* seconds 1000)))))
+        (cond ((zerop retval)
+               (epoll-serve-always-ready))
+              ((minusp retval)
+               (if (= errno +eintr+)
+                   nil
+                   (error "Error during epoll_wait retval:~A errno:~A" retval errno)))
+              (t
+               (dotimes (index retval)
+                 (multiple-value-bind (fd mask)
+                     (ll-epoll-event-ref events index)
+                   ;; Errors and hangups are reported to both directions so
+                   ;; the handler gets to see the failing read or write.
+                   (dolist (handler (gethash fd *epoll-handlers*))
+                     (when (logtest mask
+                                    (logior +epollerr+ +epollhup+
+                                            (ecase (handler-direction handler)
+                                              (:input +epollin+)
+                                              (:output +epollout+))))
+                       (funcall (handler-function handler) fd)))))
+               (epoll-serve-always-ready)
+               t))))))
+
 (defun serve-event (&optional (seconds nil))
   "Receive pending events on all FD-STREAMS and dispatch to the appropriate
    handler functions. If timeout is specified, server will wait the specified
    time (in seconds) and then return, otherwise it will wait until something
    happens. Server returns T if something happened and NIL otherwise. Timeout
    0 means polling without waiting."
-
+  (when (eq *serve-event-backend* :epoll)
+    (return-from serve-event (epoll-serve-event seconds)))
   ;; fd_set is an opaque typedef, so we can't declare it locally.
   ;; However we can fine out its size and allocate a char array of
   ;; the same size which can be used in its place.
@@ -177,4 +321,30 @@ T if SERVE-EVENT did something and NIL if not."
       ((null sval) res)
     (setq res t)))
 
+;;; Wait for the descriptor to become usable, serving other events in
+;;; the meantime. A fiber parks instead, so its carrier is not blocked.
+(defun wait-until-fd-usable (stream-or-fd direction &optional timeout)
+  "Wait until the fd designated by STREAM-OR-FD is usable for DIRECTION
+(:INPUT or :OUTPUT), or until TIMEOUT seconds have passed if TIMEOUT is
+non-NIL. Return T if it is usable and NIL otherwise. Inside a fiber only
+the fiber waits; elsewhere other handlers are served while waiting."
+  (let ((fd (coerce-to-descriptor stream-or-fd direction)))
+    (if (mp:current-fiber)
+        (mp:fiber-wait-fd fd direction timeout)
+        (let ((usable nil)
+              (deadline (and timeout
+                             (+ (get-internal-real-time)
+                                (* timeout internal-time-units-per-second)))))
+          (with-fd-handler (fd direction (lambda (fd)
+                                           (declare (ignore fd))
+                                           (setf usable t)))
+            (loop until usable
+                  do (serve-event
+                      (and deadline
+                           (max 0 (/ (float (- deadline (get-internal-real-time)) 1d0)
+                                     internal-time-units-per-second))))
+                  until (and deadline
+                             (>= (get-internal-real-time) deadline))))
+          usable))))
+
 (provide 'serve-event)
@@ -27,7 +27,8 @@
           NETDB-SUCCESS-ERROR NETDB-INTERNAL-ERROR
           HOST-NOT-FOUND-ERROR TRY-AGAIN-ERROR NO-RECOVERY-ERROR
           ;;; but aren't
-          HOST-ENT-ADDRESSES HOST-ENT HOST-ENT-ADDRESS SOCKET-SEND))
+          HOST-ENT-ADDRESSES HOST-ENT HOST-ENT-ADDRESS SOCKET-SEND
+          SOCKET-READV SOCKET-WRITEV SOCKET-RECEIVE-MESSAGES SOCKET-SEND-MESSAGES))
 
 
 
@@ -211,6 +212,33 @@ list of an ip address and a port). If no socket address is provided, send(2)
 will be called instead. Returns the number of octets written."))
 
 
+(defgeneric socket-readv (socket buffers)
+  (:documentation "Read from SOCKET into the list BUFFERS of octet vectors, filling each
+in turn, using readv(2).  The buffers must not move during the call, so
+allocate them with SYS:MAKE-STATIC-VECTOR.  Returns the number of octets
+read, or NIL if the call would block or was interrupted."))
+
+(defgeneric socket-writev (socket buffers &key lengths)
+  (:documentation "Write the list BUFFERS of static octet vectors to SOCKET using
+writev(2).  LENGTHS, if given, is a vector of the number of octets to
+write from each buffer.  Returns the number of octets written, or NIL if
+the call would block or was interrupted."))
+
+(defgeneric socket-receive-messages (socket buffers lengths &key addresses dontwait)
+  (:documentation "Receive up to one datagram into each of the static octet vectors in
+the list BUFFERS with a single recvmmsg(2) call where it is available.
+The size of each datagram is stored into the vector LENGTHS and, if
+ADDRESSES is a vector, the address of its sender (a list of an ip
+address and a port) into ADDRESSES.  Returns the number of datagrams
+received, or NIL if the call would block or was interrupted."))
+
+(defgeneric socket-send-messages (socket buffers &key lengths address dontwait nosignal)
+  (:documentation "Send each of the static octet vectors in the list BUFFERS as a datagram
+with a single sendmmsg(2) call where it is available.  LENGTHS, if
+given, is a vector of the number of octets to send from each buffer.
+ADDRESS is as for SOCKET-SEND.  Returns the number of datagrams sent,
+or NIL if the call would block or was interrupted."))
+
 (defgeneric socket-close (socket &key abort)
   (:documentation "Close SOCKET.  May throw any kind of error that write(2) would have
 thrown.  If SOCKET-MAKE-STREAM has been called, calls CLOSE on that
@@ -270,6 +298,12 @@ SB-SYS:MAKE-FD-STREAM."))
       (setf (slot-value socket 'file-descriptor) -1))))
 
 
+;;; A blocking call in a fiber would stall every fiber of its carrier,
+;;; so park the fiber until the socket is readable first.
+(defun wait-for-input-in-fiber (socket)
+  (when (and (mp:current-fiber) (not (non-blocking-mode socket)))
+    (mp:fiber-wait-fd (socket-file-descriptor socket) :input)))
+
 ;;; Receive data from a datagram socket, and return 4 values:
 ;;;   return-buffer, return-length, remote-host, and remove-port. 
 
@@ -287,6 +321,7 @@ SB-SYS:MAKE-FD-STREAM."))
                    need-to-copy t)))
     (let ((length (or length (length local-buffer)))
           (fd (socket-file-descriptor socket)))
+      (wait-for-input-in-fiber socket)
       (multiple-value-bind (len-recv errno remote-host remote-port)
           (ll-socket-receive fd local-buffer length oob peek waitall)
         (cond ((and (= len-recv -1)
@@ -301,6 +336,48 @@ SB-SYS:MAKE-FD-STREAM."))
                       (values buffer len-recv remote-host remote-port))
                      (t (values local-buffer len-recv remote-host remote-port)))))))))
 
+;;; Scatter/gather and batched datagram I/O.  These read and write the
+;;; caller's static vectors in place rather than copying through a
+;;; temporary buffer as SOCKET-RECEIVE and SOCKET-SEND do.
+
+(defmacro with-socket-io-result ((result errno) form syscall)
+  `(multiple-value-bind (,result ,errno) ,form
+     (cond ((and (= ,result -1)
+                 (member ,errno (list +eagain+ +eintr+)))
+            nil)
+           ((= ,result -1)
+            (socket-error ,syscall))
+           (t ,result))))
+
+(defmethod socket-readv ((socket socket) buffers)
+  (with-socket-io-result (len errno)
+    (ll-socket-readv (socket-file-descriptor socket) buffers)
+    "readv"))
+
+(defmethod socket-writev ((socket socket) buffers &key lengths)
+  (with-socket-io-result (len errno)
+    (ll-socket-writev (socket-file-descriptor socket) buffers lengths)
+    "writev"))
+
+(defmethod socket-receive-messages ((socket socket) buffers lengths &key addresses dontwait)
+  (with-socket-io-result (count errno)
+    (ll-socket-receive-messages (socket-file-descriptor socket) buffers lengths addresses dontwait)
+    "recvmmsg"))
+
+(defmethod socket-send-messages ((socket socket) buffers &key lengths address dontwait nosignal)
+  (when address
+    (assert (= 2 (length address))))
+  (with-socket-io-result (count errno)
+    (ll-socket-send-messages (socket-file-descriptor socket) buffers lengths
+                             (and address t)
+                             (if address (second address) 0)
+                             (if address (aref (first address) 0) 0)
+                             (if address (aref (first address) 1) 0)
+                             (if address (aref (first address) 2) 0)
+                             (if address (aref (first address) 3) 0)
+                             dontwait nosignal)
+    "sendmmsg"))
+
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ;;;
 ;;; INET SOCKETS
@@ -348,6 +425,7 @@ Examples:
 
 (defmethod socket-accept ((socket inet-socket))
   (let ((sfd (socket-file-descriptor socket)))
+    (wait-for-input-in-fiber socket)
     (multiple-value-bind (fd vector port)
         (ll-socket-accept-inet-socket sfd)
       (cond
@@ -436,6 +514,7 @@ also known as unix-domain sockets."))
         (socket-error "bind"))))
 
 (defmethod socket-accept ((socket local-socket))
+  (wait-for-input-in-fiber socket)
   (multiple-value-bind (fd name)
       (ll-socket-accept-local-socket (socket-file-descriptor socket))
     (cond
@@ -121,3 +121,91 @@
           (funcall cc) (funcall cc)
           (values (funcall c) warningsp failurep)))
       (3 nil nil))
+
+;;; Superinstructions (check-and-bind-required-args, call-return,
+;;; pop-return) behave like the sequences they replace, both in the VM
+;;; and when BTB compiled. The IF puts a jump target right before the
+;;; return, which must not be fused.
+(test btb.superinstructions
+      (let ((c (cmp:bytecompile
+                '(lambda (x y)
+                  (if x
+                      (list x y)
+                      (values y x))))))
+        (multiple-value-bind (cc warningsp failurep) (compile nil c)
+          (values (funcall c 1 2) (multiple-value-list (funcall c nil 3))
+                  (funcall cc 1 2) (multiple-value-list (funcall cc nil 3))
+                  warningsp failurep)))
+      ((1 2) (3 nil) (1 2) (3 nil) nil nil))
+
+(test-expect-error btb.superinstructions-arg-count
+                   (funcall (cmp:bytecompile '(lambda (x y) (cons x y))) 1)
+                   :type program-error)
+
+;;; Loop iterations count toward a function's hotness, like calls.
+(test btb.hotness-back-edges
+      (let ((c (cmp:bytecompile
+                '(lambda (n) (let ((s 0)) (dotimes (i n s) (incf s i)))))))
+        (values (funcall c 100)
+                (>= (core:bytecode-simple-fun/call-count (core:function/entry-point c))
+                    101)))
+      (4950 t))
+
+(test btb.autocompile-threshold
+      (let ((old (core:bytecode-autocompile-threshold)))
+        (unwind-protect
+             (progn (setf (core:bytecode-autocompile-threshold) 1000)
+                    (core:bytecode-autocompile-threshold))
+          (setf (core:bytecode-autocompile-threshold) old)))
+      (1000))
+
+;;; A function is handed to the autocompiler once, from a loop as well as
+;;; from a call, and also when the threshold is lowered below a count it
+;;; has already passed. The hook is bytecode, so it runs on the VM stack
+;;; of the looping function.
+(test btb.autocompile-hook-once
+      (let* ((old (core:bytecode-autocompile-threshold))
+             (queued (list nil))
+             (cmp:*autocompile-hook*
+               (cmp:bytecompile `(lambda (fun env)
+                                   (declare (ignore env))
+                                   (push fun (car ',queued))
+                                   fun)))
+             (loops (cmp:bytecompile
+                     '(lambda (n) (let ((s 0)) (dotimes (i n s) (incf s i))))))
+             (calls (cmp:bytecompile '(lambda (x) (1+ x)))))
+        (unwind-protect
+             (progn
+               (setf (core:bytecode-autocompile-threshold) 0)
+               (dotimes (i 50) (funcall calls i))
+               (setf (core:bytecode-autocompile-threshold) 10)
+               (let ((sum (funcall loops 100)))
+                 (funcall loops 100)
+                 (funcall calls 0)
+                 (funcall calls 0)
+                 (values sum
+                         (count (core:function/entry-point loops) (car queued))
+                         (count (core:function/entry-point calls) (car queued))
+                         ;; Queued functions keep counting.
+                         (core:bytecode-simple-fun/call-count
+                          (core:function/entry-point calls)))))
+          (setf (core:bytecode-autocompile-threshold) old)))
+      (4950 1 1 52))
+
+;;; Named calls from bytecode cache their callee in the function cell.
+;;; Redefinition has to be seen, and so do argument count mismatches.
+(test btb.call-cache-redefinition
+      (let ((name (gensym)))
+        (setf (fdefinition name) (cmp:bytecompile '(lambda (x) (+ x 1))))
+        (let* ((caller (cmp:bytecompile `(lambda (x) (,name x))))
+               (before (list (funcall caller 1) (funcall caller 2))))
+          (setf (fdefinition name) (cmp:bytecompile '(lambda (x) (* x 10))))
+          (append before (list (funcall caller 3)))))
+      ((2 3 30)))
+
+(test-expect-error btb.call-cache-arg-count
+                   (let ((name (gensym)))
+                     (setf (fdefinition name) (cmp:bytecompile '(lambda (x) x)))
+                     (funcall (cmp:bytecompile `(lambda (x) (,name x))) 1)
+                     (funcall (cmp:bytecompile `(lambda () (,name 1 2)))))
+                   :type program-error)
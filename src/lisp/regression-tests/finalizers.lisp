@@ -82,3 +82,16 @@
         count)
       (0)
       :description "Check if list of general finalizers were discarded")
+
+#+use-boehm
+(test gc-pause-statistics
+      (progn
+        (gctools:reset-gc-pause-statistics)
+        (gctools:garbage-collect)
+        (let ((stats (gctools:gc-pause-statistics)))
+          (values (plusp (getf stats :pauses))
+                  (<= 0 (getf stats :max-pause) (getf stats :total-pause))
+                  (<= (getf stats :total-pause)
+                      (/ (core:gc-real-time) internal-time-units-per-second 1d0)))))
+      (t t t)
+      :description "A collection stops the world and its pause is counted")
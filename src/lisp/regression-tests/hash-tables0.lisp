@@ -189,3 +189,55 @@
              (make-hash-table :size 128 :test #'eq :weakness :key)
              (gctools:garbage-collect)
              t))
+
+;;; Readers of thread-safe tables don't take the lock, so make sure
+;;; they still see every existing key while a writer rehashes.
+(test-true hash-table-concurrent-gethash
+           (let ((ht (make-hash-table :test #'equal)))
+             (loop for i below 1000
+                   do (setf (gethash (format nil "~d" i) ht) i))
+             (let ((writer (mp:process-run-function
+                            nil (lambda ()
+                                  (loop for i from 1000 below 50000
+                                        do (setf (gethash (format nil "~d" i) ht) i)))))
+                   (readers (loop repeat 4
+                                  collect (mp:process-run-function
+                                           nil (lambda ()
+                                                 (loop repeat 20
+                                                       always (loop for i below 1000
+                                                                    always (eql (gethash (format nil "~d" i) ht) i)))))))))
+               (mp:process-join writer)
+               (every #'mp:process-join readers))))
+
+;;; EQUAL tables probe hash fragments, exercise them across deletions
+;;; and rehashes.
+(test-true hash-table-equal-fragments
+           (let ((ht (make-hash-table :test #'equal)))
+             (loop for i below 5000
+                   do (setf (gethash (format nil "key-~d" i) ht) i))
+             (loop for i below 5000 by 2
+                   do (remhash (format nil "key-~d" i) ht))
+             (and (= (hash-table-count ht) 2500)
+                  (loop for i below 5000
+                        always (eql (gethash (format nil "key-~d" i) ht)
+                                    (if (evenp i) nil i))))))
+
+;;; Large tables grow incrementally, check that entries stay visible
+;;; while they are being moved to the new table.
+(test-true hash-table-incremental-rehash
+           (let ((ht (make-hash-table)))
+             (loop for i below 200000
+                   do (setf (gethash i ht) i)
+                   always (and (eql (gethash (floor i 2) ht) (floor i 2))
+                               (= (hash-table-count ht) (1+ i))))))
+
+(test hash-table-incremental-rehash-maphash
+      (let ((ht (make-hash-table))
+            (sum 0))
+        (loop for i below 100000
+              do (setf (gethash i ht) 1))
+        (loop for i below 100000 by 3
+              do (remhash i ht))
+        (maphash (lambda (k v) (declare (ignore k)) (incf sum v)) ht)
+        (values sum (hash-table-count ht)))
+      (66666 66666))
@@ -39,6 +39,58 @@
 (test-type recursive-mutex-string
            (mp:make-recursive-mutex "bla") mp:recursive-mutex)
 
+(test recursive-mutex-reenter
+      (let ((mut (mp:make-recursive-mutex "reenter")))
+        (mp:with-lock (mut)
+          (mp:with-lock (mut)
+            (mp:process-join
+             (mp:process-run-function
+              nil (lambda () (mp:get-lock mut nil)))))))
+      (nil))
+
+;;; Many short critical sections on one lock.
+(test mutex-contended
+      (let ((mut (mp:make-lock :name "contended"))
+            (counter 0))
+        (mapc #'mp:process-join
+              (loop repeat 8
+                    collect (mp:process-run-function
+                             nil (lambda ()
+                                   (loop repeat 20000
+                                         do (mp:with-lock (mut)
+                                              (incf counter)))))))
+        counter)
+      (160000))
+
+(test condition-variable-timeout
+      (let ((mut (mp:make-lock))
+            (cv (mp:make-condition-variable)))
+        (mp:with-lock (mut)
+          (mp:condition-variable-timedwait cv mut 0.05d0)))
+      (nil))
+
+;;; Waiting gives up every level of a recursive mutex and takes them
+;;; all back, so the notifier can take it and the waiter can unwind.
+(test condition-variable-recursive-mutex
+      (let ((mut (mp:make-recursive-mutex "cv-recursive"))
+            (cv (mp:make-condition-variable))
+            (ready nil))
+        (mp:with-lock (mut)
+          (mp:with-lock (mut)
+            (mp:process-run-function
+             nil (lambda ()
+                   (mp:with-lock (mut)
+                     (setf ready t)
+                     (mp:condition-variable-broadcast cv))))
+            (loop until ready
+                  do (mp:condition-variable-wait cv mut))))
+        (mp:process-join
+         (mp:process-run-function
+          nil (lambda ()
+                (prog1 (mp:get-lock mut nil)
+                  (mp:giveup-lock mut))))))
+      (t))
+
 (test process-active-p-1
       (let ((p (mp:process-run-function nil (lambda ()))))
         (mp:process-join p)
@@ -253,3 +305,286 @@
         (spam-processes nthreads (lambda () (mp:atomic-push nil (car place))))
         (car place))
       ((nil nil nil nil nil nil nil)))
+
+;;; A bytecode function whose frames each take a few dozen VM stack words.
+(defun fat-frame-recursor ()
+  (let ((vars (loop repeat 48 collect (gensym))))
+    (cmp:bytecompile
+     `(lambda (n)
+        (labels ((f (n)
+                   (if (zerop n)
+                       0
+                       (let ,(mapcar (lambda (v) `(,v n)) vars)
+                         (+ (f (1- n)) ,@vars)))))
+          (f n))))))
+
+(test vm-stack-grows
+      (let ((f (fat-frame-recursor)))
+        (mp:process-join
+         (mp:process-run-function nil (lambda () (funcall f 3000)))))
+      (216072000))
+
+(test vm-stack-overflow
+      (let ((f (fat-frame-recursor)))
+        (mp:process-join
+         (mp:process-run-function
+          nil
+          (lambda ()
+            (handler-case (funcall f 100000)
+              (ext:stack-overflow () :overflow)))
+          nil
+          (* 512 1024))))
+      (:overflow))
+
+;;; Pushing multiple values can take many more words than a frame's slack,
+;;; so a shallow stack has to grow for it rather than report an overflow.
+(test vm-stack-many-values
+      (let ((f (cmp:bytecompile
+                '(lambda (l)
+                  (list (length (multiple-value-call #'list
+                                  (values-list l) (values-list l)))
+                        (length (apply #'list (append l l)))))))
+            (l (make-list 4000 :initial-element 0)))
+        (mp:process-join
+         (mp:process-run-function
+          nil
+          (lambda ()
+            (handler-case (funcall f l)
+              (ext:stack-overflow () :overflow))))))
+      ((8000 8000)))
+
+(test concurrent-queue-fifo
+      (let ((q (mp:make-concurrent-queue :name 'test)))
+        (dotimes (i 5) (mp:concurrent-queue-push q i))
+        (values (mp:concurrent-queue-count q)
+                (loop repeat 5 collect (mp:concurrent-queue-pop q))
+                (multiple-value-list (mp:concurrent-queue-try-pop q))
+                (mp:concurrent-queue-emptyp q)))
+      (5 (0 1 2 3 4) (nil nil) t))
+
+(test concurrent-queue-bounded
+      (let ((q (mp:make-concurrent-queue :capacity 3)))
+        (values (mp:concurrent-queue-capacity q)
+                (loop repeat 5 collect (mp:concurrent-queue-push q t))
+                (loop repeat 4 collect (mp:concurrent-queue-try-pop q))))
+      (4 (t t t t nil) (t t t t)))
+
+(test concurrent-queue-timeout
+      (multiple-value-list
+       (mp:concurrent-queue-pop (mp:make-concurrent-queue) 0.01))
+      ((nil nil)))
+
+;;; Several producers and consumers; every item comes out exactly once.
+(test concurrent-queue-mpmc
+      (let* ((q (mp:make-concurrent-queue :capacity 64))
+             (nitems 10000)
+             (producers
+               (loop for p below 3
+                     collect (let ((p p))
+                               (mp:process-run-function
+                                nil
+                                (lambda ()
+                                  (loop for i below nitems
+                                        do (loop until (mp:concurrent-queue-push
+                                                        q (+ (* p nitems) i)))))))))
+             (consumers
+               (loop repeat 3
+                     collect (mp:process-run-function
+                              nil
+                              (lambda ()
+                                (loop repeat nitems
+                                      sum (mp:concurrent-queue-pop q)))))))
+        (mapc #'mp:process-join producers)
+        (loop for c in consumers sum (values (mp:process-join c))))
+      (449985000))
+
+(defmacro with-test-executor ((var &rest options) &body body)
+  `(let ((,var (mp:make-executor ,@options)))
+     (unwind-protect (progn ,@body)
+       (mp:executor-shutdown ,var))))
+
+(test executor-submit
+      (with-test-executor (e :workers 2)
+        (values (mp:future-value (mp:submit e #'floor 17 5))
+                (mp:future-value (mp:submit e (lambda () 42)))))
+      (3 42))
+
+(test executor-special-bindings
+      (with-test-executor (e :workers 1)
+        (let ((*print-base* 16))
+          (mp:future-value (mp:submit e #'princ-to-string 255))))
+      ("FF"))
+
+(test-expect-error executor-condition
+      (with-test-executor (e :workers 1)
+        (mp:future-value (mp:submit e #'/ 1 (eval 0))))
+      :type division-by-zero)
+
+;;; Workers waiting on futures of their own executor must keep running
+;;; work, or this deadlocks with two workers.
+(defun executor-fib (e n)
+  (if (< n 2)
+      n
+      (let ((f (mp:submit e #'executor-fib e (- n 1))))
+        (+ (executor-fib e (- n 2)) (mp:future-value f)))))
+
+(test executor-nested
+      (with-test-executor (e :workers 2)
+        (mp:future-value (mp:submit e #'executor-fib e 15)))
+      (610))
+
+;;; A worker waiting on a future that another worker is running has
+;;; nothing to help with. It must still time out, and must wake up when
+;;; that future is settled.
+(test executor-wait-on-running
+      (with-test-executor (e :workers 2)
+        (let* ((started (mp:make-promise))
+               (release (mp:make-promise))
+               (running (mp:submit e (lambda ()
+                                       (mp:fulfill-promise started)
+                                       (mp:future-value release)
+                                       :done))))
+          (mp:future-wait started)
+          (mp:future-value
+           (mp:submit e (lambda ()
+                          (list (mp:future-wait running 0.05)
+                                (progn (mp:fulfill-promise release)
+                                       (mp:future-wait running 5))
+                                (mp:future-value running)))))))
+      ((nil t :done)))
+
+(test executor-promise
+      (let ((p (mp:make-promise)))
+        (mp:process-run-function nil (lambda () (mp:fulfill-promise p :a :b)))
+        (values (multiple-value-list (mp:future-value p))
+                (mp:future-done-p p)
+                (mp:future-wait (mp:make-promise) 0.01)))
+      ((:a :b) t nil))
+
+(test parallel-map-reduce
+      (with-test-executor (e :workers 3)
+        (values (mp:parallel-map 'list #'1+ '(1 2 3 4 5) :executor e :chunk-size 2)
+                (mp:parallel-reduce #'+ (loop for i below 1000 collect i)
+                                    :executor e :key #'1+)
+                (mp:parallel-reduce #'+ #() :executor e :initial-value 7)))
+      ((2 3 4 5 6) 500500 7))
+
+(defmacro with-test-fiber-scheduler ((var &rest options) &body body)
+  `(let ((,var (mp:make-fiber-scheduler ,@options)))
+     (unwind-protect (progn ,@body)
+       (mp:fiber-scheduler-shutdown ,var))))
+
+(test fiber-join
+      (with-test-fiber-scheduler (s :carriers 2)
+        (let ((f (mp:fiber-run-function "f" (lambda () (values 1 2)) :scheduler s)))
+          (values (multiple-value-list (mp:fiber-join f))
+                  (mp:fiber-state f))))
+      ((1 2) :finished))
+
+(test-expect-error fiber-condition
+      (with-test-fiber-scheduler (s :carriers 1)
+        (mp:fiber-join (mp:fiber-run-function "f" (lambda () (/ 1 (eval 0)))
+                                              :scheduler s)))
+      :type division-by-zero)
+
+;;; Two fibers on one carrier only interleave if they yield.
+(test fiber-yield
+      (with-test-fiber-scheduler (s :carriers 1)
+        (let* ((trace nil)
+               (lock (mp:make-lock :name "trace"))
+               (fibers (loop for name in '(:a :b)
+                             collect (let ((name name))
+                                       (mp:fiber-run-function
+                                        name
+                                        (lambda ()
+                                          (dotimes (i 2)
+                                            (mp:with-lock (lock) (push name trace))
+                                            (mp:fiber-yield)))
+                                        :scheduler s)))))
+          (mapc #'mp:fiber-join fibers)
+          (reverse trace)))
+      ((:a :b :a :b)))
+
+(test fiber-park-unpark
+      (with-test-fiber-scheduler (s :carriers 2)
+        (let* ((f (mp:fiber-run-function "parker"
+                                         (lambda ()
+                                           (values (mp:fiber-park)
+                                                   (mp:fiber-park 0.01)))
+                                         :scheduler s)))
+          (mp:fiber-unpark f)
+          (multiple-value-list (mp:fiber-join f))))
+      ((t nil)))
+
+(test fiber-sleep
+      (with-test-fiber-scheduler (s :carriers 1)
+        (let* ((start (get-internal-real-time))
+               (fibers (loop repeat 20
+                             collect (mp:fiber-run-function
+                                      "sleeper" (lambda () (mp:fiber-sleep 0.2))
+                                      :scheduler s))))
+          (mapc #'mp:fiber-join fibers)
+          ;; The sleeps overlap on the one carrier.
+          (< (- (get-internal-real-time) start)
+             (* 2 internal-time-units-per-second))))
+      (t))
+
+(test fiber-many
+      (with-test-fiber-scheduler (s :carriers 4)
+        (let ((fibers (loop for i below 2000
+                            collect (let ((i i))
+                                      (mp:fiber-run-function
+                                       nil (lambda () (mp:fiber-yield) i)
+                                       :scheduler s)))))
+          (loop for f in fibers sum (mp:fiber-join f))))
+      (1999000))
+
+(test lock-contention-report
+      (unwind-protect
+           (let ((lock (mp:make-lock :name "CONTEND"))
+                 (process nil))
+             (mp:reset-lock-contention-profile)
+             (mp:start-lock-contention-profiling :sample-interval 1)
+             (mp:with-lock (lock)
+               (setf process (mp:process-run-function
+                              nil (lambda () (mp:with-lock (lock) nil))))
+               (sleep 0.2))
+             (mp:process-join process)
+             (let ((entry (find "CONTEND" (mp:lock-contention-report)
+                                :key (lambda (entry) (getf entry :name))
+                                :test #'string=)))
+               (values (getf entry :acquisitions)
+                       (getf entry :contended)
+                       (plusp (getf entry :total-wait)))))
+        (mp:stop-lock-contention-profiling))
+      (2 1 t))
+
+(test jit-compile-concurrently
+      (unwind-protect
+           (progn
+             (ext:start-jit-compile-threads 2)
+             (let ((processes
+                     (loop for i below 4
+                           collect (let ((i i))
+                                     (mp:process-run-function
+                                      nil (lambda ()
+                                            (funcall (compile nil `(lambda (x) (+ x ,i)))
+                                                     10)))))))
+               (loop for p in processes sum (mp:process-join p))))
+        (ext:stop-jit-compile-threads))
+      (46))
+
+;;; A JIT compile process that is killed must stop counting as a worker,
+;;; or modules would be queued for nobody to compile.
+(test jit-compile-worker-killed
+      (unwind-protect
+           (progn
+             (ext:start-jit-compile-threads 2)
+             (let ((victim (first clasp-cleavir::*jit-compile-processes*)))
+               (mp:process-kill victim)
+               (handler-case (mp:process-join victim)
+                 (mp:process-join-error ())))
+             (values (llvm-sys:jit-task-workers)
+                     (funcall (compile nil '(lambda (x) (* x 3))) 5)))
+        (ext:stop-jit-compile-threads))
+      (1 15))
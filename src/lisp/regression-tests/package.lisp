@@ -593,3 +593,25 @@
              (member s2 (package-shadowing-symbols chil))))
   (delete-package chil)
   (delete-package par0) (delete-package par1) (delete-package par2))
+
+;;; find-symbol and intern of existing symbols don't take the package
+;;; lock, so make sure readers see every symbol while others are interned.
+(test-true package-concurrent-find-symbol
+           (let ((pkg (make-package (gensym "CONCURRENT-FIND-SYMBOL") :use nil)))
+             (unwind-protect
+                  (let ((existing (loop for i below 1000
+                                        collect (intern (format nil "S~d" i) pkg))))
+                    (let ((writer (mp:process-run-function
+                                   nil (lambda ()
+                                         (loop for i from 1000 below 20000
+                                               do (intern (format nil "S~d" i) pkg)))))
+                          (readers (loop repeat 4
+                                         collect (mp:process-run-function
+                                                  nil (lambda ()
+                                                        (loop repeat 10
+                                                              always (loop for sym in existing
+                                                                           always (and (eq (find-symbol (symbol-name sym) pkg) sym)
+                                                                                       (eq (intern (symbol-name sym) pkg) sym)))))))))
+                      (mp:process-join writer)
+                      (every #'mp:process-join readers)))
+               (delete-package pkg))))
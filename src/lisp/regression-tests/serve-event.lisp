@@ -0,0 +1,76 @@
+(in-package #:clasp-tests)
+
+(eval-when (:compile-toplevel :load-toplevel :execute)
+  (require :serve-event))
+
+;;; Count the calls of a handler for DIRECTION on FD.
+(defun counting-fd-handler (fd direction counter &rest keys)
+  (apply #'serve-event:add-fd-handler fd direction
+         (lambda (fd) (declare (ignore fd)) (incf (car counter)))
+         keys))
+
+;;; epoll refuses regular files; they are always usable, as with select.
+#+linux
+(test serve-event-epoll-regular-file
+      (let ((serve-event:*serve-event-backend* :epoll)
+            (calls (list 0)))
+        (with-open-file (stream "sys:src;lisp;regression-tests;run-all.lisp")
+          (let ((handler (counting-fd-handler
+                          (gray:stream-file-descriptor stream :input) :input calls)))
+            (unwind-protect
+                 (list (serve-event:serve-event 0)
+                       (serve-event:serve-event 0)
+                       (car calls))
+              (serve-event:remove-fd-handler handler)))))
+      ((t t 2)))
+
+;;; A descriptor closed without removing its handler leaves a stale entry;
+;;; its number being reused must not stop new handlers from registering.
+#+linux
+(test serve-event-epoll-fd-reuse
+      (let ((serve-event:*serve-event-backend* :epoll)
+            (stale-calls (list 0))
+            (calls (list 0)))
+        (multiple-value-bind (in out) (core:pipe)
+          (let ((stale (counting-fd-handler out :output stale-calls)))
+            (core:close-fd in)
+            (core:close-fd out)
+            (multiple-value-bind (new-in new-out) (core:pipe)
+              (let ((handler (counting-fd-handler new-out :output calls)))
+                (unwind-protect
+                     (list (= new-out out)
+                           (serve-event:serve-event 0)
+                           (car calls))
+                  (serve-event:remove-fd-handler handler)
+                  (serve-event:remove-fd-handler stale)
+                  (core:close-fd new-in)
+                  (core:close-fd new-out)))))))
+      ((t t 1)))
+
+;;; The registration is only edge triggered while every handler of the
+;;; descriptor is. A pipe's write end stays writable, so it is reported
+;;; on every call until only the edge triggered handler is left.
+#+linux
+(test serve-event-epoll-mixed-triggers
+      (let ((serve-event:*serve-event-backend* :epoll)
+            (edge-calls (list 0))
+            (level-calls (list 0)))
+        (multiple-value-bind (in out) (core:pipe)
+          (let ((edge (counting-fd-handler out :output edge-calls :edge-triggered t))
+                (level (counting-fd-handler out :output level-calls)))
+            (unwind-protect
+                 (list (serve-event:serve-event 0)
+                       (serve-event:serve-event 0)
+                       (car edge-calls)
+                       (car level-calls)
+                       (progn (serve-event:remove-fd-handler level)
+                              (setf level nil)
+                              ;; Changing the registration reports it once more.
+                              (serve-event:serve-event 0))
+                       (serve-event:serve-event 0)
+                       (car edge-calls))
+              (serve-event:remove-fd-handler edge)
+              (when level (serve-event:remove-fd-handler level))
+              (core:close-fd in)
+              (core:close-fd out)))))
+      ((t t 2 2 t nil 3)))
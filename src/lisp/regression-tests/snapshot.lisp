@@ -60,3 +60,34 @@
                 (write-string (get-output-stream-string ostream) *error-output*)
                 (values dump-code nil)))))
       (0 90))
+
+#+use-precise-gc
+(test slad-compressed-snapshot
+      (let ((binary (ext:argv 0))
+            (snap-fname
+              (namestring
+               (translate-logical-pathname "sys:src;lisp;regression-tests;testcsnap")))
+            (ostream (make-string-output-stream)))
+        (multiple-value-bind (stream dump-code)
+            (ext:run-program binary
+                             (list "--norc" "--base" "--feature" "ignore-extensions"
+                                   "--eval" "(defparameter *foo* 91)"
+                                   "--eval"
+                                   (format nil "(ext:save-lisp-and-die \"~a\" :compress t)" snap-fname))
+                             :output ostream)
+          (declare (ignore stream))
+          (if (eql dump-code 0)
+              (multiple-value-bind (stream code)
+                  (ext:run-program binary
+                                   (list "--snapshot" (format nil "~a" snap-fname)
+                                         "--eval" "(ext:quit *foo*)")
+                                   :output ostream)
+                (declare (ignore stream))
+                (unless (eql code 91)
+                  (write-string (get-output-stream-string ostream) *error-output*))
+                (delete-file snap-fname)
+                (values dump-code code))
+              (progn
+                (write-string (get-output-stream-string ostream) *error-output*)
+                (values dump-code nil)))))
+      (0 91))
@@ -834,3 +834,74 @@ cd")))
    ((:utf-8 :lf) #\! #\newline
     (:utf-8 :crlf) #\! #\newline
     :ucs-2be #\trade_mark_sign (:ucs-2be :crlf))))
+
+(test file-stream-bulk-read.01
+  (let ((name (core:mkstemp "bulk-read"))
+        (long (make-string 5000 :initial-element #\a)))
+    (unwind-protect
+         (progn
+           (with-open-file (stream name :if-does-not-exist :create
+                                        :if-exists :supersede
+                                        :direction :output
+                                        :external-format :utf-8)
+             (write-line long stream)
+             (write-line "tab	bed" stream)
+             (write-line "café ok" stream)
+             (write-string "last" stream))
+           (with-open-file (stream name :direction :input
+                                        :external-format :utf-8)
+             (list (string= (read-line stream) long)
+                   (file-position stream)
+                   (peek-char nil stream)
+                   (read-line stream)
+                   (read-line stream)
+                   (let ((buffer (make-string 3)))
+                     (list (read-sequence buffer stream) buffer))
+                   (multiple-value-list (read-line stream))
+                   (read-line stream nil :eof))))
+      (delete-file name)))
+  ((t 5001 #\t "tab	bed" "café ok" (3 "las") ("t" t) :eof)))
+
+(test mmap-file-stream.01
+  (let ((name (core:mkstemp "mmap-stream")))
+    (unwind-protect
+         (progn
+           (with-open-file (stream name :if-does-not-exist :create
+                                        :if-exists :supersede
+                                        :direction :output
+                                        :element-type '(unsigned-byte 8))
+             (write-sequence (coerce (loop for i below 300 collect (mod i 256))
+                                     '(vector (unsigned-byte 8)))
+                             stream))
+           (with-open-file (stream name :element-type '(unsigned-byte 8) :mmap t)
+             (let ((buffer (make-array 4 :element-type '(unsigned-byte 8))))
+               (list (file-length stream)
+                     (read-byte stream)
+                     (progn (file-position stream 254)
+                            (read-sequence buffer stream))
+                     buffer
+                     (file-position stream)
+                     (coerce (core:mmap-file-stream-octets stream 10 13) 'list)
+                     (progn (file-position stream :end)
+                            (read-byte stream nil :eof))))))
+      (delete-file name)))
+  ((300 0 4 #(254 255 0 1) 258 (10 11 12) :eof)))
+
+(test mmap-file-stream.02
+  (let ((name (core:mkstemp "mmap-stream")))
+    (unwind-protect
+         (progn
+           (with-open-file (stream name :if-does-not-exist :create
+                                        :if-exists :supersede
+                                        :direction :output)
+             (write-line "first" stream)
+             (write-string "second" stream))
+           (with-open-file (stream name :mmap t)
+             (list (read-line stream)
+                   (read-char stream)
+                   (progn (unread-char #\s stream)
+                          (file-position stream))
+                   (read-line stream nil :eof)
+                   (read-line stream nil :eof))))
+      (delete-file name)))
+  (("first" #\s 6 "second" :eof)))
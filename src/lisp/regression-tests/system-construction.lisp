@@ -32,3 +32,72 @@
           (*standard-output*)
         (compile-file "sys:src;lisp;regression-tests;framework.lisp" :verbose nil :print nil))
       (""))
+
+;;; A parallel faso holds one object file per toplevel form; batch linking
+;;; must still run their startup code in order.
+(test faso-batch-link
+ (let* ((cmp::*compile-file-parallel* t)
+        (cmp:*default-output-type* :faso)
+        (file "sys:src;lisp;regression-tests;test-faso-batch-link.lisp")
+        (fasl (compile-file file :output-file (make-pathname :type "battest" :defaults file)
+                                 :verbose nil :print nil)))
+   (unwind-protect
+        (flet ((load-order (batch-link-p)
+                 (let ((core:*faso-batch-link* batch-link-p))
+                   (makunbound 'cl-user::*batch-link-order*)
+                   (fmakunbound 'cl-user::batch-link-next)
+                   (load fasl)
+                   (symbol-value 'cl-user::*batch-link-order*))))
+          (values (load-order t) (load-order nil)))
+     (delete-file fasl)))
+ ((1 2 3) (1 2 3)))
+
+;;; Remove DIRECTORY, a flat scratch directory that a test wrote files into.
+(defun delete-scratch-directory (directory)
+  (mapc #'delete-file (directory (merge-pathnames "*.*" directory)))
+  (when (probe-file directory)
+    (core:rmdir directory)))
+
+(test jit-object-cache
+ (let ((directory (format nil "/tmp/clasp-jit-cache-~d/" (core:getpid)))
+       (previous (llvm-sys:jit-object-cache-directory)))
+   (unwind-protect
+        (multiple-value-bind (hits misses stores)
+            (llvm-sys:jit-object-cache-statistics)
+          (declare (ignore hits))
+          (llvm-sys:set-jit-object-cache-directory directory)
+          (values (funcall (compile nil '(lambda (x) (* x 6))) 7)
+                  (multiple-value-bind (new-hits new-misses new-stores)
+                      (llvm-sys:jit-object-cache-statistics)
+                    (declare (ignore new-hits))
+                    (and (> new-misses misses) (> new-stores stores)))
+                  (not (null (directory (merge-pathnames "*.o" directory))))
+                  ;; Compiled again, the same code gets a new startup ID,
+                  ;; which must not keep it from being found.
+                  (let* ((hits (llvm-sys:jit-object-cache-statistics))
+                         (again (compile nil '(lambda (x) (* x 6)))))
+                    (list (funcall again 8)
+                          (> (llvm-sys:jit-object-cache-statistics) hits)))))
+     (llvm-sys:set-jit-object-cache-directory previous)
+     (delete-scratch-directory directory)))
+ (42 t t (48 t)))
+
+#+linux
+(test jitdump-file
+ (let ((directory (format nil "/tmp/clasp-jitdump-~d/" (core:getpid))))
+   (ensure-directories-exist directory)
+   (unwind-protect
+        (progn
+          (unwind-protect
+               (progn
+                 (llvm-sys:start-jitdump directory)
+                 (funcall (compile nil '(lambda () 42))))
+            (llvm-sys:stop-jitdump))
+          ;; The magic is written in host byte order; these are the
+          ;; octets of #x4A695444 on a little-endian host.
+          (with-open-file (stream (format nil "~ajit-~d.dump" directory (core:getpid))
+                                  :element-type '(unsigned-byte 8))
+            (values (loop repeat 4 collect (read-byte stream))
+                    (> (file-length stream) 40))))
+     (delete-scratch-directory directory)))
+ ((#x44 #x54 #x69 #x4A) t))
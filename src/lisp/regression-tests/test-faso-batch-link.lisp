@@ -0,0 +1,17 @@
+(in-package :cl-user)
+
+;;; Compiled and loaded by the faso-batch-link test. Every toplevel form
+;;; depends on the ones before it having run.
+
+(defparameter *batch-link-order* nil)
+
+(push 1 *batch-link-order*)
+
+(defun batch-link-next ()
+  (1+ (first *batch-link-order*)))
+
+(push (batch-link-next) *batch-link-order*)
+
+(push (batch-link-next) *batch-link-order*)
+
+(setf *batch-link-order* (reverse *batch-link-order*))
@@ -0,0 +1,71 @@
+;;; Measure how long the garbage collector stops the world while threads
+;;; allocate and mutate an old heap.  Run it once as is and once with
+;;; CLASP_GC_INCREMENTAL=1 (optionally CLASP_GC_PAUSE_MS) to compare full
+;;; and incremental collection, e.g.
+;;;   (load "sys:src;lisp;regression-tests;time-gc-pauses.lisp")
+;;;   (run-all)
+
+(defclass node ()
+  ((left :initarg :left :accessor node-left)
+   (right :initarg :right :accessor node-right)
+   (payload :initarg :payload :accessor node-payload)))
+
+(defun make-old-heap (n)
+  "Return a hash table of N nodes and a vector of the same nodes, to be kept
+alive across the run."
+  (let ((table (make-hash-table :size n :thread-safe t))
+        (nodes (make-array n)))
+    (dotimes (i n)
+      (let ((node (make-instance 'node :left nil :right nil :payload (list i))))
+        (setf (gethash i table) node
+              (svref nodes i) node)))
+    (values table nodes)))
+
+(defun churn (table nodes seconds)
+  "Allocate short lived lists and store some of them into old nodes, hash
+table entries and vector slots for SECONDS.  Return the longest gap, in
+seconds, between two iterations, which is the longest the thread was held
+up by the collector."
+  (let* ((n (length nodes))
+         (end (+ (get-internal-real-time) (* seconds internal-time-units-per-second)))
+         (last (get-internal-real-time))
+         (max-gap 0)
+         (state (make-random-state t)))
+    (loop for now = (get-internal-real-time)
+          while (< now end)
+          do (setf max-gap (max max-gap (- now last))
+                   last now)
+             (let ((garbage (make-list 64 :initial-element now))
+                   (node (svref nodes (random n state))))
+               (setf (node-payload node) (list (length garbage))
+                     (node-left node) (svref nodes (random n state)))
+               (setf (gethash (random n state) table) node)
+               (setf (svref nodes (random n state)) node)))
+    (/ max-gap internal-time-units-per-second 1d0)))
+
+(defun time-gc-pauses (nthreads &key (nodes 200000) (seconds 5))
+  (multiple-value-bind (table vector)
+      (make-old-heap nodes)
+    (gctools:garbage-collect)
+    (gctools:reset-gc-pause-statistics)
+    (let* ((threads (loop repeat nthreads
+                          collect (mp:process-run-function
+                                   'churn (lambda () (churn table vector seconds)))))
+           (gaps (mapcar #'mp:process-join threads))
+           (stats (gctools:gc-pause-statistics)))
+      (format t "~d threads: ~d pauses, max ~,2f ms, mean ~,2f ms, ~,2f ms total; longest mutator gap ~,2f ms~%"
+              nthreads (getf stats :pauses)
+              (* 1000 (getf stats :max-pause))
+              (if (plusp (getf stats :pauses))
+                  (/ (* 1000 (getf stats :total-pause)) (getf stats :pauses))
+                  0)
+              (* 1000 (getf stats :total-pause))
+              (* 1000 (reduce #'max gaps)))
+      stats)))
+
+(defun run-all ()
+  (let ((stats (gctools:gc-pause-statistics)))
+    (format t "Incremental collection is ~:[off~;on~]~@[, using write protection~]~%"
+            (getf stats :incremental) (getf stats :write-protection)))
+  (dolist (nthreads '(1 2 4 8))
+    (time-gc-pauses nthreads)))
@@ -11,4 +11,5 @@
            #~"code.cc"
            #~"llvmoPackage.cc"
            #~"runtimeJit.cc"
+           #~"jitDump.cc"
            #~"clbindLlvmExpose.cc")
@@ -0,0 +1,316 @@
+/*
+    File: jitDump.cc
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+
+// Linux perf jitdump support.
+//
+// While jitdump is on, every object file the JIT links is written to
+// <dir>/jit-<pid>.dump as one JIT_CODE_DEBUG_INFO and one JIT_CODE_LOAD
+// record per function, carrying the relocated code bytes and the line
+// table of the function's DWARF.  The file is mapped executable once so
+// that perf record sees it; then
+//   perf record -k mono ... ; perf inject --jit -i perf.data -o perf.jit.data
+// turns the records into ELF images that perf report and perf annotate
+// can read.  Records for one object file are written and flushed together
+// under one lock, after linking, so symbols are not logged one by one.
+
+#include <clasp/core/foundation.h>
+#include <clasp/core/object.h>
+#include <clasp/core/lisp.h>
+#include <clasp/core/array.h>
+#include <clasp/core/pathname.h>
+#include <clasp/core/mpPackage.h>
+#include <clasp/llvmo/llvmoExpose.h>
+#include <clasp/llvmo/code.h>
+#include <clasp/llvmo/jit.h>
+#include <clasp/core/wrappers.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Object/SymbolSize.h>
+#include <llvm/DebugInfo/DWARF/DWARFContext.h>
+#if defined(_TARGET_OS_LINUX)
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace llvmo {
+
+std::atomic<bool> global_jitdump;
+
+#if defined(_TARGET_OS_LINUX)
+
+namespace jitdump {
+
+const uint32_t Magic = 0x4A695444;
+const uint32_t Version = 1;
+const uint32_t CodeLoad = 0;
+const uint32_t DebugInfo = 2;
+
+struct FileHeader {
+  uint32_t _Magic;
+  uint32_t _Version;
+  uint32_t _TotalSize;
+  uint32_t _ElfMach;
+  uint32_t _Pad1;
+  uint32_t _Pid;
+  uint64_t _Timestamp;
+  uint64_t _Flags;
+};
+
+struct RecordHeader {
+  uint32_t _Id;
+  uint32_t _TotalSize;
+  uint64_t _Timestamp;
+};
+
+struct CodeLoadRecord {
+  RecordHeader _Header;
+  uint32_t _Pid;
+  uint32_t _Tid;
+  uint64_t _Vma;
+  uint64_t _CodeAddr;
+  uint64_t _CodeSize;
+  uint64_t _CodeIndex;
+  // Followed by the name, NUL terminated, and then the code
+};
+
+struct DebugInfoRecord {
+  RecordHeader _Header;
+  uint64_t _CodeAddr;
+  uint64_t _NrEntry;
+  // Followed by _NrEntry DebugEntry
+};
+
+struct DebugEntry {
+  uint64_t _Addr;
+  int32_t _Lineno;
+  int32_t _Discrim;
+  // Followed by the file name, NUL terminated
+};
+
+}; // namespace jitdump
+
+struct JitDumpFile {
+  mp::Mutex _Mutex;
+  std::string _Directory;
+  FILE* _Stream = NULL;
+  void* _Marker = NULL;
+  int _Pid = -1;
+  uint64_t _CodeIndex = 0;
+};
+
+static JitDumpFile global_jitdump_file;
+
+// perf matches jitdump timestamps against samples taken with -k mono
+static uint64_t jitdump_timestamp() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static uint32_t jitdump_elf_mach() {
+#if defined(__x86_64__)
+  return EM_X86_64;
+#elif defined(__aarch64__)
+  return EM_AARCH64;
+#else
+  return EM_NONE;
+#endif
+}
+
+static void jitdump_close(JitDumpFile& jd) {
+  if (jd._Marker)
+    munmap(jd._Marker, getpagesize());
+  if (jd._Stream)
+    fclose(jd._Stream);
+  jd._Marker = NULL;
+  jd._Stream = NULL;
+  jd._Pid = -1;
+}
+
+// Open the dump of this process, after a fork a new one. Called with the lock held.
+static bool jitdump_ensure_open(JitDumpFile& jd) {
+  int pid = getpid();
+  if (jd._Stream && jd._Pid == pid)
+    return true;
+  if (jd._Stream)
+    jitdump_close(jd); // Inherited from our parent; it keeps writing its own file
+  std::string filename = fmt::format("{}/jit-{}.dump", jd._Directory, pid);
+  int fd = open(filename.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0666);
+  if (fd < 0) {
+    fprintf(stderr, "%s:%d Could not open jitdump file %s: %s\n", __FILE__, __LINE__, filename.c_str(), strerror(errno));
+    return false;
+  }
+  // perf record notices the dump by this executable mapping of it
+  jd._Marker = mmap(NULL, getpagesize(), PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+  if (jd._Marker == MAP_FAILED) {
+    jd._Marker = NULL;
+    close(fd);
+    fprintf(stderr, "%s:%d Could not mmap jitdump file %s: %s\n", __FILE__, __LINE__, filename.c_str(), strerror(errno));
+    return false;
+  }
+  jd._Stream = fdopen(fd, "w");
+  jd._Pid = pid;
+  jd._CodeIndex = 0;
+  jitdump::FileHeader header = {jitdump::Magic, jitdump::Version, sizeof(jitdump::FileHeader), jitdump_elf_mach(), 0,
+                                (uint32_t)pid, jitdump_timestamp(), 0};
+  fwrite(&header, sizeof(header), 1, jd._Stream);
+  fflush(jd._Stream);
+  return true;
+}
+
+struct JitDumpFunction {
+  std::string _Name;
+  uintptr_t _Address;
+  size_t _Size;
+  llvm::DILineInfoTable _Lines;
+};
+
+static void jitdump_write_function(JitDumpFile& jd, const JitDumpFunction& fn, uint32_t tid) {
+  uint64_t timestamp = jitdump_timestamp();
+  if (!fn._Lines.empty()) {
+    size_t size = sizeof(jitdump::DebugInfoRecord);
+    for (auto& line : fn._Lines)
+      size += sizeof(jitdump::DebugEntry) + line.second.FileName.size() + 1;
+    jitdump::DebugInfoRecord record = {{jitdump::DebugInfo, (uint32_t)size, timestamp}, fn._Address, fn._Lines.size()};
+    fwrite(&record, sizeof(record), 1, jd._Stream);
+    for (auto& line : fn._Lines) {
+      jitdump::DebugEntry entry = {line.first, (int32_t)line.second.Line, (int32_t)line.second.Discriminator};
+      fwrite(&entry, sizeof(entry), 1, jd._Stream);
+      fwrite(line.second.FileName.c_str(), line.second.FileName.size() + 1, 1, jd._Stream);
+    }
+  }
+  size_t size = sizeof(jitdump::CodeLoadRecord) + fn._Name.size() + 1 + fn._Size;
+  jitdump::CodeLoadRecord record = {
+      {jitdump::CodeLoad, (uint32_t)size, timestamp}, (uint32_t)jd._Pid, tid, fn._Address, fn._Address, fn._Size, jd._CodeIndex++};
+  fwrite(&record, sizeof(record), 1, jd._Stream);
+  fwrite(fn._Name.c_str(), fn._Name.size() + 1, 1, jd._Stream);
+  fwrite((const void*)fn._Address, fn._Size, 1, jd._Stream);
+}
+
+void jitdump_object_file(ObjectFile_sp code, llvm::object::ObjectFile& of) {
+  if (!global_jitdump.load(std::memory_order_relaxed) || !code->_TextSectionStart)
+    return;
+  // Gather the functions and their line tables before taking the lock
+  std::vector<JitDumpFunction> functions;
+  std::unique_ptr<llvm::DWARFContext> dwarf = llvm::DWARFContext::create(of);
+  llvm::DILineInfoSpecifier spec(llvm::DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath,
+                                 llvm::DILineInfoSpecifier::FunctionNameKind::None);
+  for (auto& symSize : llvm::object::computeSymbolSizes(of)) {
+    llvm::object::SymbolRef sym = symSize.first;
+    auto type = sym.getType();
+    if (!type) {
+      llvm::consumeError(type.takeError());
+      continue;
+    }
+    if (*type != llvm::object::SymbolRef::ST_Function || symSize.second == 0)
+      continue;
+    auto section = sym.getSection();
+    if (!section) {
+      llvm::consumeError(section.takeError());
+      continue;
+    }
+    if (*section == of.section_end() || (*section)->getIndex() != code->_TextSectionId)
+      continue;
+    auto name = sym.getName();
+    auto address = sym.getAddress();
+    if (!name || !address) {
+      if (!name)
+        llvm::consumeError(name.takeError());
+      if (!address)
+        llvm::consumeError(address.takeError());
+      continue;
+    }
+    // Offsets in the text section are the same in the object file and in memory,
+    // which is also what backtraces rely on.
+    uint64_t offset = *address - (*section)->getAddress();
+    JitDumpFunction fn;
+    fn._Name = name->str();
+    fn._Address = (uintptr_t)code->_TextSectionStart + offset;
+    fn._Size = symSize.second;
+    fn._Lines = dwarf->getLineInfoForAddressRange({offset, code->_TextSectionId}, fn._Size, spec);
+    for (auto& line : fn._Lines)
+      line.first += (uintptr_t)code->_TextSectionStart;
+    functions.push_back(std::move(fn));
+  }
+  if (functions.empty())
+    return;
+  uint32_t tid = (uint32_t)syscall(SYS_gettid);
+  RAIILock lock(global_jitdump_file._Mutex);
+  if (!global_jitdump.load(std::memory_order_relaxed) || !jitdump_ensure_open(global_jitdump_file))
+    return;
+  for (auto& fn : functions)
+    jitdump_write_function(global_jitdump_file, fn, tid);
+  fflush(global_jitdump_file._Stream);
+}
+
+void jitdump_start(const std::string& directory) {
+  RAIILock lock(global_jitdump_file._Mutex);
+  if (global_jitdump_file._Stream && global_jitdump_file._Directory != directory)
+    jitdump_close(global_jitdump_file);
+  global_jitdump_file._Directory = directory;
+  global_jitdump.store(true);
+}
+
+void jitdump_stop() {
+  RAIILock lock(global_jitdump_file._Mutex);
+  global_jitdump.store(false);
+  if (global_jitdump_file._Pid == getpid())
+    jitdump_close(global_jitdump_file);
+}
+
+#else
+
+void jitdump_object_file(ObjectFile_sp code, llvm::object::ObjectFile& of) {}
+
+void jitdump_start(const std::string& directory) { SIMPLE_ERROR("jitdump is only supported on Linux"); }
+
+void jitdump_stop() {}
+
+#endif
+
+CL_LAMBDA(&optional directory);
+CL_DOCSTRING(R"dx(Write the code and line tables of every function the JIT links from now on to
+DIRECTORY/jit-<pid>.dump in the Linux perf jitdump format. DIRECTORY defaults to the
+JITDUMPDIR environment variable or /tmp. Record with perf record -k mono and then run
+perf inject --jit to annotate JITted code. CLASP_JITDUMP=1 in the environment starts this at startup.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void llvm_sys__start_jitdump(core::T_sp directory) {
+  std::string dir;
+  if (directory.notnilp())
+    dir = gc::As<core::String_sp>(core::cl__namestring(directory))->get_std_string();
+  else if (const char* env = getenv("JITDUMPDIR"))
+    dir = env;
+  else
+    dir = "/tmp";
+  jitdump_start(dir);
+}
+
+CL_DOCSTRING(R"dx(Stop writing jitdump records and close the jitdump file.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void llvm_sys__stop_jitdump() { jitdump_stop(); }
+
+}; // namespace llvmo
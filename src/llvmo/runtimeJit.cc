@@ -9,7 +9,12 @@
 #include <dlfcn.h>
 #include <iomanip>
 #include <string>
+#include <deque>
 #include <llvm/Config/llvm-config.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/ADT/StringExtras.h>
 #if LLVM_VERSION_MAJOR < 18
 #include <llvm/ExecutionEngine/Orc/DebuggerSupportPlugin.h>
 #else
@@ -19,10 +24,13 @@
 #include <clasp/core/foundation.h>
 #include <clasp/core/object.h>
 #include <clasp/core/cons.h>
+#include <clasp/core/pathname.h>
 #include <clasp/core/mpPackage.h>
+#include <clasp/gctools/interrupt.h>
 #include <clasp/llvmo/code.h>
 #include <clasp/gctools/snapshotSaveLoad.h>
 #include <clasp/llvmo/jit.h>
+#include <version.h>
 
 //
 // The include for Debug.h must be first so we can force NDEBUG undefined
@@ -342,6 +350,8 @@ public:
 
 namespace llvmo {
 
+static void restore_cached_names(jitlink::LinkGraph& G);
+
 class ClaspPlugin : public llvm::orc::ObjectLinkingLayer::Plugin {
   void modifyPassConfig(llvm::orc::MaterializationResponsibility& MR, llvm::jitlink::LinkGraph& G,
                         llvm::jitlink::PassConfiguration& Config) {
@@ -361,6 +371,11 @@ class ClaspPlugin : public llvm::orc::ObjectLinkingLayer::Plugin {
         }
         return Error::success();
       });
+    // Before anything looks symbols up by name
+    Config.PrePrunePasses.insert(Config.PrePrunePasses.begin(), [](jitlink::LinkGraph& G) -> Error {
+      restore_cached_names(G);
+      return Error::success();
+    });
     Config.PrePrunePasses.push_back([this](jitlink::LinkGraph& G) -> Error {
       size_t count = 0;
       for (auto& Sec : G.sections()) {
@@ -465,6 +480,7 @@ class ClaspPlugin : public llvm::orc::ObjectLinkingLayer::Plugin {
     uintptr_t textEnd = 0;
     ObjectFile_sp currentCode = lookupObjectFile(G.getName());
     DEBUG_OBJECT_FILES_PRINT(("%s:%d:%s     currentCode: %p\n", __FILE__, __LINE__, __FUNCTION__, &*currentCode));
+    std::vector<core::JITLogSymbol> logSymbols;
     for (auto& S : G.sections()) {
       DEBUG_OBJECT_FILES_PRINT(
           ("%s:%d:%s  section: %s getOrdinal->%u \n", __FILE__, __LINE__, __FUNCTION__, S.getName().str().c_str(), S.getOrdinal()));
@@ -509,12 +525,11 @@ class ClaspPlugin : public llvm::orc::ObjectLinkingLayer::Plugin {
                  currentCode->_TextSectionEnd );
         }
 #endif
-        for (auto& sym : S.symbols()) {
-          if (sym->isCallable() && sym->hasName()) {
-            std::string name = sym->getName().str();
-            void* address = (void*)sym->getAddress().getValue();
-            size_t size = sym->getSize();
-            core::core__jit_register_symbol(name, size, (void*)address);
+        if (core::global_jit_log_symbols) {
+          for (auto& sym : S.symbols()) {
+            if (sym->isCallable() && sym->hasName()) {
+              logSymbols.push_back({sym->getName().str(), (size_t)sym->getSize(), (void*)sym->getAddress().getValue()});
+            }
           }
         }
       } else if (sectionName.find(EH_FRAME_NAME) != string::npos) {
@@ -529,6 +544,7 @@ class ClaspPlugin : public llvm::orc::ObjectLinkingLayer::Plugin {
         currentCode->_StackmapSize = (size_t)range.getSize();
       }
     }
+    core::jit_register_symbols(logSymbols);
     // Keep track of the executable region
     if (textStart) {
       //      printf("%s:%d:%s  textStart %p - textStop %p\n", __FILE__, __LINE__, __FUNCTION__, (void*)textStart, (void*)textEnd );
@@ -681,25 +697,372 @@ class ClaspPlugin : public llvm::orc::ObjectLinkingLayer::Plugin {
 
 namespace llvmo {
 
-/*! Call this after fork() to create a thread-pool for lljit
- */
-CL_DEFUN void llvm_sys__create_lljit_thread_pool() {
-#if 0
-  gctools::global_thread_pool = new thread_pool<ThreadManager>(thread_pool<ThreadManager>::sane_number_of_threads());
-  ClaspJIT_O* jit = &*gctools::As<ClaspJIT_sp>(_lisp->_Roots._ClaspJIT);
-  jit->_LLJIT->getExecutionSession().setDispatchTask([jit](std::unique_ptr<Task> T) {
-    DEBUG_OBJECT_FILES_PRINT(("%s:%d:%s pushing an LLJIT task\n", __FILE__, __LINE__, __FUNCTION__ ));
-      // FIXME: We should be able to use move-capture here, but ThreadPool's
-      // AsyncTaskTys are std::functions rather than unique_functions
-      // (because MSVC's std::packaged_tasks don't support move-only types).
-      // Fix this when all the above gets sorted out.
-    global_thread_pool->push_task([UnownedT = T.release()]() mutable {
-      DEBUG_OBJECT_FILES_PRINT(("%s:%d:%s A task %p is running in the thread-pool\n", __FILE__, __LINE__, __FUNCTION__, UnownedT ));
-      std::unique_ptr<Task> T(UnownedT);
+/*! Runs the ORC materialization tasks of the ClaspJIT.
+    Until some Lisp process serves it with llvm-sys:jit-serve-tasks every task
+    runs in place on the thread that dispatched it, which is what happens
+    during startup and snapshot load.  Once there are workers, tasks are queued
+    and compiled and linked by them.  Workers are Lisp processes rather than
+    bare pool threads because linking allocates CodeBlocks and ObjectFiles. */
+class ClaspTaskDispatcher : public llvm::orc::TaskDispatcher {
+public:
+  mp::Mutex _Mutex;
+  mp::ConditionVariable _Available;
+  // Broadcast whenever a worker starts serving
+  mp::ConditionVariable _Joined;
+  std::deque<std::unique_ptr<Task>> _Tasks;
+  size_t _Workers = 0;
+  bool _Stopping = false;
+
+public:
+  void dispatch(std::unique_ptr<Task> T) override {
+    {
+      RAIILock lock(this->_Mutex);
+      if (this->_Workers > 0) {
+        this->_Tasks.push_back(std::move(T));
+        this->_Available.signal();
+        return;
+      }
+    }
+    T->run();
+  }
+
+  void shutdown() override { this->stop(); }
+
+  void stop() {
+    RAIILock lock(this->_Mutex);
+    if (this->_Workers > 0) {
+      this->_Stopping = true;
+      this->_Available.broadcast();
+    }
+  }
+
+  void waitForWorkers(size_t count) {
+    RAIILock lock(this->_Mutex);
+    while (this->_Workers < count)
+      this->_Joined.wait(this->_Mutex);
+  }
+
+  // Run tasks until stop() is called and the queue is drained.
+  void serve() {
+    {
+      RAIILock lock(this->_Mutex);
+      ++this->_Workers;
+      this->_Joined.broadcast();
+    }
+    try {
+      this->serveTasks();
+    } catch (...) {
+      // Unwound by an interrupt, say, or a task that signaled an error
+      this->leave();
+      throw;
+    }
+    this->leave();
+  }
+
+  void serveTasks() {
+    while (true) {
+      std::unique_ptr<Task> T;
+      {
+        RAIILock lock(this->_Mutex);
+        while (this->_Tasks.empty() && !this->_Stopping) {
+          if (!this->_Available.timed_wait(this->_Mutex, 0.5))
+            break;
+        }
+        if (!this->_Tasks.empty()) {
+          T = std::move(this->_Tasks.front());
+          this->_Tasks.pop_front();
+        } else if (this->_Stopping)
+          return;
+      }
+      if (T)
+        T->run();
+      gctools::handle_all_queued_interrupts();
+    }
+  }
+
+  // dispatch only queues tasks while there are workers, so the last one
+  // out runs whatever is left, and lets the next jit-serve-tasks start fresh.
+  void leave() {
+    std::deque<std::unique_ptr<Task>> orphans;
+    {
+      RAIILock lock(this->_Mutex);
+      if (--this->_Workers == 0) {
+        this->_Stopping = false;
+        orphans.swap(this->_Tasks);
+      }
+    }
+    for (auto& T : orphans)
       T->run();
-    });
-  } );
-#endif
+  }
+};
+
+// Owned by the ExecutorProcessControl of the ClaspJIT
+static ClaspTaskDispatcher* global_jit_dispatcher = NULL;
+
+CL_DOCSTRING(R"dx(Compile and link modules for the JIT until llvm-sys:jit-stop-serving-tasks is called.
+This is the function of each JIT compile process; while none are running, modules are compiled by the thread that looks them up.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void llvm_sys__jit_serve_tasks() {
+  if (!global_jit_dispatcher)
+    SIMPLE_ERROR("The JIT has not been created");
+  global_jit_dispatcher->serve();
+}
+
+CL_DOCSTRING(R"dx(Return the number of processes running llvm-sys:jit-serve-tasks.)dx");
+DOCGROUP(clasp);
+CL_DEFUN size_t llvm_sys__jit_task_workers() {
+  if (!global_jit_dispatcher)
+    return 0;
+  RAIILock lock(global_jit_dispatcher->_Mutex);
+  return global_jit_dispatcher->_Workers;
+}
+
+CL_DOCSTRING(R"dx(Wait until COUNT processes are running llvm-sys:jit-serve-tasks.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void llvm_sys__jit_wait_for_task_workers(size_t count) {
+  if (!global_jit_dispatcher)
+    SIMPLE_ERROR("The JIT has not been created");
+  global_jit_dispatcher->waitForWorkers(count);
+}
+
+CL_DOCSTRING(R"dx(Ask the processes running llvm-sys:jit-serve-tasks to finish the queued work and return.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void llvm_sys__jit_stop_serving_tasks() {
+  if (global_jit_dispatcher)
+    global_jit_dispatcher->stop();
+}
+
+/*! A content addressed cache of the object files compiled from IR modules.
+    addIRModule marks each module with its startup ID, and just before the
+    module is compiled prepareModule keys it by a hash of its bitcode, the
+    target and code generation settings, and the identity of this executable.
+    The names that embed the startup ID - which comes from a per-process
+    counter - are first replaced by stable ones, so the same code compiled
+    under another ID, here or in another process, has the same key. The key
+    is looked up on disk, and a fresh object file is stored under it, so
+    processes sharing the directory share the work. Either way the object
+    defines the stable names, and restore_cached_names renames them back
+    when it is linked. */
+class ClaspObjectCache : public llvm::ObjectCache {
+public:
+  mp::Mutex _Mutex;
+  std::string _Directory; // Empty when the cache is off
+  std::string _Settings;
+  // For each object file being compiled, the stable names it will define
+  // and the names they stand for.
+  std::map<std::string, std::vector<std::pair<std::string, std::string>>> _Renames;
+  std::atomic<size_t> _Hits{0};
+  std::atomic<size_t> _Misses{0};
+  std::atomic<size_t> _Stores{0};
+  // Set by prepareModule for the getObject and notifyObjectCompiled calls
+  // of the same compile, which happen on the same thread.
+  static thread_local std::string _PendingKey;
+  static constexpr const char* StartupIdMetadata = "clasp.object-cache-startup-id";
+
+public:
+  std::string directory() {
+    RAIILock lock(this->_Mutex);
+    return this->_Directory;
+  }
+
+  void setDirectory(const std::string& directory) {
+    if (directory != "") {
+      if (auto EC = llvm::sys::fs::create_directories(directory))
+        SIMPLE_ERROR("Could not create the JIT object cache directory {}: {}", directory, EC.message());
+    }
+    RAIILock lock(this->_Mutex);
+    this->_Directory = directory;
+  }
+
+  void noteModule(llvm::Module& M, size_t startupID) {
+    if (this->directory() == "")
+      return;
+    llvm::LLVMContext& context = M.getContext();
+    M.getOrInsertNamedMetadata(StartupIdMetadata)
+        ->addOperand(llvm::MDNode::get(context, llvm::MDString::get(context, std::to_string(startupID))));
+  }
+
+  void prepareModule(llvm::Module& M) {
+    _PendingKey.clear();
+    llvm::NamedMDNode* note = M.getNamedMetadata(StartupIdMetadata);
+    if (!note)
+      return;
+    std::string id = llvm::cast<llvm::MDString>(note->getOperand(0)->getOperand(0))->getString().str();
+    M.eraseNamedMetadata(note);
+    // The startup and shutdown functions and the gcroots are named by
+    // appending the ID. ID 0 is shared by modules without startup code.
+    std::vector<std::pair<std::string, std::string>> renames;
+    if (id != "0") {
+      for (llvm::GlobalValue& gv : M.global_values()) {
+        if (gv.isDeclaration() || !gv.hasName())
+          continue;
+        llvm::StringRef name = gv.getName();
+        if (name.size() <= id.size() || name.substr(name.size() - id.size()) != id || isdigit(name[name.size() - id.size() - 1]))
+          continue;
+        std::string original = name.str();
+        gv.setName(name.drop_back(id.size()) + "ID");
+        if (auto* function = llvm::dyn_cast<llvm::Function>(&gv))
+          if (llvm::DISubprogram* sp = function->getSubprogram())
+            if (sp->getLinkageName() == original)
+              sp->replaceLinkageName(llvm::MDString::get(M.getContext(), gv.getName()));
+        renames.emplace_back(gv.getName().str(), original);
+      }
+    }
+    // The module's own names come from counters too
+    std::string identifier = M.getModuleIdentifier();
+    std::string sourceFileName = M.getSourceFileName();
+    M.setModuleIdentifier("");
+    M.setSourceFileName("");
+    llvm::SmallVector<char, 0> bitcode;
+    llvm::raw_svector_ostream bs(bitcode);
+    llvm::WriteBitcodeToFile(M, bs);
+    bs << this->_Settings;
+    M.setModuleIdentifier(identifier);
+    M.setSourceFileName(sourceFileName);
+    auto digest = llvm::SHA1::hash(llvm::ArrayRef<uint8_t>((const uint8_t*)bitcode.data(), bitcode.size()));
+    _PendingKey = llvm::toHex(digest, true);
+    if (!renames.empty()) {
+      // Named as SimpleCompiler names the buffers it compiles, which is what the LinkGraph is named after
+      RAIILock lock(this->_Mutex);
+      this->_Renames[identifier + "-jitted-objectbuffer"] = std::move(renames);
+    }
+  }
+
+  void restoreNames(jitlink::LinkGraph& G) {
+    std::vector<std::pair<std::string, std::string>> renames;
+    {
+      RAIILock lock(this->_Mutex);
+      auto it = this->_Renames.find(G.getName());
+      if (it == this->_Renames.end())
+        return;
+      renames = std::move(it->second);
+      this->_Renames.erase(it);
+    }
+    for (auto* sym : G.defined_symbols()) {
+      if (!sym->hasName())
+        continue;
+      for (auto& [stable, original] : renames) {
+        // Allow for a global prefix such as MachO's underscore
+        llvm::StringRef prefix = sym->getName();
+        if (!prefix.consume_back(stable) || prefix.size() > 1)
+          continue;
+        std::string name = prefix.str() + original;
+        auto storage = G.allocateContent(llvm::ArrayRef<char>(name.data(), name.size()));
+        sym->setName(llvm::StringRef(storage.data(), storage.size()));
+        break;
+      }
+    }
+  }
+
+  std::string pathFor(const std::string& directory, const std::string& key) { return directory + "/" + key + ".o"; }
+
+  std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module* M) override {
+    if (_PendingKey == "")
+      return nullptr;
+    std::string directory = this->directory();
+    if (directory == "") {
+      _PendingKey.clear();
+      return nullptr;
+    }
+    auto cached = llvm::MemoryBuffer::getFile(this->pathFor(directory, _PendingKey), false, false);
+    if (!cached) {
+      this->_Misses++;
+      return nullptr;
+    }
+    _PendingKey.clear();
+    this->_Hits++;
+    // Named as SimpleCompiler names the buffers it compiles, which is what lookupObjectFile expects
+    return llvm::MemoryBuffer::getMemBufferCopy((*cached)->getBuffer(), M->getModuleIdentifier() + "-jitted-objectbuffer");
+  }
+
+  void notifyObjectCompiled(const llvm::Module* M, llvm::MemoryBufferRef Obj) override {
+    if (_PendingKey == "")
+      return;
+    std::string key = std::move(_PendingKey);
+    _PendingKey.clear();
+    std::string directory = this->directory();
+    if (directory == "")
+      return;
+    // Write under a private name and rename, so readers never see a partial file
+    std::string path = this->pathFor(directory, key);
+    std::stringstream tmp;
+    tmp << path << ".tmp" << getpid() << "-" << (uintptr_t)&_PendingKey;
+    FILE* fout = fopen(tmp.str().c_str(), "w");
+    if (!fout)
+      return;
+    bool written = fwrite(Obj.getBufferStart(), Obj.getBufferSize(), 1, fout) == 1;
+    written = (fclose(fout) == 0) && written;
+    if (written && rename(tmp.str().c_str(), path.c_str()) == 0)
+      this->_Stores++;
+    else
+      unlink(tmp.str().c_str());
+  }
+};
+
+thread_local std::string ClaspObjectCache::_PendingKey;
+
+static ClaspObjectCache global_object_cache;
+
+static void restore_cached_names(jitlink::LinkGraph& G) { global_object_cache.restoreNames(G); }
+
+// Compiles like ConcurrentIRCompiler, with the object cache, after letting
+// the cache canonicalize the module.
+class ClaspIRCompiler : public IRCompileLayer::IRCompiler {
+  ConcurrentIRCompiler _Compiler;
+
+public:
+  ClaspIRCompiler(JITTargetMachineBuilder JTMB)
+      : IRCompiler(irManglingOptionsFromTargetOptions(JTMB.getOptions())), _Compiler(std::move(JTMB), &global_object_cache){};
+  Expected<std::unique_ptr<llvm::MemoryBuffer>> operator()(llvm::Module& M) override {
+    global_object_cache.prepareModule(M);
+    return this->_Compiler(M);
+  }
+};
+
+// Everything besides the IR that determines the object file
+static std::string object_cache_settings(JITTargetMachineBuilder& JTMB) {
+  stringstream ss;
+  ss << JTMB.getTargetTriple().str() << " " << JTMB.getCPU() << " " << JTMB.getFeatures().getString();
+  ss << " opt" << (int)JTMB.getCodeGenOptLevel() << " llvm" << LLVM_VERSION_STRING << " clasp" << CLASP_VERSION;
+  // Code calls into this executable, so a rebuild must not reuse the cache
+  static int anchor;
+  std::string exe = llvm::sys::fs::getMainExecutable(NULL, (void*)&anchor);
+  llvm::sys::fs::file_status status;
+  if (!llvm::sys::fs::status(exe, status)) {
+    ss << " " << exe << " " << status.getSize() << " "
+       << std::chrono::duration_cast<std::chrono::nanoseconds>(status.getLastModificationTime().time_since_epoch()).count();
+  }
+  return ss.str();
+}
+
+CL_DOCSTRING(R"dx(Return the directory of the JIT object cache, or NIL if it is off.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_sp llvm_sys__jit_object_cache_directory() {
+  std::string directory = global_object_cache.directory();
+  if (directory == "")
+    return nil<core::T_O>();
+  return core::SimpleBaseString_O::make(directory);
+}
+
+CL_LAMBDA(directory);
+CL_DOCSTRING(R"dx(Keep the object files compiled by the JIT in DIRECTORY, a pathname designator, and reuse them
+when the same module is compiled again, in this or any other process. NIL turns the cache off.
+The CLASP_JIT_CACHE_DIR environment variable sets it at startup.)dx");
+DOCGROUP(clasp);
+CL_DEFUN void llvm_sys__set_jit_object_cache_directory(core::T_sp directory) {
+  if (directory.nilp()) {
+    global_object_cache.setDirectory("");
+    return;
+  }
+  core::String_sp name = gc::As<core::String_sp>(core::cl__namestring(directory));
+  global_object_cache.setDirectory(name->get_std_string());
+}
+
+CL_DOCSTRING(R"dx(Return the number of hits, misses and stores of the JIT object cache as three values.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_mv llvm_sys__jit_object_cache_statistics() {
+  return Values(core::make_fixnum(global_object_cache._Hits.load()), core::make_fixnum(global_object_cache._Misses.load()),
+                core::make_fixnum(global_object_cache._Stores.load()));
 }
 
 ClaspJIT_O::ClaspJIT_O(bool loading, JITDylib_O* mainJITDylib) {
@@ -711,12 +1074,25 @@ ClaspJIT_O::ClaspJIT_O(bool loading, JITDylib_O* mainJITDylib) {
   JTMB.setOptions(to);
   JTMB.setCodeModel(CodeModel::Small);
   JTMB.setRelocationModel(Reloc::Model::PIC_);
-  auto TPC = ExitOnErr(orc::SelfExecutorProcessControl::Create(std::make_shared<orc::SymbolStringPool>()));
+  global_object_cache._Settings = object_cache_settings(JTMB);
+  if (const char* cacheDir = getenv("CLASP_JIT_CACHE_DIR"))
+    global_object_cache.setDirectory(cacheDir);
+#if defined(_TARGET_OS_LINUX)
+  if (getenv("CLASP_JITDUMP"))
+    jitdump_start(getenv("JITDUMPDIR") ? getenv("JITDUMPDIR") : "/tmp");
+#endif
+  auto dispatcher = std::make_unique<ClaspTaskDispatcher>();
+  global_jit_dispatcher = dispatcher.get();
+  auto TPC = ExitOnErr(orc::SelfExecutorProcessControl::Create(std::make_shared<orc::SymbolStringPool>(), std::move(dispatcher)));
   auto J = ExitOnErr(
       LLJITBuilder()
           .setExecutionSession(std::make_unique<ExecutionSession>(std::move(TPC)))
-          .setNumCompileThreads(0) // <<<<<<< In May 2021 a path will open to use multicores for LLJIT.
           .setJITTargetMachineBuilder(std::move(JTMB))
+          // Modules are compiled concurrently, by the threads that look them up or by the
+          // jit-serve-tasks processes, so each compile needs its own TargetMachine.
+          .setCompileFunctionCreator([](JITTargetMachineBuilder JTMB) -> Expected<std::unique_ptr<IRCompileLayer::IRCompiler>> {
+            return std::make_unique<ClaspIRCompiler>(std::move(JTMB));
+          })
           .setObjectLinkingLayerCreator([this, &ExitOnErr](ExecutionSession& ES, const Triple& TT) {
             auto ObjLinkingLayer = std::make_unique<ObjectLinkingLayer>(ES, std::make_unique<ClaspAllocator>());
             ObjLinkingLayer->addPlugin(
@@ -761,10 +1137,10 @@ ClaspJIT_O::ClaspJIT_O(bool loading, JITDylib_O* mainJITDylib) {
   }
   this->_LLJIT->getMainJITDylib().addGenerator(
       llvm::cantFail(DynamicLibrarySearchGenerator::GetForCurrentProcess(this->_LLJIT->getDataLayout().getGlobalPrefix())));
-  llvm_sys__create_lljit_thread_pool();
 }
 
 ClaspJIT_O::~ClaspJIT_O() {
+  global_jit_dispatcher = NULL;
   // Remove all the CodeBlocks
 #if 0
   _lisp->_Roots._AllCodeBlocks.store(nil<core::T_O>());
@@ -804,6 +1180,33 @@ bool ClaspJIT_O::do_lookup(JITDylib_sp dylibsp, const std::string& Name, void*&
   return true;
 }
 
+void ClaspJIT_O::lookup_all(JITDylib_sp dylibsp, const std::vector<std::string>& names, std::vector<void*>& pointers) {
+  JITDylib& dylib = *dylibsp->wrappedPtr();
+  SymbolLookupSet symbols;
+  std::vector<SymbolStringPtr> mangled;
+  for (auto& name : names) {
+    mangled.push_back(this->_LLJIT->mangleAndIntern(name));
+    symbols.add(mangled.back());
+  }
+  // One query for all of the symbols, so ORC dispatches the materialization of
+  // every object file that defines them at once rather than one after another.
+  auto result = this->_LLJIT->getExecutionSession().lookup(makeJITDylibSearchOrder(&dylib), std::move(symbols));
+  if (!result) {
+    std::string message;
+    llvm::raw_string_ostream ss(message);
+    ss << result.takeError();
+    SIMPLE_ERROR("Could not look up {} symbols in {}: {}", names.size(), dylib.getName(), ss.str());
+  }
+  pointers.clear();
+  for (auto& sym : mangled) {
+#if LLVM_VERSION_MAJOR < 17
+    pointers.push_back((void*)(*result)[sym].getAddress());
+#else
+    pointers.push_back((void*)(*result)[sym].getAddress().getValue());
+#endif
+  }
+}
+
 CL_DEFMETHOD core::Pointer_sp ClaspJIT_O::lookup(JITDylib_sp dylibsp, const std::string& Name) {
   void* ptr;
   bool found = this->do_lookup(dylibsp, Name, ptr);
@@ -844,6 +1247,7 @@ CL_DEFMETHOD ObjectFile_sp ClaspJIT_O::addIRModule(JITDylib_sp dylib, Module_sp
   std::string prefix;
   std::string futureName = createIRModuleObjectFileName(startupID, prefix);
   module->wrappedPtr()->setModuleIdentifier(prefix);
+  global_object_cache.noteModule(*umodule, startupID);
   ObjectFile_sp codeObject = prepareObjectFileForMaterialization(dylib, futureName, startupID);
   ExitOnErr(
       this->_LLJIT->addIRModule(*dylib->wrappedPtr(), llvm::orc::ThreadSafeModule(std::move(umodule), *context->wrappedPtr())));
@@ -878,6 +1282,10 @@ void* ClaspJIT_O::runStartupCode(JITDylib_sp dylibsp, const std::string& startup
   if (!found) {
     SIMPLE_ERROR("Could not find function {} - exit program and look at llvm::errs() stream", startupName);
   }
+  return this->runStartupFunction(ptr, initialDataOrUnbound);
+}
+
+void* ClaspJIT_O::runStartupFunction(void* ptr, core::T_sp initialDataOrUnbound) {
   T_OStartUp startup = reinterpret_cast<T_OStartUp>(ptr);
   //    printf("%s:%d:%s About to invoke startup @p=%p\n", __FILE__, __LINE__, __FUNCTION__, (void*)startup);
   DEBUG_OBJECT_FILES_PRINT(("%s:%d:%s About to invoke startup @p=%p initialDataOrUnbound = %s\n", __FILE__, __LINE__, __FUNCTION__,
@@ -966,6 +1374,8 @@ void ClaspReturnObjectBuffer(std::unique_ptr<llvm::MemoryBuffer> buffer) {
   printf("%s:%d:%s Add support to set _TextSectionID for this os\n", __FILE__, __LINE__, __FUNCTION__);
 #endif
   DEBUG_OBJECT_FILES_PRINT(("%s:%d:%s MemoryBuffer is %p\n", __FILE__, __LINE__, __FUNCTION__, code->_MemoryBuffer.get()));
+  if (global_jitdump.load(std::memory_order_relaxed))
+    jitdump_object_file(code, of);
 }
 
 void ClaspJIT_O::registerJITDylibAfterLoad(JITDylib_O* jitDylib) {
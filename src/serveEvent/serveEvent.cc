@@ -27,6 +27,9 @@ THE SOFTWARE.
 
 #include <errno.h>
 #include <sys/select.h>
+#ifdef _TARGET_OS_LINUX
+#include <sys/epoll.h>
+#endif
 #include <clasp/core/foundation.h>
 #include <clasp/core/object.h>
 #include <clasp/core/fli.h>
@@ -73,9 +76,112 @@ CL_DEFUN core::Integer_mv serve_event_internal__ll_serveEventWithTimeout(clasp_f
   return Values(Integer_O::create(selectRet), Integer_O::create((gc::Fixnum)errno));
 }
 
+//
+// epoll backend
+//
+// The epoll descriptor keeps the registered descriptors across calls so a wait
+// costs O(ready) rather than O(registered) and is not limited to FD_SETSIZE.
+// The event buffer is a foreign array of struct epoll_event allocated by the caller,
+// data.fd of each event holds the descriptor it was registered for.
+//
+
+DOCGROUP(clasp);
+CL_DEFUN bool serve_event_internal__ll_epoll_available_p() {
+#ifdef _TARGET_OS_LINUX
+  return true;
+#else
+  return false;
+#endif
+}
+
+DOCGROUP(clasp);
+CL_DEFUN core::Integer_mv serve_event_internal__ll_epoll_create() {
+#ifdef _TARGET_OS_LINUX
+  gc::Fixnum epfd = epoll_create1(EPOLL_CLOEXEC);
+  return Values(Integer_O::create(epfd), Integer_O::create((gc::Fixnum)errno));
+#else
+  SIMPLE_ERROR("epoll is not available on this platform");
+#endif
+}
+
+DOCGROUP(clasp);
+CL_DEFUN core::Integer_mv serve_event_internal__ll_epoll_ctl(int epfd, int op, int fd, int events) {
+#ifdef _TARGET_OS_LINUX
+  struct epoll_event event;
+  event.events = events;
+  event.data.u64 = 0;
+  event.data.fd = fd;
+  gc::Fixnum ret = epoll_ctl(epfd, op, fd, &event);
+  return Values(Integer_O::create(ret), Integer_O::create((gc::Fixnum)errno));
+#else
+  SIMPLE_ERROR("epoll is not available on this platform");
+#endif
+}
+
+DOCGROUP(clasp);
+CL_DEFUN int serve_event_internal__ll_epoll_event_size() {
+#ifdef _TARGET_OS_LINUX
+  return sizeof(struct epoll_event);
+#else
+  return 0;
+#endif
+}
+
+DOCGROUP(clasp);
+CL_DEFUN core::Integer_mv serve_event_internal__ll_epoll_wait(int epfd, clasp_ffi::ForeignData_sp events, int maxevents,
+                                                              int milliseconds) {
+#ifdef _TARGET_OS_LINUX
+  if (maxevents <= 0 || events->foreign_data_size() < maxevents * sizeof(struct epoll_event)) {
+    SIMPLE_ERROR("The epoll event buffer is too small for {} events", maxevents);
+  }
+  gc::Fixnum ret = epoll_wait(epfd, events->data<struct epoll_event*>(), maxevents, milliseconds);
+  return Values(Integer_O::create(ret), Integer_O::create((gc::Fixnum)errno));
+#else
+  SIMPLE_ERROR("epoll is not available on this platform");
+#endif
+}
+
+DOCGROUP(clasp);
+CL_DEFUN core::Integer_mv serve_event_internal__ll_epoll_event_ref(clasp_ffi::ForeignData_sp events, int index) {
+#ifdef _TARGET_OS_LINUX
+  struct epoll_event* event = events->data<struct epoll_event*>() + index;
+  return Values(Integer_O::create((gc::Fixnum)event->data.fd), Integer_O::create((gc::Fixnum)event->events));
+#else
+  SIMPLE_ERROR("epoll is not available on this platform");
+#endif
+}
+
 void initialize_serveEvent_globals() {
   SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_EINTR_PLUS_);
   _sym__PLUS_EINTR_PLUS_->defconstant(Integer_O::create((gc::Fixnum)EINTR));
+  SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_EPERM_PLUS_);
+  _sym__PLUS_EPERM_PLUS_->defconstant(Integer_O::create((gc::Fixnum)EPERM));
+  SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_ENOENT_PLUS_);
+  _sym__PLUS_ENOENT_PLUS_->defconstant(Integer_O::create((gc::Fixnum)ENOENT));
+  SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_EEXIST_PLUS_);
+  _sym__PLUS_EEXIST_PLUS_->defconstant(Integer_O::create((gc::Fixnum)EEXIST));
+#ifdef _TARGET_OS_LINUX
+#define EPOLL_CONSTANT(name) (gc::Fixnum)(name)
+#else
+#define EPOLL_CONSTANT(name) (gc::Fixnum)0
+#endif
+  SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_EPOLLIN_PLUS_);
+  _sym__PLUS_EPOLLIN_PLUS_->defconstant(Integer_O::create(EPOLL_CONSTANT(EPOLLIN)));
+  SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_EPOLLOUT_PLUS_);
+  _sym__PLUS_EPOLLOUT_PLUS_->defconstant(Integer_O::create(EPOLL_CONSTANT(EPOLLOUT)));
+  SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_EPOLLERR_PLUS_);
+  _sym__PLUS_EPOLLERR_PLUS_->defconstant(Integer_O::create(EPOLL_CONSTANT(EPOLLERR)));
+  SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_EPOLLHUP_PLUS_);
+  _sym__PLUS_EPOLLHUP_PLUS_->defconstant(Integer_O::create(EPOLL_CONSTANT(EPOLLHUP)));
+  SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_EPOLLET_PLUS_);
+  _sym__PLUS_EPOLLET_PLUS_->defconstant(Integer_O::create(EPOLL_CONSTANT(EPOLLET)));
+  SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_EPOLL_CTL_ADD_PLUS_);
+  _sym__PLUS_EPOLL_CTL_ADD_PLUS_->defconstant(Integer_O::create(EPOLL_CONSTANT(EPOLL_CTL_ADD)));
+  SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_EPOLL_CTL_MOD_PLUS_);
+  _sym__PLUS_EPOLL_CTL_MOD_PLUS_->defconstant(Integer_O::create(EPOLL_CONSTANT(EPOLL_CTL_MOD)));
+  SYMBOL_EXPORT_SC_(ServeEventPkg, _PLUS_EPOLL_CTL_DEL_PLUS_);
+  _sym__PLUS_EPOLL_CTL_DEL_PLUS_->defconstant(Integer_O::create(EPOLL_CONSTANT(EPOLL_CTL_DEL)));
+#undef EPOLL_CONSTANT
 };
 
 SYMBOL_EXPORT_SC_(ServeEventPkg, ll_fd_zero);
@@ -84,5 +190,11 @@ SYMBOL_EXPORT_SC_(ServeEventPkg, ll_fd_isset);
 SYMBOL_EXPORT_SC_(ServeEventPkg, ll_fdset_size);
 SYMBOL_EXPORT_SC_(ServeEventPkg, ll_serveEventNoTimeout);
 SYMBOL_EXPORT_SC_(ServeEventPkg, ll_serveEventWithTimeout);
+SYMBOL_EXPORT_SC_(ServeEventPkg, ll_epoll_available_p);
+SYMBOL_EXPORT_SC_(ServeEventPkg, ll_epoll_create);
+SYMBOL_EXPORT_SC_(ServeEventPkg, ll_epoll_ctl);
+SYMBOL_EXPORT_SC_(ServeEventPkg, ll_epoll_event_size);
+SYMBOL_EXPORT_SC_(ServeEventPkg, ll_epoll_wait);
+SYMBOL_EXPORT_SC_(ServeEventPkg, ll_epoll_event_ref);
 
 }; // namespace serveEvent
@@ -29,6 +29,7 @@ THE SOFTWARE.
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/time.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #ifndef NETDB_INTERNAL
 #define NETDB_INTERNAL (-1)
@@ -57,6 +58,7 @@ THE SOFTWARE.
 #include <clasp/core/foundation.h>
 #include <clasp/core/object.h>
 #include <clasp/core/array.h>
+#include <clasp/core/sequence.h>
 #include <clasp/core/symbolTable.h>
 #include <clasp/core/lispStream.h>
 #include <clasp/core/evaluator.h>
@@ -490,6 +492,179 @@ CL_DEFUN core::Integer_sp sockets_internal__ll_socketSendNoAddress(int fb,
   return core::Integer_O::create((gc::Fixnum)(len));
 }
 
+//
+// Scatter/gather and batched datagram I/O.
+// The buffers are passed as a list of (unsigned-byte 8) vectors that must not be
+// moved by the GC (see sys:make-static-vector) - the kernel reads and writes them in place.
+//
+
+static size_t fill_iovecs(core::List_sp buffers, core::T_sp lengths, std::vector<struct iovec>& iovecs) {
+  iovecs.resize(core::cl__length(buffers));
+  size_t idx = 0;
+  for (auto cur : buffers) {
+    core::SimpleVector_byte8_t_sp octets = gc::As<core::SimpleVector_byte8_t_sp>(CONS_CAR(cur));
+    size_t len = octets->length();
+    if (lengths.notnilp()) {
+      size_t requested = core::clasp_to_size_t(gc::As<core::Vector_sp>(lengths)->rowMajorAref(idx));
+      if (requested > len) {
+        SIMPLE_ERROR("Length {} is larger than the buffer {}", requested, _rep_(octets));
+      }
+      len = requested;
+    }
+    iovecs[idx].iov_base = octets->rowMajorAddressOfElement_(0);
+    iovecs[idx].iov_len = len;
+    idx++;
+  }
+  return idx;
+}
+
+static core::T_sp inet_address_list(struct sockaddr_in* name) {
+  uint32_t ip = ntohl(name->sin_addr.s_addr);
+  uint16_t port = ntohs(name->sin_port);
+  core::Vector_sp vector = gc::As<core::Vector_sp>(core::eval::funcall(cl::_sym_makeArray, core::make_fixnum(4)));
+  vector->rowMajorAset(0, core::make_fixnum(ip >> 24));
+  vector->rowMajorAset(1, core::make_fixnum((ip >> 16) & 0xFF));
+  vector->rowMajorAset(2, core::make_fixnum((ip >> 8) & 0xFF));
+  vector->rowMajorAset(3, core::make_fixnum(ip & 0xFF));
+  return core::Cons_O::createList(vector, core::make_fixnum(port));
+}
+
+CL_LAMBDA(fd buffers);
+CL_DECLARE();
+CL_DOCSTRING(R"dx(Read from fd into the list of octet vectors buffers with readv(2).
+Return the number of octets read (or -1) and errno.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_mv sockets_internal__ll_socketReadv(int fd, core::List_sp buffers) {
+  std::vector<struct iovec> iovecs;
+  size_t count = fill_iovecs(buffers, nil<core::T_O>(), iovecs);
+  clasp_disable_interrupts();
+  ssize_t len = readv(fd, iovecs.data(), count);
+  int saved_errno = errno;
+  clasp_enable_interrupts();
+  return Values(core::make_fixnum(len), core::make_fixnum(saved_errno));
+}
+
+CL_LAMBDA(fd buffers lengths);
+CL_DECLARE();
+CL_DOCSTRING(R"dx(Write the list of octet vectors buffers to fd with writev(2).
+If lengths is not NIL it is a vector with the number of octets to write from each buffer.
+Return the number of octets written (or -1) and errno.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_mv sockets_internal__ll_socketWritev(int fd, core::List_sp buffers, core::T_sp lengths) {
+  std::vector<struct iovec> iovecs;
+  size_t count = fill_iovecs(buffers, lengths, iovecs);
+  clasp_disable_interrupts();
+  ssize_t len = writev(fd, iovecs.data(), count);
+  int saved_errno = errno;
+  clasp_enable_interrupts();
+  return Values(core::make_fixnum(len), core::make_fixnum(saved_errno));
+}
+
+CL_LAMBDA(fd buffers lengths addresses dontwait);
+CL_DECLARE();
+CL_DOCSTRING(R"dx(Receive up to one datagram into each of the octet vectors in the list buffers,
+with recvmmsg(2) where it is available.  The size of each datagram is stored into the
+vector lengths and, if addresses is not NIL, the (ip-vector port) of its sender into addresses.
+Return the number of datagrams received (or -1) and errno.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_mv sockets_internal__ll_socketReceiveMessages(int fd, core::List_sp buffers, core::Vector_sp lengths,
+                                                               core::T_sp addresses, bool dontwait) {
+  std::vector<struct iovec> iovecs;
+  size_t count = fill_iovecs(buffers, nil<core::T_O>(), iovecs);
+  if (lengths->length() < count || (addresses.notnilp() && gc::As<core::Vector_sp>(addresses)->length() < count)) {
+    SIMPLE_ERROR("There must be a length and address slot for each of the {} buffers", count);
+  }
+  std::vector<struct sockaddr_in> names(count);
+  ssize_t received = 0;
+  clasp_disable_interrupts();
+#ifdef _TARGET_OS_LINUX
+  std::vector<struct mmsghdr> messages(count);
+  for (size_t idx = 0; idx < count; idx++) {
+    bzero(&messages[idx], sizeof(struct mmsghdr));
+    messages[idx].msg_hdr.msg_iov = &iovecs[idx];
+    messages[idx].msg_hdr.msg_iovlen = 1;
+    messages[idx].msg_hdr.msg_name = &names[idx];
+    messages[idx].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+  }
+  received = recvmmsg(fd, messages.data(), count, dontwait ? MSG_DONTWAIT : MSG_WAITFORONE, NULL);
+  for (ssize_t idx = 0; idx < received; idx++)
+    iovecs[idx].iov_len = messages[idx].msg_len;
+#else
+  // Only the first receive may block
+  for (; received < (ssize_t)count; received++) {
+    socklen_t addr_len = (socklen_t)sizeof(struct sockaddr_in);
+    ssize_t len = recvfrom(fd, iovecs[received].iov_base, iovecs[received].iov_len,
+                           (dontwait || received > 0) ? MSG_DONTWAIT : 0, (struct sockaddr*)&names[received], &addr_len);
+    if (len < 0) {
+      if (received == 0)
+        received = -1;
+      break;
+    }
+    iovecs[received].iov_len = len;
+  }
+#endif
+  int saved_errno = errno;
+  clasp_enable_interrupts();
+  for (ssize_t idx = 0; idx < received; idx++) {
+    lengths->rowMajorAset(idx, core::make_fixnum(iovecs[idx].iov_len));
+    if (addresses.notnilp())
+      gc::As<core::Vector_sp>(addresses)->rowMajorAset(idx, inet_address_list(&names[idx]));
+  }
+  return Values(core::make_fixnum(received), core::make_fixnum(saved_errno));
+}
+
+CL_LAMBDA(fd buffers lengths address-p port ip0 ip1 ip2 ip3 dontwait nosignal);
+CL_DECLARE();
+CL_DOCSTRING(R"dx(Send each of the octet vectors in the list buffers as one datagram,
+with sendmmsg(2) where it is available.  If lengths is not NIL it is a vector with the
+number of octets to send from each buffer.  If address-p is true the datagrams are sent
+to ip0.ip1.ip2.ip3:port.  Return the number of datagrams sent (or -1) and errno.)dx");
+DOCGROUP(clasp);
+CL_DEFUN core::T_mv sockets_internal__ll_socketSendMessages(int fd, core::List_sp buffers, core::T_sp lengths, bool addressp,
+                                                            int port, int ip0, int ip1, int ip2, int ip3, bool dontwait,
+                                                            bool nosignal) {
+  std::vector<struct iovec> iovecs;
+  size_t count = fill_iovecs(buffers, lengths, iovecs);
+  struct sockaddr_in sockaddr;
+  if (addressp)
+    fill_inet_sockaddr(&sockaddr, port, ip0, ip1, ip2, ip3);
+  int flags = (dontwait ? MSG_DONTWAIT : 0) | (nosignal ? MSG_NOSIGNAL : 0);
+  ssize_t sent = 0;
+  clasp_disable_interrupts();
+#if (MSG_NOSIGNAL == 0) && defined(SO_NOSIGPIPE)
+  {
+    int sockopt = nosignal;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, REINTERPRET_CAST(char*, &sockopt), sizeof(int));
+  }
+#endif
+#ifdef _TARGET_OS_LINUX
+  std::vector<struct mmsghdr> messages(count);
+  for (size_t idx = 0; idx < count; idx++) {
+    bzero(&messages[idx], sizeof(struct mmsghdr));
+    messages[idx].msg_hdr.msg_iov = &iovecs[idx];
+    messages[idx].msg_hdr.msg_iovlen = 1;
+    if (addressp) {
+      messages[idx].msg_hdr.msg_name = &sockaddr;
+      messages[idx].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+    }
+  }
+  sent = sendmmsg(fd, messages.data(), count, flags);
+#else
+  for (; sent < (ssize_t)count; sent++) {
+    ssize_t len = sendto(fd, iovecs[sent].iov_base, iovecs[sent].iov_len, flags, addressp ? (struct sockaddr*)&sockaddr : NULL,
+                         addressp ? sizeof(struct sockaddr_in) : 0);
+    if (len < 0) {
+      if (sent == 0)
+        sent = -1;
+      break;
+    }
+  }
+#endif
+  int saved_errno = errno;
+  clasp_enable_interrupts();
+  return Values(core::make_fixnum(sent), core::make_fixnum(saved_errno));
+}
+
 CL_LAMBDA(fd name family);
 CL_DECLARE();
 CL_DOCSTRING(R"dx(ll_socketBind_localSocket)dx");
@@ -929,6 +1104,10 @@ SYMBOL_EXPORT_SC_(SocketsPkg, ll_socketPeername_inetSocket);
 SYMBOL_EXPORT_SC_(SocketsPkg, ll_socketName);
 SYMBOL_EXPORT_SC_(SocketsPkg, ll_socketSendAddress);
 SYMBOL_EXPORT_SC_(SocketsPkg, ll_socketSendNoAddress);
+SYMBOL_EXPORT_SC_(SocketsPkg, ll_socketReadv);
+SYMBOL_EXPORT_SC_(SocketsPkg, ll_socketWritev);
+SYMBOL_EXPORT_SC_(SocketsPkg, ll_socketReceiveMessages);
+SYMBOL_EXPORT_SC_(SocketsPkg, ll_socketSendMessages);
 SYMBOL_EXPORT_SC_(SocketsPkg, ll_socketBind_localSocket);
 SYMBOL_EXPORT_SC_(SocketsPkg, ll_socketAccept_localSocket);
 SYMBOL_EXPORT_SC_(SocketsPkg, ll_socketConnect_localSocket);